@@ -60,6 +60,7 @@ enum ErrNo {
     E_MTP_PREPARE_DIR_ERR,
     E_MTP_MOUNT_FAILED,
     E_MTP_UMOUNT_FAILED,
+    E_TIMEOUT,
 };
 
 enum JsErrCode {
@@ -23,6 +23,7 @@
 
 #include "file_ex.h"
 #include "key_backup.h"
+#include "key_cache_evictor.h"
 #include "libfscrypt/key_control.h"
 #include "storage_service_log.h"
 
@@ -398,20 +399,10 @@ bool FscryptKeyV1::InactiveKey(uint32_t flag, const std::string &mnt)
 
 void FscryptKeyV1::DropCachesIfNeed()
 {
-    DIR *dir = opendir(MNT_DATA.c_str());
-    if (dir == nullptr) {
-        sync();
-    }
-    int fd = dirfd(dir);
-    if (fd < 0 || syncfs(fd)) {
-        sync();
-    }
-    LOGI("drop cache start.");
-    if (!SaveStringToFile("/proc/sys/vm/drop_caches", "2")) {
-        LOGE("Failed to drop cache during key eviction");
-    }
-    (void)closedir(dir);
-    LOGI("drop cache success");
+    // the cached dentries and inodes keep plaintext names and the key usable, they are dropped for every key
+    KeyCacheEvictor evictor("user " + std::to_string(fscryptV1Ext.GetUserId()));
+    evictor.Evict(MNT_DATA);
+    evictor.Report();
 }
 
 bool FscryptKeyV1::LockUserScreen(uint32_t flag, uint32_t sdpClass, const std::string &mnt)
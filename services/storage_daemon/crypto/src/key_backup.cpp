@@ -15,10 +15,13 @@
 
 #include "key_backup.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <dirent.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <vector>
 
 #include "securec.h"
 #include "storage_service_log.h"
@@ -29,13 +32,9 @@ namespace StorageDaemon {
 const uint32_t INVALID_LOOP_NUM = 0xFFFFFFFF;
 const uint8_t BACK_MAX_RETRY_TIME = 3;
 const uint16_t BACK_RETRY_INTERVAL_MS = 50 * 1000;
-
-struct FileNode {
-    std::string baseName;
-    std::string origFile;
-    std::string backFile;
-    bool isSame;
-};
+const uint32_t ALL_PERMS = (S_ISUID | S_ISGID | S_ISVTX | S_IRWXU | S_IRWXG | S_IRWXO);
+const uint32_t MAX_SYNC_DEPTH = 16;
+const std::string SYNC_TEMP_SUFFIX = ".sync_tmp";
 
 void KeyBackup::CreateBackup(const std::string &from, const std::string &to, bool removeOld)
 {
@@ -59,8 +58,12 @@ void KeyBackup::CreateBackup(const std::string &from, const std::string &to, boo
         }
     }
 
+    // every dir whose entries change is synced by the copy itself
     CheckAndCopyFiles(from, to);
-    FsyncDirectory(to);
+    std::string::size_type pos = to.find_last_of('/');
+    if (pos != std::string::npos && pos > 0) {
+        FsyncDirectory(to.substr(0, pos));
+    }
 }
 
 int32_t KeyBackup::RemoveNode(const std::string &pathName)
@@ -129,6 +132,11 @@ int32_t KeyBackup::TryRestoreKey(const std::shared_ptr<BaseKey> &baseKey, const
     }
 
     LOGE("origKey failed, backupKey failed, so mix key");
+    std::shared_ptr<BaseKey> mixKey = baseKey;
+    if (DoResotreKeyMix(mixKey, auth, keyDir, backupDir) == 0) {
+        LOGI("Restore by mix key success !");
+        return 0;
+    }
     return -1;
 }
 
@@ -216,40 +224,56 @@ int32_t KeyBackup::DoResotreKeyMix(std::shared_ptr<BaseKey> &baseKey, const User
         LOGE("get file list failed or diffNum too least, ret: %d, diffNum: %d", ret, diffNum);
         return -1;
     }
+    bool hasOneSide = std::any_of(fileList.begin(), fileList.end(), [](const struct FileNode &node) {
+        return !node.isSame && (node.origFile.empty() || node.backFile.empty());
+    });
 
     std::string tempKeyDir;
     ret = CopySameFilesToTempDir(backupKeyDir, tempKeyDir, fileList);
     if (ret != 0) {
-        return false;
+        return -1;
     }
-
-    diffNum = fileList.size();
-    uint32_t loopNum = GetLoopMaxNum(diffNum);
+    size_t mixNum = fileList.size();
+    if (LoadMixFiles(tempKeyDir, fileList) != 0) {
+        RemoveNode(tempKeyDir);
+        return -1;
+    }
+    uint32_t loopNum = GetLoopMaxNum(fileList.size());
     if (loopNum == INVALID_LOOP_NUM) {
         RemoveNode(tempKeyDir);
         return -1;
     }
-    for (uint32_t i = 0; i <= loopNum; i++) {
-        LOGI("try mix key files to decrypt i: %d loopNum: %d", i, loopNum);
-        ret = CopyMixFilesToTempDir(diffNum, i, tempKeyDir, fileList);
-        if (ret != 0) {
-            LOGE("copy mix files to temp dir failed");
+
+    // the all orig and all backup combinations are what was tried before, unless a file was fixed up
+    bool skipTried = !hasOneSide && fileList.size() == mixNum;
+    uint32_t allBack = loopNum;
+    std::vector<int32_t> written(fileList.size(), -1);
+    uint32_t attempts = 0;
+    for (uint32_t mask : GetMixOrder(fileList)) {
+        if (skipTried && (mask == 0 || mask == allBack)) {
             continue;
         }
+        if (WriteMixFilesToTempDir(mask, tempKeyDir, fileList, written) != 0) {
+            LOGE("write mix files to temp dir failed");
+            continue;
+        }
+        attempts++;
+        LOGI("try mix key files to decrypt mask: %d attempt: %d", mask, attempts);
         if (baseKey->DoRestoreKeyEx(auth, tempKeyDir)) {
-            LOGI("mix key files descrpt succ, fix orig and backup");
+            LOGI("mix key files descrpt succ after %d attempts, fix orig and backup", attempts);
             CheckAndFixFiles(tempKeyDir, origKeyDir);
             CheckAndFixFiles(tempKeyDir, backupKeyDir);
             RemoveNode(tempKeyDir);
-            return true;
+            return 0;
         }
     }
+    LOGE("mix key files descrpt failed after %d attempts", attempts);
     RemoveNode(tempKeyDir);
     return -1;
 }
 
 int32_t KeyBackup::GetFileList(const std::string &origDir, const std::string &backDir,
-    std::vector<struct FileNode> &fileList, uint32_t diffNum)
+    std::vector<struct FileNode> &fileList, uint32_t &diffNum)
 {
     LOGI("get file list origDir: %s backDir: %s", origDir.c_str(), backDir.c_str());
     DIR *dir = opendir(origDir.c_str());
@@ -298,7 +322,8 @@ bool KeyBackup::IsRegFile(const std::string &filePath)
 void KeyBackup::AddOrigFileToList(const std::string &fileName, const std::string &origDir,
     std::vector<struct FileNode> &fileList)
 {
-    if (fileName.compare("..") == 0 || fileName.compare(".") == 0) {
+    // a temp file is left behind only by a copy that did not finish
+    if (fileName.compare("..") == 0 || fileName.compare(".") == 0 || IsSyncTempName(fileName)) {
         return;
     }
 
@@ -312,6 +337,7 @@ void KeyBackup::AddOrigFileToList(const std::string &fileName, const std::string
     fl.origFile = filePath;
     fl.backFile = "";
     fl.isSame = false;
+    fl.preferBack = false;
     fileList.push_back(fl);
     return;
 }
@@ -319,7 +345,7 @@ void KeyBackup::AddOrigFileToList(const std::string &fileName, const std::string
 void KeyBackup::AddBackupFileToList(const std::string &fileName, const std::string &backDir,
     std::vector<struct FileNode> &fileList)
 {
-    if (fileName.compare("..") == 0 || fileName.compare(".") == 0) {
+    if (fileName.compare("..") == 0 || fileName.compare(".") == 0 || IsSyncTempName(fileName)) {
         return;
     }
 
@@ -343,6 +369,7 @@ void KeyBackup::AddBackupFileToList(const std::string &fileName, const std::stri
     fl.origFile = "";
     fl.backFile = filePath;
     fl.isSame = false;
+    fl.preferBack = true;
     fileList.push_back(fl);
     return;
 }
@@ -419,20 +446,104 @@ uint32_t KeyBackup::GetLoopMaxNum(uint32_t diffNum)
     return static_cast<uint32_t>(pow(fileNum, diffNum) - 1);
 }
 
-int32_t KeyBackup::CopyMixFilesToTempDir(uint32_t diffNum, uint32_t num, const std::string &tempDir,
-    const std::vector<struct FileNode> &fileList)
+bool KeyBackup::IsValidKeyFile(const std::string &baseName, const std::string &content)
 {
-    for (uint32_t i = 0; i < diffNum; i++) {
-        std::string from;
-        if (num & (1UL << i)) {
-            from = fileList[i].backFile;
-        } else {
-            from = fileList[i].origFile;
+    // a removed key file is zeroed before it is unlinked, see CleanFile
+    if (std::all_of(content.begin(), content.end(), [](char c) { return c == '\0'; })) {
+        return false;
+    }
+    std::string name = "/" + baseName;
+    if (name == PATH_SECDISC) {
+        return content.size() == CRYPTO_KEY_SECDISC_SIZE;
+    }
+    if (name == PATH_SHIELD) {
+        return content.size() <= CRYPTO_KEY_SHIELD_MAX_SIZE;
+    }
+    if (name == SUFFIX_NEED_UPDATE) {
+        return content == "KEY_CRYPT_HUKS" || content == "KEY_CRYPT_OPENSSL" || content == "KEY_CRYPT_HUKS_OPENSSL";
+    }
+    return true;
+}
+
+// Loads both copies of every different file, a file with only one valid copy is written to the temp dir
+// and removed from the list.
+int32_t KeyBackup::LoadMixFiles(const std::string &tempDir, std::vector<struct FileNode> &fileList)
+{
+    for (auto iter = fileList.begin(); iter != fileList.end();) {
+        bool origValid = ReadFileToString(iter->origFile, iter->origData) &&
+            IsValidKeyFile(iter->baseName, iter->origData);
+        bool backValid = ReadFileToString(iter->backFile, iter->backData) &&
+            IsValidKeyFile(iter->baseName, iter->backData);
+        if (!origValid && !backValid) {
+            LOGE("both copies of %s are broken", iter->baseName.c_str());
+            return -1;
+        }
+        if (origValid != backValid) {
+            LOGI("only the %s copy of %s is valid", origValid ? "orig" : "backup", iter->baseName.c_str());
+            if (WriteMixFile(origValid ? iter->origData : iter->backData, tempDir + "/" + iter->baseName) != 0) {
+                return -1;
+            }
+            iter = fileList.erase(iter);
+            continue;
         }
-        std::string to = tempDir + "/" + fileList[i].baseName;
-        if (CheckAndCopyOneFile(from, to) != 0) {
+        // the files of one key are written together, the newer copies most likely belong to each other
+        struct stat origSt;
+        struct stat backSt;
+        if (lstat(iter->origFile.c_str(), &origSt) == 0 && lstat(iter->backFile.c_str(), &backSt) == 0) {
+            iter->preferBack = (backSt.st_mtim.tv_sec > origSt.st_mtim.tv_sec) ||
+                (backSt.st_mtim.tv_sec == origSt.st_mtim.tv_sec && backSt.st_mtim.tv_nsec > origSt.st_mtim.tv_nsec);
+        }
+        ++iter;
+    }
+    return 0;
+}
+
+// Bit i of a mask takes file i from the backup. The newest copies go first, then the masks that differ from them
+// in the fewest files.
+std::vector<uint32_t> KeyBackup::GetMixOrder(const std::vector<struct FileNode> &fileList)
+{
+    uint32_t prefer = 0;
+    for (size_t i = 0; i < fileList.size(); i++) {
+        if (fileList[i].preferBack) {
+            prefer |= (1U << i);
+        }
+    }
+    std::vector<uint32_t> order;
+    for (uint32_t mask = 0; mask < (1U << fileList.size()); mask++) {
+        order.push_back(mask);
+    }
+    std::stable_sort(order.begin(), order.end(), [prefer](uint32_t a, uint32_t b) {
+        return __builtin_popcount(a ^ prefer) < __builtin_popcount(b ^ prefer);
+    });
+    return order;
+}
+
+// Only the files whose copy differs from the one in the temp dir are written.
+int32_t KeyBackup::WriteMixFilesToTempDir(uint32_t mask, const std::string &tempDir,
+    const std::vector<struct FileNode> &fileList, std::vector<int32_t> &written)
+{
+    for (size_t i = 0; i < fileList.size(); i++) {
+        int32_t side = (mask & (1U << i)) ? 1 : 0;
+        if (written[i] == side) {
+            continue;
+        }
+        written[i] = -1;
+        if (WriteMixFile(side ? fileList[i].backData : fileList[i].origData,
+            tempDir + "/" + fileList[i].baseName) != 0) {
             return -1;
         }
+        written[i] = side;
+    }
+    return 0;
+}
+
+// The temp dir only lives for the recovery, it is not synced.
+int32_t KeyBackup::WriteMixFile(const std::string &content, const std::string &path)
+{
+    UniqueFd fd(open(path.c_str(), O_WRONLY | O_CREAT | O_NOFOLLOW | O_TRUNC | O_CLOEXEC, DEFAULT_WRITE_FILE_PERM));
+    if (fd < 0 || !WriteStringToFd(fd, content)) {
+        LOGE("write file failed, %s", path.c_str());
+        return -1;
     }
     return 0;
 }
@@ -441,7 +552,6 @@ void KeyBackup::CheckAndFixFiles(const std::string &from, const std::string &to)
 {
     LOGI("check fix files from: %s to: %s", from.c_str(), to.c_str());
     CreateBackup(from, to, false);
-    FsyncDirectory(to);
 }
 
 void KeyBackup::FsyncDirectory(const std::string &dirName)
@@ -566,25 +676,180 @@ void KeyBackup::CheckAndCopyFiles(const std::string &from, const std::string &to
             }
         }
     }
-    DIR *dir = opendir(from.c_str());
-    if (dir == nullptr) {
-        LOGE("open dr failed, %s", from.c_str());
+    UniqueFd fromFd(open(from.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    UniqueFd toFd(open(to.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    if (fromFd < 0 || toFd < 0) {
+        LOGE("open dir failed, from: %s to: %s", from.c_str(), to.c_str());
         return;
     }
+    if (SyncDirAt(fromFd, toFd, from, 0) < 0) {
+        LOGE("sync dir failed, from: %s to: %s", from.c_str(), to.c_str());
+    }
+}
 
+// Returns the number of entries changed in the dir, or -1 if a file could not be copied.
+int32_t KeyBackup::SyncDirAt(int fromFd, int toFd, const std::string &from, uint32_t depth)
+{
+    int dupFd = dup(fromFd);
+    DIR *dir = (dupFd < 0) ? nullptr : fdopendir(dupFd);
+    if (dir == nullptr) {
+        LOGE("open dir failed, %s", from.c_str());
+        if (dupFd >= 0) {
+            close(dupFd);
+        }
+        return -1;
+    }
+    int32_t changed = 0;
+    bool failed = false;
+    std::vector<std::string> names;
+    std::vector<int> fds;
     struct dirent *de = nullptr;
     while ((de = readdir(dir)) != nullptr) {
-        if (strcmp(de->d_name, "..") == 0 || strcmp(de->d_name, ".") == 0) {
+        std::string name = de->d_name;
+        if (name == "." || name == ".." || IsSyncTempName(name)) {
+            continue;
+        }
+        struct stat st;
+        if (fstatat(fromFd, de->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+            LOGE("lstat file failed, %s/%s", from.c_str(), de->d_name);
             continue;
         }
-        std::string dfrom = from + "/" + de->d_name;
-        std::string dto = to + "/" + de->d_name;
-        CheckAndCopyFiles(dfrom, dto);
+        if (S_ISREG(st.st_mode)) {
+            if (CompareFileAt(fromFd, name, toFd, name) == 0) {
+                continue;
+            }
+            int fd = CopyFileToTempAt(fromFd, toFd, name, st);
+            if (fd < 0) {
+                failed = true;
+                continue;
+            }
+            names.push_back(name);
+            fds.push_back(fd);
+        } else if (S_ISDIR(st.st_mode)) {
+            int32_t ret = SyncSubDirAt(fromFd, toFd, from, name, st, depth);
+            if (ret < 0) {
+                failed = true;
+            } else {
+                changed += ret;
+            }
+        } else {
+            LOGE("file: %s/%s is not reg file or dir, skip it", from.c_str(), de->d_name);
+        }
     }
-
     if (closedir(dir) < 0) {
         LOGE("close dir failed, %s", from.c_str());
     }
+
+    int32_t committed = CommitFilesAt(toFd, from, names, fds);
+    if (committed < 0) {
+        failed = true;
+    } else {
+        changed += committed;
+    }
+    // one sync of the dir makes every rename and new sub dir in it durable
+    if (changed > 0 && fsync(toFd) == -1 && errno != EROFS && errno != EINVAL) {
+        LOGE("sync dir failed, backup of %s", from.c_str());
+    }
+    return failed ? -1 : changed;
+}
+
+// Returns 1 if the sub dir was created, 0 if it existed, or -1 on error.
+int32_t KeyBackup::SyncSubDirAt(int fromFd, int toFd, const std::string &from, const std::string &name,
+    const struct stat &st, uint32_t depth)
+{
+    if (depth >= MAX_SYNC_DEPTH) {
+        LOGE("dir %s/%s is too deep, skip it", from.c_str(), name.c_str());
+        return -1;
+    }
+    int32_t created = 1;
+    if (mkdirat(toFd, name.c_str(), DEFAULT_DIR_PERM) < 0) {
+        if (errno != EEXIST) {
+            LOGE("mkdir dir failed, backup of %s/%s", from.c_str(), name.c_str());
+            return -1;
+        }
+        created = 0;
+    }
+    UniqueFd subFromFd(openat(fromFd, name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    UniqueFd subToFd(openat(toFd, name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    if (subFromFd < 0 || subToFd < 0) {
+        LOGE("open dir failed, %s/%s", from.c_str(), name.c_str());
+        return -1;
+    }
+    if (fchown(subToFd, st.st_uid, st.st_gid) != 0 || fchmod(subToFd, st.st_mode & ALL_PERMS) != 0) {
+        LOGE("set attr failed, backup of %s/%s", from.c_str(), name.c_str());
+    }
+    if (SyncDirAt(subFromFd, subToFd, from + "/" + name, depth + 1) < 0) {
+        return -1;
+    }
+    return created;
+}
+
+// Returns the fd of the temp file holding the copy, or -1 on error.
+int KeyBackup::CopyFileToTempAt(int fromFd, int toFd, const std::string &name, const struct stat &st)
+{
+    UniqueFd srcFd(openat(fromFd, name.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+    if (srcFd < 0) {
+        LOGE("open file failed, %s", name.c_str());
+        return -1;
+    }
+    std::string tempName = name + SYNC_TEMP_SUFFIX;
+    int fd = openat(toFd, tempName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC,
+        DEFAULT_WRITE_FILE_PERM);
+    if (fd < 0) {
+        LOGE("open file failed, %s", tempName.c_str());
+        return -1;
+    }
+    char buf[COMPARE_BUF_SIZE];
+    ssize_t len;
+    bool ret = true;
+    while ((len = TEMP_FAILURE_RETRY(read(srcFd, buf, sizeof(buf)))) > 0) {
+        if (!WriteStringToFd(fd, std::string(buf, static_cast<size_t>(len)))) {
+            ret = false;
+            break;
+        }
+    }
+    if (len < 0 || !ret || fchown(fd, st.st_uid, st.st_gid) != 0 || fchmod(fd, st.st_mode & ALL_PERMS) != 0) {
+        LOGE("copy file failed, %s", name.c_str());
+        close(fd);
+        unlinkat(toFd, tempName.c_str(), 0);
+        return -1;
+    }
+    // start the write back now, the files of a dir are waited for together
+    (void)sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+    return fd;
+}
+
+// Syncs the temp files and renames them over the old ones, returns the number of files replaced or -1 on error.
+int32_t KeyBackup::CommitFilesAt(int toFd, const std::string &from, const std::vector<std::string> &names,
+    std::vector<int> &fds)
+{
+    bool failed = false;
+    int32_t committed = 0;
+    for (size_t i = 0; i < names.size(); i++) {
+        std::string tempName = names[i] + SYNC_TEMP_SUFFIX;
+        // the data reaches the disk before it replaces the old file, a crash leaves either the old or the new one
+        if (fsync(fds[i]) == -1 && errno != EROFS && errno != EINVAL) {
+            LOGE("sync failed, backup of %s/%s", from.c_str(), names[i].c_str());
+            unlinkat(toFd, tempName.c_str(), 0);
+            failed = true;
+        } else if (renameat(toFd, tempName.c_str(), toFd, names[i].c_str()) != 0) {
+            LOGE("rename failed, backup of %s/%s", from.c_str(), names[i].c_str());
+            unlinkat(toFd, tempName.c_str(), 0);
+            failed = true;
+        } else {
+            LOGI("copy from: %s/%s succ", from.c_str(), names[i].c_str());
+            committed++;
+        }
+        close(fds[i]);
+        fds[i] = -1;
+    }
+    return failed ? -1 : committed;
+}
+
+bool KeyBackup::IsSyncTempName(const std::string &name)
+{
+    return name.size() > SYNC_TEMP_SUFFIX.size() &&
+        name.compare(name.size() - SYNC_TEMP_SUFFIX.size(), SYNC_TEMP_SUFFIX.size(), SYNC_TEMP_SUFFIX) == 0;
 }
 
 int32_t KeyBackup::HandleCopyDir(const std::string &from, const std::string &to)
@@ -713,19 +978,48 @@ bool KeyBackup::WriteStringToFile(const std::string &payload, const std::string
 
 int32_t KeyBackup::CompareFile(const std::string &fileA, const std::string fileB)
 {
-    std::string dataA;
-    if (!ReadFileToString(fileA, dataA)) {
-        LOGE("failed to read from %s", fileA.c_str());
+    return CompareFileAt(AT_FDCWD, fileA, AT_FDCWD, fileB);
+}
+
+// Returns 0 if both files have the same content. The sizes are compared first, then the content chunk by chunk.
+int32_t KeyBackup::CompareFileAt(int dirA, const std::string &nameA, int dirB, const std::string &nameB)
+{
+    UniqueFd fdA(openat(dirA, nameA.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+    if (fdA < 0) {
+        LOGE("failed to read from %s", nameA.c_str());
         return -1;
     }
-
-    std::string dataB;
-    if (!ReadFileToString(fileB, dataB)) {
-        LOGE("failed to read from %s", fileB.c_str());
+    UniqueFd fdB(openat(dirB, nameB.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+    if (fdB < 0) {
         return -1;
     }
-
-    return dataA.compare(dataB);
+    struct stat stA;
+    struct stat stB;
+    if (fstat(fdA, &stA) != 0 || fstat(fdB, &stB) != 0 || !S_ISREG(stB.st_mode)) {
+        return -1;
+    }
+    if (stA.st_size != stB.st_size) {
+        return 1;
+    }
+    char bufA[COMPARE_BUF_SIZE];
+    char bufB[COMPARE_BUF_SIZE];
+    for (;;) {
+        ssize_t lenA = TEMP_FAILURE_RETRY(read(fdA, bufA, sizeof(bufA)));
+        if (lenA < 0) {
+            return -1;
+        }
+        if (lenA == 0) {
+            return 0;
+        }
+        // a short read from a regular file means it changed size
+        ssize_t lenB = TEMP_FAILURE_RETRY(read(fdB, bufB, static_cast<size_t>(lenA)));
+        if (lenB != lenA) {
+            return -1;
+        }
+        if (memcmp(bufA, bufB, static_cast<size_t>(lenA)) != 0) {
+            return 1;
+        }
+    }
 }
 
 int32_t KeyBackup::CopyRegfileData(const std::string &from, const std::string &to)
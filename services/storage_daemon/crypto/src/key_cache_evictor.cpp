@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "key_cache_evictor.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+#include "file_ex.h"
+#include "storage_service_log.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+namespace {
+const std::string PROC_MEMINFO = "/proc/meminfo";
+const std::string DROP_CACHES = "/proc/sys/vm/drop_caches";
+const std::vector<std::string> RECLAIMABLE_FIELDS = { "Cached:", "SReclaimable:" };
+
+int64_t SteadyNowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+} // namespace
+
+KeyCacheEvictor::KeyCacheEvictor(const std::string &tag) : tag_(tag)
+{
+}
+
+bool KeyCacheEvictor::Evict(const std::string &mnt)
+{
+    int64_t start = SteadyNowMs();
+    int64_t before = ReadReclaimableKb();
+    int fd = open(mnt.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("Failed to open %{public}s for key eviction, errno %{public}d", mnt.c_str(), errno);
+        stat_.costMs = SteadyNowMs() - start;
+        return false;
+    }
+    if (syncfs(fd) != 0) {
+        LOGE("Failed to syncfs %{public}s, errno %{public}d, sync all", mnt.c_str(), errno);
+        sync();
+    }
+    close(fd);
+    bool ret = SaveStringToFile(DROP_CACHES, "2");
+    if (!ret) {
+        LOGE("Failed to drop cache during key eviction");
+    }
+    stat_.freedKb = std::max<int64_t>(before - ReadReclaimableKb(), 0);
+    stat_.costMs = SteadyNowMs() - start;
+    return ret;
+}
+
+int64_t KeyCacheEvictor::ReadReclaimableKb()
+{
+    std::string content;
+    if (!LoadStringFromFile(PROC_MEMINFO, content)) {
+        return 0;
+    }
+    int64_t total = 0;
+    for (const auto &field : RECLAIMABLE_FIELDS) {
+        size_t pos = content.find("\n" + field);
+        if (pos == std::string::npos) {
+            continue;
+        }
+        total += std::strtoll(content.c_str() + pos + field.size() + 1, nullptr, 10);
+    }
+    return total;
+}
+
+void KeyCacheEvictor::Report() const
+{
+    LOGI("%{public}s evict dentry and inode caches, freed about %{public}lld KB, took %{public}lld ms",
+        tag_.c_str(), static_cast<long long>(stat_.freedKb), static_cast<long long>(stat_.costMs));
+}
+} // namespace StorageDaemon
+} // namespace OHOS
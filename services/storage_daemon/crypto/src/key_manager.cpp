@@ -15,10 +15,14 @@
 
 #include "key_manager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fcntl.h>
 #include <filesystem>
 #include <string>
 #include <cstdio>
+#include <thread>
 
 #include "base_key.h"
 #include "directory_ex.h"
@@ -46,6 +50,14 @@ namespace StorageDaemon {
 const UserAuth NULL_KEY_AUTH = {};
 const std::string DEFAULT_NEED_RESTORE_VERSION = "1";
 constexpr const char *UECE_PATH = "/dev/fbex_uece";
+// the el1 keys of the users are restored by a few threads at boot
+constexpr size_t MAX_RESTORE_THREADS = 4;
+
+static int64_t SteadyNowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 std::shared_ptr<BaseKey> KeyManager::GetBaseKey(const std::string& dir)
 {
@@ -370,6 +382,76 @@ void KeyManager::ProcUpgradeKey(const std::vector<FileList> &dirInfo)
     }
 }
 
+void KeyManager::RestoreUsersEl1Key(const std::vector<FileList> &dirInfo)
+{
+    struct RestoreTask {
+        uint32_t userId;
+        std::shared_ptr<BaseKey> elKey;
+        int ret;
+        int64_t loadMs;
+        int64_t activeMs;
+    };
+    int64_t start = SteadyNowMs();
+    std::vector<RestoreTask> tasks;
+    for (const auto &item : dirInfo) {
+        if (HasElkey(item.userId, EL1_KEY)) {
+            continue;
+        }
+        auto elKey = GetBaseKey(item.path);
+        if (elKey == nullptr) {
+            LOGE("user %{public}u el1 key restore error", item.userId);
+            continue;
+        }
+        tasks.push_back({ item.userId, elKey, 0, 0, 0 });
+    }
+
+    // the key files and the huks decrypt of different users do not depend on each other,
+    // the keys are installed into the keyring and the kernel one at a time
+    std::mutex activeMutex;
+    std::atomic<size_t> next(0);
+    auto worker = [&tasks, &activeMutex, &next]() {
+        for (size_t k = next++; k < tasks.size(); k = next++) {
+            RestoreTask &task = tasks[k];
+            int64_t begin = SteadyNowMs();
+            if (!task.elKey->InitKey(false) || !task.elKey->RestoreKey(NULL_KEY_AUTH)) {
+                LOGE("user %{public}u el1 key init or restore failed", task.userId);
+                task.ret = -EFAULT;
+                task.loadMs = SteadyNowMs() - begin;
+                continue;
+            }
+            task.loadMs = SteadyNowMs() - begin;
+            std::lock_guard<std::mutex> lock(activeMutex);
+            begin = SteadyNowMs();
+            if (!task.elKey->ActiveKey(RETRIEVE_KEY)) {
+                LOGE("user %{public}u el1 key active failed", task.userId);
+                task.ret = -EFAULT;
+            }
+            task.activeMs = SteadyNowMs() - begin;
+        }
+    };
+    size_t threadCnt = std::min(MAX_RESTORE_THREADS, tasks.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCnt; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (const auto &task : tasks) {
+        LOGI("user %{public}u el1 key restore ret %{public}d, load %{public}lld ms, active %{public}lld ms",
+            task.userId, task.ret, static_cast<long long>(task.loadMs), static_cast<long long>(task.activeMs));
+        if (task.ret != 0) {
+            LOGE("user %{public}u el1 key restore error", task.userId);
+            continue;
+        }
+        userEl1Key_[task.userId] = task.elKey;
+    }
+    LOGI("restore %{public}zu users el1 key with %{public}zu threads, took %{public}lld ms", tasks.size(),
+        threadCnt, static_cast<long long>(SteadyNowMs() - start));
+}
+
 int KeyManager::LoadAllUsersEl1Key(void)
 {
     LOGI("enter");
@@ -379,11 +461,7 @@ int KeyManager::LoadAllUsersEl1Key(void)
     dirInfo.clear();
     ReadDigitDir(USER_EL1_DIR, dirInfo);
     UpgradeKeys(dirInfo);
-    for (auto &item : dirInfo) {
-        if (RestoreUserKey(item.userId, item.path, NULL_KEY_AUTH, EL1_KEY) != 0) {
-            LOGE("user %{public}u el1 key restore error", item.userId);
-        }
-    }
+    RestoreUsersEl1Key(dirInfo);
 
     /* only for el3/el4 upgrade scene */
     dirInfo.clear();
@@ -1507,46 +1585,85 @@ int KeyManager::LockUserScreen(uint32_t user)
     return 0;
 }
 
+int KeyManager::GetPolicyHandle(const std::shared_ptr<BaseKey> &key, bool eceSece, FscryptPolicyHandle &handle)
+{
+    auto it = policyHandles_.find({ key->GetDir(), eceSece });
+    if (it != policyHandles_.end() && it->second.key.lock() == key) {
+        handle = it->second.handle;
+        return 0;
+    }
+    int ret = eceSece ? LoadEceAndSecePolicyHandle(key->GetDir().c_str(), &handle) :
+        LoadPolicyHandle(key->GetDir().c_str(), &handle);
+    if (ret != 0) {
+        LOGE("Load policy of %{public}s error, ret: %{public}d", key->GetDir().c_str(), ret);
+        return ret;
+    }
+    policyHandles_[{ key->GetDir(), eceSece }] = { key, handle };
+    return 0;
+}
+
+void KeyManager::DropPolicyHandle(const std::shared_ptr<BaseKey> &key, bool eceSece)
+{
+    // the key files may have changed under the cached policy, load them again next time
+    policyHandles_.erase({ key->GetDir(), eceSece });
+}
+
 int KeyManager::SetDirectoryElPolicy(unsigned int user, KeyType type, const std::vector<FileList> &vec)
 {
     LOGI("start");
     if (!KeyCtrlHasFscryptSyspara()) {
         return 0;
     }
-    std::string keyPath;
-    std::string eceSeceKeyPath;
+    std::shared_ptr<BaseKey> elKey;
+    std::shared_ptr<BaseKey> eceSeceKey;
     std::lock_guard<std::mutex> lock(keyMutex_);
     if (type == EL1_KEY) {
         if (userEl1Key_.find(user) == userEl1Key_.end()) {
             LOGE("Have not found user %{public}u el1 key, not enable el1", user);
             return -ENOENT;
         }
-        keyPath = userEl1Key_[user]->GetDir();
+        elKey = userEl1Key_[user];
     } else if (type == EL2_KEY || type == EL3_KEY || type == EL4_KEY || type == EL5_KEY) {
         if (userEl2Key_.find(user) == userEl2Key_.end()) {
             LOGE("Have not found user %{public}u el2 key, not enable el2", user);
             return -ENOENT;
         }
-        keyPath = userEl2Key_[user]->GetDir();
+        elKey = userEl2Key_[user];
     } else {
         LOGE("Not specify el flags, no need to crypt");
         return 0;
     }
-    if (getEceSeceKeyPath(user, type, eceSeceKeyPath) != 0) {
-        LOGE("method getEceSeceKeyPath fail");
-        return -ENOENT;
+    if (type == EL3_KEY || type == EL4_KEY) {
+        auto &userElxKey = (type == EL3_KEY) ? userEl3Key_ : userEl4Key_;
+        if (userElxKey.find(user) == userElxKey.end()) {
+            LOGE("Have not found user %{public}u ece or sece key", user);
+            return -ENOENT;
+        }
+        eceSeceKey = userElxKey[user];
+    }
+    if (vec.empty()) {
+        return 0;
+    }
+    FscryptPolicyHandle handle = {};
+    if (GetPolicyHandle(elKey, false, handle) != 0) {
+        return -EFAULT;
     }
     for (auto item : vec) {
-        int ret = LoadAndSetPolicy(keyPath.c_str(), item.path.c_str());
+        int ret = SetPolicyByHandle(&handle, item.path.c_str());
         if (ret != 0) {
             LOGE("Set directory el policy error, ret: %{public}d", ret);
+            DropPolicyHandle(elKey, false);
             return -EFAULT;
         }
     }
-    if (type == EL3_KEY || type == EL4_KEY) {
+    if (eceSeceKey != nullptr) {
+        if (GetPolicyHandle(eceSeceKey, true, handle) != 0) {
+            return -EFAULT;
+        }
         for (auto item : vec) {
-            if (LoadAndSetEceAndSecePolicy(eceSeceKeyPath.c_str(), item.path.c_str(), static_cast<int>(type)) != 0) {
+            if (SetEceAndSecePolicyByHandle(&handle, item.path.c_str(), static_cast<int>(type)) != 0) {
                 LOGE("Set directory el policy error!");
+                DropPolicyHandle(eceSeceKey, true);
                 return -EFAULT;
             }
         }
@@ -26,6 +26,7 @@
 #include "fscrypt_key_v1.h"
 #include "../mock/fscrypt_key_v1_ext_mock.h"
 #include "key_blob.h"
+#include "key_cache_evictor.h"
 #include "storage_service_errno.h"
 
 using namespace testing::ext;
@@ -380,4 +381,21 @@ HWTEST_F(FscryptKeyV1Test, fscrypt_key_v1_EncryptClassE, TestSize.Level1)
     EXPECT_FALSE(g_testKeyV1->EncryptClassE(emptyUserAuth, isSupport, user, status));
     GTEST_LOG_(INFO) << "fscrypt_key_v1_EncryptClassE end";
 }
+
+/**
+ * @tc.name: fscrypt_key_v1_KeyCacheEvictor
+ * @tc.desc: Verify that the cache evictor fails on a missing mount without dropping any cache.
+ * @tc.type: FUNC
+ * @tc.require: AR000GK0BP
+ */
+HWTEST_F(FscryptKeyV1Test, fscrypt_key_v1_KeyCacheEvictor, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "fscrypt_key_v1_KeyCacheEvictor start";
+    KeyCacheEvictor evictor("test");
+    EXPECT_FALSE(evictor.Evict("/data/test/evict_not_exist"));
+    EXPECT_EQ(evictor.GetStat().freedKb, 0);
+    EXPECT_GE(evictor.GetStat().costMs, 0);
+    evictor.Report();
+    GTEST_LOG_(INFO) << "fscrypt_key_v1_KeyCacheEvictor end";
+}
 } // OHOS::StorageDaemon
\ No newline at end of file
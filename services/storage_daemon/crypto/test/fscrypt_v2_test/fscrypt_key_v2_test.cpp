@@ -267,4 +267,39 @@ HWTEST_F(FscryptKeyV2Test, fscrypt_key_v2_LoadAndSetEceAndSecePolicy, TestSize.L
     EXPECT_EQ(LoadAndSetEceAndSecePolicy(TEST_DIR_LEGACY.c_str(), dir, type), 0);
     GTEST_LOG_(INFO) << "fscrypt_key_v2_LoadAndSetEceAndSecePolicy end";
 }
+
+/**
+ * @tc.name: fscrypt_key_v2_PolicyHandle
+ * @tc.desc: Verify the fscrypt policy handle functions
+ * @tc.type: FUNC
+ * @tc.require: AR000GK0BP
+ */
+HWTEST_F(FscryptKeyV2Test, fscrypt_key_v2_PolicyHandle, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "fscrypt_key_v2_PolicyHandle start";
+    struct FscryptPolicyHandle handle;
+    const char* dir = TEST_MNT.c_str();
+    EXPECT_EQ(LoadPolicyHandle(nullptr, &handle), -EINVAL);
+    EXPECT_EQ(LoadPolicyHandle(TEST_DIR_LEGACY.c_str(), nullptr), -EINVAL);
+    EXPECT_EQ(SetPolicyByHandle(nullptr, dir), -EINVAL);
+    EXPECT_EQ(LoadEceAndSecePolicyHandle(nullptr, &handle), -EINVAL);
+
+    OHOS::ForceRemoveDirectory(TEST_DIR_LEGACY);
+    EXPECT_TRUE(OHOS::ForceCreateDirectory(TEST_DIR_LEGACY));
+    EXPECT_EQ(LoadEceAndSecePolicyHandle(TEST_DIR_LEGACY.c_str(), &handle), 0);
+    EXPECT_EQ(handle.version, FSCRYPT_INVALID);
+    EXPECT_EQ(SetPolicyByHandle(&handle, dir), -ENOTSUP);
+    EXPECT_EQ(SetEceAndSecePolicyByHandle(&handle, dir, 3), 0);
+
+    std::string testVersionFile = TEST_DIR_LEGACY + "/fscrypt_version";
+    EXPECT_TRUE(OHOS::SaveStringToFile(testVersionFile, "1\n"));
+    EXPECT_NE(LoadEceAndSecePolicyHandle(TEST_DIR_LEGACY.c_str(), &handle), 0);
+
+    EXPECT_TRUE(OHOS::SaveStringToFile(testVersionFile, "2\n"));
+    EXPECT_EQ(LoadEceAndSecePolicyHandle(TEST_DIR_LEGACY.c_str(), &handle), 0);
+    EXPECT_EQ(handle.version, FSCRYPT_V2);
+    EXPECT_EQ(SetEceAndSecePolicyByHandle(&handle, dir, 4), 0);
+    OHOS::ForceRemoveDirectory(TEST_DIR_LEGACY);
+    GTEST_LOG_(INFO) << "fscrypt_key_v2_PolicyHandle end";
+}
 } // OHOS::StorageDaemon
\ No newline at end of file
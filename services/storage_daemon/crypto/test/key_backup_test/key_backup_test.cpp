@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 
 #include "directory_ex.h"
+#include "file_ex.h"
 
 using namespace std;
 using namespace testing::ext;
@@ -130,4 +131,79 @@ HWTEST_F(KeyBackupTest, KeyBackup_HandleCopyDir_001, TestSize.Level1)
     EXPECT_FALSE(access(baseDir.c_str(), F_OK) == 0);
     GTEST_LOG_(INFO) << "KeyBackup_HandleCopyDir_001 end";
 }
+
+/**
+ * @tc.name: KeyBackup_CreateBackup_001
+ * @tc.desc: Verify that CreateBackup copies only the changed files and CompareFile checks size and content.
+ * @tc.type: FUNC
+ * @tc.require: IAHHWW
+ */
+HWTEST_F(KeyBackupTest, KeyBackup_CreateBackup_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "KeyBackup_CreateBackup_001 Start";
+    string baseDir = "/data/test/KeyBackup/";
+    string fromPath = baseDir + "key";
+    string toPath = baseDir + "key_bak";
+    EXPECT_TRUE(OHOS::ForceCreateDirectory(fromPath + "/latest"));
+    EXPECT_TRUE(OHOS::SaveStringToFile(fromPath + "/latest/encrypted", "encrypted"));
+    EXPECT_TRUE(OHOS::SaveStringToFile(fromPath + "/latest/sec_discard", "sec_discard"));
+    EXPECT_TRUE(OHOS::SaveStringToFile(fromPath + "/latest/encrypted.sync_tmp", "unfinished"));
+
+    KeyBackup::GetInstance().CreateBackup(fromPath, toPath, false);
+    string content;
+    EXPECT_TRUE(OHOS::LoadStringFromFile(toPath + "/latest/encrypted", content));
+    EXPECT_EQ(content, "encrypted");
+    EXPECT_FALSE(access((toPath + "/latest/encrypted.sync_tmp").c_str(), F_OK) == 0);
+    EXPECT_EQ(KeyBackup::GetInstance().CompareFile(fromPath + "/latest/sec_discard",
+        toPath + "/latest/sec_discard"), 0);
+
+    EXPECT_TRUE(OHOS::SaveStringToFile(fromPath + "/latest/encrypted", "encrypteD"));
+    EXPECT_NE(KeyBackup::GetInstance().CompareFile(fromPath + "/latest/encrypted", toPath + "/latest/encrypted"), 0);
+    EXPECT_TRUE(OHOS::SaveStringToFile(fromPath + "/latest/sec_discard", "sec"));
+    EXPECT_NE(KeyBackup::GetInstance().CompareFile(fromPath + "/latest/sec_discard",
+        toPath + "/latest/sec_discard"), 0);
+    KeyBackup::GetInstance().CreateBackup(fromPath, toPath, false);
+    EXPECT_TRUE(OHOS::LoadStringFromFile(toPath + "/latest/encrypted", content));
+    EXPECT_EQ(content, "encrypteD");
+    EXPECT_TRUE(OHOS::LoadStringFromFile(toPath + "/latest/sec_discard", content));
+    EXPECT_EQ(content, "sec");
+    EXPECT_EQ(KeyBackup::GetInstance().CompareFile(fromPath + "/latest/none", toPath + "/latest/none"), -1);
+    EXPECT_TRUE(OHOS::ForceRemoveDirectory(baseDir));
+    GTEST_LOG_(INFO) << "KeyBackup_CreateBackup_001 end";
+}
+
+/**
+ * @tc.name: KeyBackup_IsValidKeyFile_001
+ * @tc.desc: Verify that broken key files are told apart without a decrypt, and GetFileList counts the diff files.
+ * @tc.type: FUNC
+ * @tc.require: IAHHWW
+ */
+HWTEST_F(KeyBackupTest, KeyBackup_IsValidKeyFile_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "KeyBackup_IsValidKeyFile_001 Start";
+    EXPECT_FALSE(KeyBackup::GetInstance().IsValidKeyFile("encrypted", ""));
+    EXPECT_FALSE(KeyBackup::GetInstance().IsValidKeyFile("encrypted", string(16, '\0')));
+    EXPECT_TRUE(KeyBackup::GetInstance().IsValidKeyFile("encrypted", "encrypted"));
+    EXPECT_FALSE(KeyBackup::GetInstance().IsValidKeyFile("sec_discard", "sec"));
+    EXPECT_TRUE(KeyBackup::GetInstance().IsValidKeyFile("sec_discard", string(CRYPTO_KEY_SECDISC_SIZE, 's')));
+    EXPECT_FALSE(KeyBackup::GetInstance().IsValidKeyFile("need_update", "KEY_CRYPT"));
+    EXPECT_TRUE(KeyBackup::GetInstance().IsValidKeyFile("need_update", "KEY_CRYPT_HUKS_OPENSSL"));
+
+    string baseDir = "/data/test/KeyBackup/";
+    string origDir = baseDir + "key/latest";
+    string backupDir = baseDir + "key_bak/latest";
+    EXPECT_TRUE(OHOS::ForceCreateDirectory(origDir));
+    EXPECT_TRUE(OHOS::ForceCreateDirectory(backupDir));
+    EXPECT_TRUE(OHOS::SaveStringToFile(origDir + "/encrypted", "encrypted1"));
+    EXPECT_TRUE(OHOS::SaveStringToFile(backupDir + "/encrypted", "encrypted2"));
+    EXPECT_TRUE(OHOS::SaveStringToFile(origDir + "/shield", "shield"));
+    EXPECT_TRUE(OHOS::SaveStringToFile(backupDir + "/shield", "shield"));
+    EXPECT_TRUE(OHOS::SaveStringToFile(backupDir + "/need_update", "KEY_CRYPT_HUKS"));
+    vector<struct FileNode> fileList;
+    uint32_t diffNum = 0;
+    EXPECT_EQ(KeyBackup::GetInstance().GetFileList(origDir, backupDir, fileList, diffNum), 0);
+    EXPECT_EQ(diffNum, 2);
+    EXPECT_TRUE(OHOS::ForceRemoveDirectory(baseDir));
+    GTEST_LOG_(INFO) << "KeyBackup_IsValidKeyFile_001 end";
+}
 }
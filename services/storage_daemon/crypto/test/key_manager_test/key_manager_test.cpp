@@ -81,6 +81,7 @@ void KeyManagerTest::TearDownTestCase(void)
 void KeyManagerTest::SetUp(void)
 {
     GTEST_LOG_(INFO) << "SetUp Start";
+    KeyManager::GetInstance()->policyHandles_.clear();
 }
 
 void KeyManagerTest::TearDown(void)
@@ -246,6 +247,39 @@ HWTEST_F(KeyManagerTest, KeyManager_RestoreDeviceKey_002, TestSize.Level1)
     GTEST_LOG_(INFO) << "KeyManager_RestoreDeviceKey_002 end";
 }
 
+/**
+ * @tc.name: KeyManager_RestoreUsersEl1Key_001
+ * @tc.desc: Verify that the el1 keys of several users are restored and a failed user is left out.
+ * @tc.type: FUNC
+ * @tc.require: IAHHWW
+ */
+HWTEST_F(KeyManagerTest, KeyManager_RestoreUsersEl1Key_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "KeyManager_RestoreUsersEl1Key_001 Start";
+    auto existKey = std::make_shared<FscryptKeyV2>("/data/test/user/el1/900");
+    KeyManager::GetInstance()->userEl1Key_[900] = existKey;
+    std::vector<FileList> dirInfo = { {900, "/data/test/user/el1/900"}, {901, "/data/test/user/el1/901"},
+        {902, "/data/test/user/el1/902"}, {903, "/data/test/user/el1/903"} };
+    EXPECT_CALL(*fscryptControlMock_, GetFscryptVersionFromPolicy()).Times(3).WillRepeatedly(Return(FSCRYPT_V2));
+    EXPECT_CALL(*keyControlMock_, KeyCtrlGetFscryptVersion(_)).Times(3).WillRepeatedly(Return(FSCRYPT_V2));
+    EXPECT_CALL(*baseKeyMock_, InitKey(_)).Times(3).WillRepeatedly(Return(true));
+    EXPECT_CALL(*baseKeyMock_, RestoreKey(_)).Times(3).WillRepeatedly(Return(true));
+    EXPECT_CALL(*fscryptKeyMock_, ActiveKey(_, _)).Times(3).WillOnce(Return(false)).WillRepeatedly(Return(true));
+    KeyManager::GetInstance()->RestoreUsersEl1Key(dirInfo);
+
+    EXPECT_EQ(KeyManager::GetInstance()->userEl1Key_[900], existKey);
+    size_t restored = 0;
+    for (uint32_t user : { 901, 902, 903 }) {
+        if (KeyManager::GetInstance()->userEl1Key_.count(user) != 0) {
+            restored++;
+        }
+        KeyManager::GetInstance()->userEl1Key_.erase(user);
+    }
+    EXPECT_EQ(restored, 2);
+    KeyManager::GetInstance()->userEl1Key_.erase(900);
+    GTEST_LOG_(INFO) << "KeyManager_RestoreUsersEl1Key_001 end";
+}
+
 /**
  * @tc.name: KeyManager_ActiveUserKey
  * @tc.desc: Verify the ActiveUserKey function.
@@ -472,11 +506,13 @@ HWTEST_F(KeyManagerTest, KeyManager_SetDirectoryElPolicy, TestSize.Level1)
     KeyManager::GetInstance()->userEl1Key_[user] = tmpKey;
     vec.push_back({1, "/test"});
     EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetPolicy(_, _)).WillOnce(Return(-EINVAL));
+    EXPECT_CALL(*fscryptControlMock_, LoadPolicyHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetPolicyByHandle(_, _)).WillOnce(Return(-EINVAL));
     EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, type, vec), -EFAULT);
 
     EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetPolicy(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, LoadPolicyHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetPolicyByHandle(_, _)).WillOnce(Return(0));
     EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, type, vec), 0);
 
     int eL6Key = 6;
@@ -490,14 +526,17 @@ HWTEST_F(KeyManagerTest, KeyManager_SetDirectoryElPolicy, TestSize.Level1)
 
     KeyManager::GetInstance()->userEl2Key_[user] = tmpKey;
     KeyManager::GetInstance()->userEl3Key_[user] = tmpKey;
+    // the el2 key is the el1 one, its policy is still cached
     EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetPolicy(_, _)).WillOnce(Return(0));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetEceAndSecePolicy(_, _, _)).WillOnce(Return(-EINVAL));
+    EXPECT_CALL(*fscryptControlMock_, SetPolicyByHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, LoadEceAndSecePolicyHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetEceAndSecePolicyByHandle(_, _, _)).WillOnce(Return(-EINVAL));
     EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, type, vec), -EFAULT);
 
     EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetPolicy(_, _)).WillOnce(Return(0));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetEceAndSecePolicy(_, _, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetPolicyByHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, LoadEceAndSecePolicyHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetEceAndSecePolicyByHandle(_, _, _)).WillOnce(Return(0));
     EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, type, vec), 0);
     GTEST_LOG_(INFO) << "KeyManager_SetDirectoryElPolicy end";
 }
@@ -1295,11 +1334,19 @@ HWTEST_F(KeyManagerTest, KeyManager_SetDirectoryElPolicy_001, TestSize.Level1)
 
     KeyManager::GetInstance()->userEl1Key_[user] = elKey;
     EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetPolicy(_, _)).WillOnce(Return(-1));
+    EXPECT_CALL(*fscryptControlMock_, LoadPolicyHandle(_, _)).WillOnce(Return(-1));
     EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, EL1_KEY, vec), -EFAULT);
 
     EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetPolicy(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, LoadPolicyHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetPolicyByHandle(_, _)).WillOnce(Return(0));
+    EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, EL1_KEY, vec), 0);
+
+    // the policy is loaded once per key and set on every later dir with one call
+    EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
+    EXPECT_CALL(*fscryptControlMock_, LoadPolicyHandle(_, _)).Times(0);
+    EXPECT_CALL(*fscryptControlMock_, SetPolicyByHandle(_, _)).Times(2).WillRepeatedly(Return(0));
+    vec.push_back({ 100, "/test/path2" });
     EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, EL1_KEY, vec), 0);
     KeyManager::GetInstance()->userEl1Key_.erase(user);
     GTEST_LOG_(INFO) << "KeyManager_SetDirectoryElPolicy_001 end";
@@ -1324,7 +1371,8 @@ HWTEST_F(KeyManagerTest, KeyManager_SetDirectoryElPolicy_002, TestSize.Level1)
 
     KeyManager::GetInstance()->userEl2Key_[user] = elKey;
     EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetPolicy(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, LoadPolicyHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetPolicyByHandle(_, _)).WillOnce(Return(0));
     EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, EL2_KEY, vec), 0);
     KeyManager::GetInstance()->userEl2Key_.erase(user);
     GTEST_LOG_(INFO) << "KeyManager_SetDirectoryElPolicy_002 end";
@@ -1350,13 +1398,16 @@ HWTEST_F(KeyManagerTest, KeyManager_SetDirectoryElPolicy_003, TestSize.Level1)
 
     KeyManager::GetInstance()->userEl3Key_[user] = elKey;
     EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetPolicy(_, _)).WillOnce(Return(0));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetEceAndSecePolicy(_, _, _)).WillOnce(Return(-1));
+    EXPECT_CALL(*fscryptControlMock_, LoadPolicyHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetPolicyByHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, LoadEceAndSecePolicyHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetEceAndSecePolicyByHandle(_, _, _)).WillOnce(Return(-1));
     EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, EL3_KEY, vec), -EFAULT);
 
     EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetPolicy(_, _)).WillOnce(Return(0));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetEceAndSecePolicy(_, _, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetPolicyByHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, LoadEceAndSecePolicyHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetEceAndSecePolicyByHandle(_, _, _)).WillOnce(Return(0));
     EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, EL3_KEY, vec), 0);
     KeyManager::GetInstance()->userEl2Key_.erase(user);
     KeyManager::GetInstance()->userEl3Key_.erase(user);
@@ -1380,14 +1431,17 @@ HWTEST_F(KeyManagerTest, KeyManager_SetDirectoryElPolicy_004, TestSize.Level1)
     KeyManager::GetInstance()->userEl2Key_[user] = elKey;
     KeyManager::GetInstance()->userEl4Key_[user] = elKey;
     EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetPolicy(_, _)).WillOnce(Return(0));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetEceAndSecePolicy(_, _, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, LoadPolicyHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetPolicyByHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, LoadEceAndSecePolicyHandle(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetEceAndSecePolicyByHandle(_, _, _)).WillOnce(Return(0));
     EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, EL4_KEY, vec), 0);
     KeyManager::GetInstance()->userEl4Key_.erase(user);
 
     KeyManager::GetInstance()->userEl5Key_[user] = elKey;
+    // the el2 policy of the same key was loaded above
     EXPECT_CALL(*fscryptControlMock_, KeyCtrlHasFscryptSyspara()).WillOnce(Return(true));
-    EXPECT_CALL(*fscryptControlMock_, LoadAndSetPolicy(_, _)).WillOnce(Return(0));
+    EXPECT_CALL(*fscryptControlMock_, SetPolicyByHandle(_, _)).WillOnce(Return(0));
     EXPECT_EQ(KeyManager::GetInstance()->SetDirectoryElPolicy(user, EL5_KEY, vec), 0);
     KeyManager::GetInstance()->userEl5Key_.erase(user);
 
@@ -15,8 +15,15 @@
 
 #include "disk/disk_manager.h"
 
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
 #include <sys/sysmacros.h>
 #include <thread>
+#include <unistd.h>
+#include <vector>
 
 #include "ipc/storage_manager_client.h"
 #include "storage_service_errno.h"
@@ -50,14 +57,14 @@ void DiskManager::HandleDiskEvent(NetlinkData *data)
         return;
     }
     std::lock_guard<std::mutex> lock(lock_);
-    std::string devType = data->GetParam("DEVTYPE");
-    if (devType != "disk") {
+    if (data->GetParamView("DEVTYPE") != "disk") {
         return;
     }
-
-    unsigned int major = (unsigned int) std::stoi(data->GetParam("MAJOR"));
-    unsigned int minor = (unsigned int) std::stoi(data->GetParam("MINOR"));
-    dev_t device = makedev(major, minor);
+    if (data->GetMajor() < 0 || data->GetMinor() < 0) {
+        LOGE("invalid disk event, devPath is %{public}s", data->GetDevpath().c_str());
+        return;
+    }
+    dev_t device = makedev(static_cast<unsigned int>(data->GetMajor()), static_cast<unsigned int>(data->GetMinor()));
 
     switch (data->GetAction()) {
         case NetlinkData::Actions::ADD: {
@@ -95,9 +102,12 @@ std::shared_ptr<DiskInfo> DiskManager::MatchConfig(NetlinkData *data)
     }
     std::string sysPath = data->GetSyspath();
     std::string devPath = data->GetDevpath();
-    unsigned int major = (unsigned int) std::stoi(data->GetParam("MAJOR"));
-    unsigned int minor = (unsigned int) std::stoi(data->GetParam("MINOR"));
-    dev_t device = makedev(major, minor);
+    if (data->GetMajor() < 0 || data->GetMinor() < 0) {
+        LOGE("invalid major or minor, devPath is %{public}s", devPath.c_str());
+        return nullptr;
+    }
+    unsigned int major = static_cast<unsigned int>(data->GetMajor());
+    dev_t device = makedev(major, static_cast<unsigned int>(data->GetMinor()));
 
     for (auto config : diskConfig_) {
         if ((config != nullptr) && config->IsMatch(devPath)) {
@@ -198,6 +208,73 @@ void DiskManager::ReplayUevent()
     TraverseDirUevent(sysBlockPath_, true);
 }
 
+void DiskManager::RescanDisks()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        std::vector<dev_t> removed;
+        for (const auto &diskInfo : disk_) {
+            if (diskInfo != nullptr && access(diskInfo->GetSysPath().c_str(), F_OK) != 0 && errno == ENOENT) {
+                removed.push_back(diskInfo->GetDevice());
+            }
+        }
+        for (auto device : removed) {
+            LOGI("Disk %{public}u:%{public}u is gone", major(device), minor(device));
+            DestroyDisk(device);
+        }
+    }
+
+    // a change event is handled as an add for unknown disks and re-reads the partitions of known ones,
+    // only the disks that match a config are triggered, the others are ignored by HandleDiskEvent anyway
+    DIR *dir = opendir(sysBlockPath_.c_str());
+    if (dir == nullptr) {
+        LOGE("failed to open %{public}s, errno %{public}d", sysBlockPath_.c_str(), errno);
+        return;
+    }
+    for (struct dirent *ent = readdir(dir); ent != nullptr; ent = readdir(dir)) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+        if (!IsConfiguredDisk(ent->d_name)) {
+            continue;
+        }
+        std::string uevent = sysBlockPath_ + "/" + ent->d_name + "/uevent";
+        int fd = open(uevent.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        std::string writeStr = "change\n";
+        if (write(fd, writeStr.c_str(), writeStr.length()) < 0) {
+            LOGE("failed to trigger %{public}s, errno %{public}d", uevent.c_str(), errno);
+        }
+        (void)close(fd);
+    }
+    (void)closedir(dir);
+}
+
+bool DiskManager::IsConfiguredDisk(const std::string &name)
+{
+    // /sys/block/<name> links to the device, its path below /sys is the DEVPATH of the uevents
+    char realPath[PATH_MAX] = { 0 };
+    std::string sysPath = sysBlockPath_ + "/" + name;
+    if (realpath(sysPath.c_str(), realPath) == nullptr) {
+        return false;
+    }
+    std::string sysRoot = sysBlockPath_.substr(0, sysBlockPath_.rfind('/'));
+    std::string devPath(realPath);
+    if (devPath.compare(0, sysRoot.size(), sysRoot) != 0) {
+        return false;
+    }
+    devPath.erase(0, sysRoot.size());
+    std::lock_guard<std::mutex> lock(lock_);
+    for (auto &config : diskConfig_) {
+        if (config != nullptr && config->IsMatch(devPath)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 int32_t DiskManager::HandlePartition(std::string diskId)
 {
     int32_t ret = E_NON_EXIST;
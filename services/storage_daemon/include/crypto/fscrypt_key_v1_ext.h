@@ -31,6 +31,10 @@ public:
         userId_ = GetUserIdFromDir();
         type_ = GetTypeFromDir();
     }
+    uint32_t GetUserId() const
+    {
+        return userId_;
+    }
     bool ActiveKeyExt(uint32_t flag, uint8_t *iv, uint32_t size, uint32_t &elType);
     bool InactiveKeyExt(uint32_t flag);
     bool LockUserScreenExt(uint32_t flag, uint32_t &elType);
@@ -17,6 +17,7 @@
 #define STORAGE_DAEMON_KEY_BACKUP_H
 
 #include <string>
+#include <vector>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -33,6 +34,16 @@ struct FileAttr {
     mode_t mode;
 };
 
+struct FileNode {
+    std::string baseName;
+    std::string origFile;
+    std::string backFile;
+    bool isSame;
+    std::string origData;
+    std::string backData;
+    bool preferBack;
+};
+
 class KeyBackup {
 public:
     static KeyBackup &GetInstance()
@@ -68,13 +79,21 @@ private:
     bool WriteStringToFd(int fd, const std::string &content);
     bool WriteStringToFile(const std::string &payload, const std::string &fileName);
     int32_t CompareFile(const std::string &fileA, const std::string fileB);
+    int32_t CompareFileAt(int dirA, const std::string &nameA, int dirB, const std::string &nameB);
+    int32_t SyncDirAt(int fromFd, int toFd, const std::string &from, uint32_t depth);
+    int32_t SyncSubDirAt(int fromFd, int toFd, const std::string &from, const std::string &name,
+        const struct stat &st, uint32_t depth);
+    int CopyFileToTempAt(int fromFd, int toFd, const std::string &name, const struct stat &st);
+    int32_t CommitFilesAt(int toFd, const std::string &from, const std::vector<std::string> &names,
+        std::vector<int> &fds);
+    static bool IsSyncTempName(const std::string &name);
     int32_t CopyRegfileData(const std::string &from, const std::string &to);
     int32_t GetAttr(const std::string &path, struct FileAttr &attr);
     int32_t SetAttr(const std::string &path, struct FileAttr &attr);
     int32_t HandleCopyDir(const std::string &from, const std::string &to);
     void CheckAndFixFiles(const std::string &from, const std::string &to);
     int32_t GetFileList(const std::string &origDir, const std::string &backDir,
-        std::vector<struct FileNode> &fileListm, uint32_t diffNum);
+        std::vector<struct FileNode> &fileListm, uint32_t &diffNum);
     void AddOrigFileToList(const std::string &fileName, const std::string &origDir,
         std::vector<struct FileNode> &fileList);
     void AddBackupFileToList(const std::string &fileName, const std::string &backDir,
@@ -84,8 +103,12 @@ private:
         std::vector<struct FileNode> &fileList);
     int32_t CreateTempDirForMixFiles(const std::string &backupDir, std::string &tempDir);
     uint32_t GetLoopMaxNum(uint32_t diffNum);
-    int32_t CopyMixFilesToTempDir(uint32_t diffNum, uint32_t num, const std::string &tempDir,
-        const std::vector<struct FileNode> &fileList);
+    bool IsValidKeyFile(const std::string &baseName, const std::string &content);
+    int32_t LoadMixFiles(const std::string &tempDir, std::vector<struct FileNode> &fileList);
+    std::vector<uint32_t> GetMixOrder(const std::vector<struct FileNode> &fileList);
+    int32_t WriteMixFilesToTempDir(uint32_t mask, const std::string &tempDir,
+        const std::vector<struct FileNode> &fileList, std::vector<int32_t> &written);
+    int32_t WriteMixFile(const std::string &content, const std::string &path);
     bool IsRegFile(const std::string &filePath);
     int32_t DoResotreKeyMix(std::shared_ptr<BaseKey> &baseKey, const UserAuth &auth, const std::string &keyDir,
         const std::string &backupDir);
@@ -94,6 +117,7 @@ private:
     constexpr static mode_t DEFAULT_DIR_PERM = 0700;
     constexpr static mode_t DEFAULT_WRITE_FILE_PERM = 0644;
     constexpr static uint32_t MAX_FILE_NUM = 5;
+    constexpr static size_t COMPARE_BUF_SIZE = 4096;
 };
 } // namespace StorageDaemon
 } // namespace OHOS
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STORAGE_DAEMON_CRYPTO_KEY_CACHE_EVICTOR_H
+#define STORAGE_DAEMON_CRYPTO_KEY_CACHE_EVICTOR_H
+
+#include <cstdint>
+#include <string>
+
+namespace OHOS {
+namespace StorageDaemon {
+struct CacheEvictStat {
+    // the drop of Cached and SReclaimable in /proc/meminfo, other activity makes it approximate
+    int64_t freedKb = 0;
+    int64_t costMs = 0;
+};
+
+/**
+ * Evicts the caches left behind by a key that was removed.
+ *
+ * The dentries and inodes in cache hold plaintext names and inodes that still reference the key,
+ * so the filesystem is synced and the dentry and inode caches of the whole system are dropped.
+ * Evict fails without dropping anything when the mount cannot be opened.
+ */
+class KeyCacheEvictor {
+public:
+    explicit KeyCacheEvictor(const std::string &tag);
+    ~KeyCacheEvictor() = default;
+
+    bool Evict(const std::string &mnt);
+    const CacheEvictStat &GetStat() const
+    {
+        return stat_;
+    }
+    void Report() const;
+
+private:
+    static int64_t ReadReclaimableKb();
+
+    std::string tag_;
+    CacheEvictStat stat_;
+};
+} // namespace StorageDaemon
+} // namespace OHOS
+
+#endif // STORAGE_DAEMON_CRYPTO_KEY_CACHE_EVICTOR_H
@@ -24,6 +24,7 @@
 #include "base_key.h"
 #include "crypto_delay_handler.h"
 #include "key_blob.h"
+#include "libfscrypt/fscrypt_control.h"
 #include "ipc/storage_daemon.h"
 #include "storage_service_constant.h"
 #include "utils/file_utils.h"
@@ -109,6 +110,7 @@ private:
     int GenerateAndInstallEl5Key(uint32_t userId, const std::string &dir, const UserAuth &auth);
     int RestoreUserKey(uint32_t userId, const std::string &dir, const UserAuth &auth, KeyType type);
     int LoadAllUsersEl1Key(void);
+    void RestoreUsersEl1Key(const std::vector<FileList> &dirInfo);
     int InitUserElkeyStorageDir(void);
     bool HasElkey(uint32_t userId, KeyType type);
     int DoDeleteUserKeys(unsigned int user);
@@ -137,6 +139,8 @@ private:
     bool IsUserCeDecrypt(uint32_t userId);
     bool UnlockEceSece(uint32_t user, const std::vector<uint8_t> &token, const std::vector<uint8_t> &secret, int &ret);
     bool UnlockUece(uint32_t user, const std::vector<uint8_t> &token, const std::vector<uint8_t> &secret, int &ret);
+    int GetPolicyHandle(const std::shared_ptr<BaseKey> &key, bool eceSece, FscryptPolicyHandle &handle);
+    void DropPolicyHandle(const std::shared_ptr<BaseKey> &key, bool eceSece);
     void CheckAndClearTokenInfo(uint32_t user);
 #ifdef EL5_FILEKEY_MANAGER
     int GenerateAndLoadAppKeyInfo(uint32_t userId, const std::vector<std::pair<int, std::string>> &keyInfo);
@@ -153,6 +157,12 @@ private:
     std::map<unsigned int, bool> saveLockScreenStatus;
     std::map<unsigned int, bool> saveESecretStatus;
     std::mutex keyMutex_;
+    // policies loaded from the key dirs, an entry is only valid for the key it was loaded for
+    struct PolicyHandleEntry {
+        std::weak_ptr<BaseKey> key;
+        FscryptPolicyHandle handle;
+    };
+    std::map<std::pair<std::string, bool>, PolicyHandleEntry> policyHandles_;
     bool hasGlobalDeviceKey_;
 };
 } // namespace StorageDaemon
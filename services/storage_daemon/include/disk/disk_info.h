@@ -18,6 +18,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include <sys/types.h>
 
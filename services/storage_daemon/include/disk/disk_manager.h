@@ -43,10 +43,12 @@ public:
     int32_t HandlePartition(std::string diskId);
     void AddDiskConfig(std::shared_ptr<DiskConfig> &diskConfig);
     void ReplayUevent();
+    void RescanDisks();
     std::shared_ptr<DiskInfo> MatchConfig(NetlinkData *data);
 
 private:
     DiskManager() = default;
+    bool IsConfiguredDisk(const std::string &name);
 
     std::mutex lock_;
     std::list<std::shared_ptr<DiskInfo>> disk_;
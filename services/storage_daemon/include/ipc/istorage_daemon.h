@@ -91,6 +91,7 @@ public:
     }
 
     virtual int32_t GetOccupiedSpace(int32_t idType, int32_t id, int64_t &size) = 0;
+    virtual int32_t GetOccupiedSpaceBatch(int32_t idType, std::vector<int32_t> &ids, std::vector<int64_t> &sizes) = 0;
 
     virtual int32_t UpdateMemoryPara(int32_t size, int32_t &oldSize) = 0;
     virtual int32_t GetBundleStatsForIncrease(uint32_t userId, const std::vector<std::string> &bundleNames,
@@ -91,6 +91,8 @@ public:
     virtual int32_t SetBundleQuota(const std::string &bundleName, int32_t uid,
         const std::string &bundleDataDirPath, int32_t limitSizeMb) override;
     virtual int32_t GetOccupiedSpace(int32_t idType, int32_t id, int64_t &size) override;
+    virtual int32_t GetOccupiedSpaceBatch(int32_t idType, std::vector<int32_t> &ids,
+        std::vector<int64_t> &sizes) override;
     virtual int32_t UpdateMemoryPara(int32_t size, int32_t &oldSize) override;
     virtual int32_t GetBundleStatsForIncrease(uint32_t userId, const std::vector<std::string> &bundleNames,
         const std::vector<int64_t> &incrementalBackTimes, std::vector<int64_t> &pkgFileSizes,
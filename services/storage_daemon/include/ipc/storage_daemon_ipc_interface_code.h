@@ -61,6 +61,7 @@ namespace StorageDaemon {
         GET_FILE_ENCRYPT_STATUS,
         CREATE_RECOVER_KEY,
         SET_RECOVER_KEY,
+        GET_SPACE_BATCH,
     };
 } // namespace StorageDaemon
 } // namespace OHOS
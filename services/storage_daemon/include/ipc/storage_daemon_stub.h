@@ -78,6 +78,7 @@ private:
 
     int32_t HandleSetBundleQuota(MessageParcel &data, MessageParcel &reply);
     int32_t HandleGetOccupiedSpace(MessageParcel &data, MessageParcel &reply);
+    int32_t HandleGetOccupiedSpaceBatch(MessageParcel &data, MessageParcel &reply);
     int32_t HandleUpdateMemoryPara(MessageParcel &data, MessageParcel &reply);
 
     int32_t HandleGetBundleStatsForIncrease(MessageParcel &data, MessageParcel &reply);
@@ -40,10 +40,23 @@ struct FscryptSdpPolicy {
 };
 #pragma pack(pop)
 
+/*
+ * A policy loaded once from a key dir, it can then be set on any number of dirs with one ioctl each.
+ * version is FSCRYPT_INVALID when nothing could be loaded.
+ */
+struct FscryptPolicyHandle {
+    uint8_t version;
+    union FscryptPolicy policy;
+};
+
 int FscryptSetSysparam(const char *policy);
 int SetGlobalEl1DirPolicy(const char *dir);
 int LoadAndSetPolicy(const char *keyDir, const char *dir);
 int LoadAndSetEceAndSecePolicy(const char *keyDir, const char *dir, int type);
+int LoadPolicyHandle(const char *keyDir, struct FscryptPolicyHandle *handle);
+int SetPolicyByHandle(const struct FscryptPolicyHandle *handle, const char *dir);
+int LoadEceAndSecePolicyHandle(const char *keyDir, struct FscryptPolicyHandle *handle);
+int SetEceAndSecePolicyByHandle(const struct FscryptPolicyHandle *handle, const char *dir, int type);
 int InitFscryptPolicy(void);
 uint8_t GetFscryptVersionFromPolicy(void);
 
@@ -18,6 +18,8 @@
 #include <gmock/gmock.h>
 #include <memory>
 
+struct FscryptPolicyHandle;
+
 namespace OHOS {
 namespace StorageDaemon {
 class IFscryptControlMoc {
@@ -28,6 +30,11 @@ public:
     virtual bool KeyCtrlHasFscryptSyspara(void) = 0;
     virtual int LoadAndSetPolicy(const char *keyDir, const char *dir) = 0;
     virtual int LoadAndSetEceAndSecePolicy(const char *keyDir, const char *dir, int type) = 0;
+    virtual int LoadPolicyHandle(const char *keyDir, struct FscryptPolicyHandle *handle) = 0;
+    virtual int SetPolicyByHandle(const struct FscryptPolicyHandle *handle, const char *dir) = 0;
+    virtual int LoadEceAndSecePolicyHandle(const char *keyDir, struct FscryptPolicyHandle *handle) = 0;
+    virtual int SetEceAndSecePolicyByHandle(const struct FscryptPolicyHandle *handle, const char *dir,
+        int type) = 0;
 public:
     static inline std::shared_ptr<IFscryptControlMoc> fscryptControlMoc = nullptr;
 };
@@ -38,6 +45,11 @@ public:
     MOCK_METHOD0(KeyCtrlHasFscryptSyspara, bool());
     MOCK_METHOD2(LoadAndSetPolicy, int(const char *keyDir, const char *dir));
     MOCK_METHOD3(LoadAndSetEceAndSecePolicy, int(const char *keyDir, const char *dir, int type));
+    MOCK_METHOD2(LoadPolicyHandle, int(const char *keyDir, struct FscryptPolicyHandle *handle));
+    MOCK_METHOD2(SetPolicyByHandle, int(const struct FscryptPolicyHandle *handle, const char *dir));
+    MOCK_METHOD2(LoadEceAndSecePolicyHandle, int(const char *keyDir, struct FscryptPolicyHandle *handle));
+    MOCK_METHOD3(SetEceAndSecePolicyByHandle, int(const struct FscryptPolicyHandle *handle, const char *dir,
+        int type));
 };
 }
 }
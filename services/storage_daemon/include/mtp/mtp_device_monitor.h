@@ -15,13 +15,18 @@
 #ifndef OHOS_STORAGE_DAEMON_MTP_DEVICE_MONITOR_H
 #define OHOS_STORAGE_DAEMON_MTP_DEVICE_MONITOR_H
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <nocopyable.h>
 #include <singleton.h>
 #include <string>
 #include <thread>
 #include <vector>
 #include "mtp/mtp_device_manager.h"
+#include "netlink/netlink_data.h"
 
 namespace OHOS {
 namespace StorageDaemon {
@@ -29,19 +34,40 @@ class MtpDeviceMonitor : public NoCopyable  {
     DECLARE_DELAYED_SINGLETON(MtpDeviceMonitor);
 public:
     void StartMonitor();
+    void StopMonitor();
+    // some uevents may be lost, the raw and the mounted devices are checked again
+    void Rescan();
+    void HandleUsbEvent(NetlinkData *data);
     int32_t Mount(const std::string &id);
     int32_t Umount(const std::string &id);
 
 private:
+    struct UsbEvent {
+        NetlinkData::Actions action;
+        uint32_t busNum;
+        uint32_t devNum;
+    };
+
     void MonitorDevice();
+    bool WaitEvent(UsbEvent &event);
+    void DetectMtpDevice(const UsbEvent &event);
+    bool DetectRawDevices(const UsbEvent *event);
     void MountMtpDevice(const std::vector<MtpDeviceInfo> &monitorDevices);
+    void UmountRemovedMtpDevice(const UsbEvent &event);
     void CheckAndUmountRemovedMtpDevice();
     void UmountAllMtpDevice();
     bool HasMounted(const MtpDeviceInfo &device);
+    static std::string GenerateUuid();
 
 private:
     std::mutex listMutex_;
     std::vector<MtpDeviceInfo> lastestMtpDevList_;
+    std::mutex eventMutex_;
+    std::condition_variable eventCond_;
+    std::deque<UsbEvent> events_;
+    // a removed device is still mounted, the mounted devices are checked until it is gone
+    std::atomic<bool> umountRetry_ { false };
+    std::atomic<bool> rescan_ { false };
 };
 } // namespace StorageDaemon
 } // namespace OHOS
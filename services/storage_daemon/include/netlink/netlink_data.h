@@ -16,9 +16,12 @@
 #ifndef OHOS_STORAGE_DAEMON_NETLINK_DATA_H
 #define OHOS_STORAGE_DAEMON_NETLINK_DATA_H
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <string>
-#include <vector>
+#include <string_view>
 
 namespace OHOS {
 namespace StorageDaemon {
@@ -35,29 +38,61 @@ public:
         UNBIND,
         UNKNOWN,
     };
-    std::map<std::string, Actions> actionMaps = {
-        {"add", Actions::ADD},
-        {"remove", Actions::REMOVE},
-        {"move", Actions::MOVE},
-        {"change", Actions::CHANGE},
-        {"online", Actions::ONLINE},
-        {"offline", Actions::OFFLINE},
-        {"bind", Actions::BIND},
-        {"unbind", Actions::UNBIND}
-    };
+    static const std::map<std::string, Actions, std::less<>> actionMaps;
 
     std::string GetSyspath();
     std::string GetDevpath();
     std::string GetSubsystem();
     Actions GetAction();
     const std::string GetParam(const std::string paramName);
+    std::string_view GetParamView(std::string_view paramName) const;
+    std::string_view GetSubsystemView() const
+    {
+        return keys_[KEY_SUBSYSTEM];
+    }
+    // MAJOR, MINOR and PARTN are parsed on decode, -1 is returned if the field is missing or not a number
+    int32_t GetMajor() const
+    {
+        return major_;
+    }
+    int32_t GetMinor() const
+    {
+        return minor_;
+    }
+    int32_t GetPartn() const
+    {
+        return partn_;
+    }
+    /**
+     * @brief Index the fields of an uevent without copying them.
+     *
+     * The fields are kept as views into msg, which has to outlive every later call on this object.
+     * Decoding again drops whatever was decoded before.
+     */
     void Decode(const char *msg);
 
 private:
-    std::string sysPath_;
-    std::string subSystem_;
-    std::string devPath_;
-    std::vector<std::string> params_;
+    enum Keys {
+        KEY_ACTION,
+        KEY_DEVPATH,
+        KEY_SUBSYSTEM,
+        KEY_MAJOR,
+        KEY_MINOR,
+        KEY_DEVTYPE,
+        KEY_PARTN,
+        KEY_MAX,
+    };
+    static constexpr size_t NL_PARAMS_MAX = 128;
+
+    void Reset();
+
+    std::array<std::string_view, KEY_MAX> keys_;
+    std::array<std::string_view, NL_PARAMS_MAX> names_;
+    std::array<std::string_view, NL_PARAMS_MAX> values_;
+    size_t paramCnt_ = 0;
+    int32_t major_ = -1;
+    int32_t minor_ = -1;
+    int32_t partn_ = -1;
     Actions action_ = Actions::UNKNOWN;
 };
 } // STORAGE_DAEMON
@@ -29,6 +29,7 @@ public:
 
 protected:
     virtual void OnEvent(char *msg);
+    virtual void OnOverrun();
 };
 } // STORAGE_DAEMON
 } // OHOS
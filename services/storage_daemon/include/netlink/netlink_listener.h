@@ -15,7 +15,11 @@
 #ifndef OHOS_STORAGE_DAEMON_NETLINK_LISTENER_H
 #define OHOS_STORAGE_DAEMON_NETLINK_LISTENER_H
 
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 
 #include <poll.h>
@@ -32,12 +36,27 @@ public:
 
 protected:
     virtual void OnEvent(char *msg) = 0;
+    // uevents were lost because the socket or the pending queue overflowed, called in order with the events
+    virtual void OnOverrun() {}
 
 private:
+    struct UeventMsg {
+        std::string data;
+        bool overrun;
+    };
+
     int32_t socketFd_ { -1 };
     int32_t socketPipe_[2] { -1, -1 };
     std::unique_ptr<std::thread> socketThread_;
+    std::unique_ptr<std::thread> dispatchThread_;
+    std::mutex eventMutex_;
+    std::condition_variable eventCond_;
+    std::deque<UeventMsg> events_;
+    bool dispatching_ { false };
     void RecvUeventMsg();
+    void GrowRecvBuffer();
+    void PushEvents(std::deque<UeventMsg> &batch);
+    void DispatchEvents();
     int32_t ReadMsg(int32_t fd_count, struct pollfd ufds[2]);
     void RunListener();
     static void EventProcess(void*);
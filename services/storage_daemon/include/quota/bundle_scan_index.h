@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_STORAGE_DAEMON_BUNDLE_SCAN_INDEX_H
+#define OHOS_STORAGE_DAEMON_BUNDLE_SCAN_INDEX_H
+
+#include <cstdint>
+#include <nocopyable.h>
+#include <string>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
+
+namespace OHOS {
+namespace StorageDaemon {
+struct ScanIndexEntry {
+    std::string name;
+    uint8_t type;
+};
+
+struct ScanIndexDir {
+    uint64_t ino;
+    int64_t mtimeSec;
+    int64_t mtimeNsec;
+    int64_t ctimeSec;
+    int64_t ctimeNsec;
+    std::vector<ScanIndexEntry> entries;
+};
+
+/**
+ * Persistent directory listing index of one bundle for incremental backup scans.
+ *
+ * A directory listing is reused only while the directory inode, mtime and ctime are unchanged. Files inside
+ * the directory are still stat'ed by the caller, modifying a file does not touch its parent directory.
+ * Save rewrites the index only when the scan did not match the loaded one exactly.
+ */
+class BundleScanIndex final {
+public:
+    explicit BundleScanIndex(const std::string &indexPath);
+    ~BundleScanIndex() = default;
+
+    bool Load();
+    bool Save();
+    bool IsChanged() const;
+    const std::vector<ScanIndexEntry> *FindEntries(const std::string &dirPath, const struct stat &dirStat);
+    void UpdateEntries(const std::string &dirPath, const struct stat &dirStat,
+        const std::vector<ScanIndexEntry> &entries);
+    uint32_t GetHitCount() const
+    {
+        return hitCount_;
+    }
+    uint32_t GetMissCount() const
+    {
+        return missCount_;
+    }
+
+private:
+    DISALLOW_COPY_AND_MOVE(BundleScanIndex);
+    static bool IsSameDir(const ScanIndexDir &dir, const struct stat &dirStat);
+
+    std::string indexPath_;
+    int64_t scanStartTime_;
+    bool loaded_ = false;
+    std::unordered_map<std::string, ScanIndexDir> oldDirs_;
+    std::unordered_map<std::string, ScanIndexDir> newDirs_;
+    uint32_t hitCount_ = 0;
+    uint32_t missCount_ = 0;
+};
+} // STORAGE_DAEMON
+} // OHOS
+
+#endif // OHOS_STORAGE_DAEMON_BUNDLE_SCAN_INDEX_H
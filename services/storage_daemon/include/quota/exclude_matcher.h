@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_STORAGE_DAEMON_EXCLUDE_MATCHER_H
+#define OHOS_STORAGE_DAEMON_EXCLUDE_MATCHER_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <nocopyable.h>
+#include <string>
+#include <string_view>
+
+namespace OHOS {
+namespace StorageDaemon {
+/**
+ * Path component trie of backup exclude rules.
+ *
+ * A file rule matches the exact path only. A directory rule ends with '/' and matches every path that starts
+ * with it, so a directory path is checked with a trailing '/'. A lookup costs one trie step per path component.
+ */
+class ExcludeMatcher final {
+public:
+    ExcludeMatcher() : root_(std::make_unique<Node>()) {}
+    ~ExcludeMatcher() = default;
+
+    void AddFile(const std::string &path);
+    void AddDir(const std::string &path);
+    bool IsExcluded(std::string_view path) const;
+    bool Empty() const
+    {
+        return root_->children.empty();
+    }
+
+private:
+    DISALLOW_COPY_AND_MOVE(ExcludeMatcher);
+    struct Node {
+        std::map<std::string, std::unique_ptr<Node>, std::less<>> children;
+        bool isFile = false;
+        bool isDir = false;
+    };
+    Node *Insert(std::string_view path);
+
+    std::unique_ptr<Node> root_;
+};
+} // STORAGE_DAEMON
+} // OHOS
+
+#endif // OHOS_STORAGE_DAEMON_EXCLUDE_MATCHER_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_STORAGE_DAEMON_STAT_FILE_WRITER_H
+#define OHOS_STORAGE_DAEMON_STAT_FILE_WRITER_H
+
+#include <cstdint>
+#include <nocopyable.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace OHOS {
+namespace StorageDaemon {
+struct StatFileLine {
+    std::string_view path;
+    int32_t mode;
+    bool isDir;
+    int64_t size;
+    int64_t mtime;
+    bool isIncre;
+    bool encodeFlag;
+};
+
+/**
+ * Serializer of the backup stat file.
+ *
+ * Lines are formatted into a reusable buffer and written in large chunks to a temp file. Commit syncs the temp
+ * file, renames it over the target and syncs the directory, so a crash leaves either the old or the complete
+ * new stat file.
+ */
+class StatFileWriter final {
+public:
+    explicit StatFileWriter(const std::string &path);
+    ~StatFileWriter();
+
+    bool Open();
+    bool IsOpen() const
+    {
+        return fd_ >= 0;
+    }
+    void WriteLine(std::string_view line);
+    void WriteFileLine(const StatFileLine &line);
+    bool Commit();
+
+private:
+    DISALLOW_COPY_AND_MOVE(StatFileWriter);
+    void Append(std::string_view data);
+    void AppendInt(int64_t value);
+    bool Flush();
+    void Discard();
+    void SyncParentDir();
+
+    std::string path_;
+    std::string tmpPath_;
+    int fd_ = -1;
+    bool isFailed_ = false;
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+};
+} // STORAGE_DAEMON
+} // OHOS
+
+#endif // OHOS_STORAGE_DAEMON_STAT_FILE_WRITER_H
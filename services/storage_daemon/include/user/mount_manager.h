@@ -24,6 +24,7 @@
 #include <vector>
 #include <sys/types.h>
 #include <nocopyable.h>
+#include "utils/process_scanner.h"
 
 namespace OHOS {
 namespace StorageDaemon {
@@ -34,11 +35,6 @@ struct DirInfo {
     gid_t gid;
 };
 
-struct ProcessInfo {
-    int pid;
-    std::string name;
-};
-
 constexpr uid_t OID_ROOT = 0;
 constexpr uid_t OID_SYSTEM = 1000;
 constexpr uid_t OID_FILE_MANAGER = 1006;
@@ -87,18 +83,10 @@ public:
     int32_t UMountDfsDocs(int32_t userId, const std::string &relativePath,
         const std::string &networkId, const std::string &deviceId);
     int32_t UMountAllPath(int32_t userId, std::list<std::string> &mountFailList);
-    int32_t UMountByList(std::list<std::string> &list, std::list<std::string> &mountFailList);
     void SetCloudState(bool active);
     int32_t RestoreconSystemServiceDirs(int32_t userId);
-    int32_t FindMountPointsToMap(std::map<std::string, std::list<std::string>> &mountMap, int32_t userId);
-    void MountPointToList(std::list<std::string> &hmdfsList, std::list<std::string> &hmfsList,
-        std::list<std::string> &sharefsList, std::string &line, int32_t userId);
     int32_t FindAndKillProcess(int32_t userId, std::list<std::string> &mountFailList);
-    bool CheckMaps(const std::string &path, const std::string &prefix, std::list<std::string> &mountFailList);
-    bool CheckSymlink(const std::string &path, const std::string &prefix, std::list<std::string> &mountFailList);
-    bool GetProcessInfo(const std::string &filename, ProcessInfo &info);
     void KillProcess(std::vector<ProcessInfo> &processInfo);
-    bool PidUsingFlag(std::string &pidPath, const std::string &prefix, std::list<std::string> &mountFailList);
     void UmountFailRadar(std::vector<ProcessInfo> &processInfo);
     void MountSandboxPath(const std::vector<std::string> &srcPaths, const std::vector<std::string> &dstPaths,
                           const std::string &bundleName, const std::string &userId);
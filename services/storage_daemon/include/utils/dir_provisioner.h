@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_STORAGE_DAEMON_DIR_PROVISIONER_H
+#define OHOS_STORAGE_DAEMON_DIR_PROVISIONER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+namespace OHOS {
+namespace StorageDaemon {
+/**
+ * Prepares a set of directories in one pass, like PrepareDir does for a single one.
+ *
+ * The paths are arranged as a tree, every dir is created, checked and fixed up relative to the fd of its parent,
+ * and dirs that do not depend on each other are prepared by a few threads in parallel. The fscrypt policy is set
+ * on a dir before anything is created inside it.
+ */
+class DirProvisioner {
+public:
+    enum : uint32_t {
+        DIR_FLAG_NONE = 0,
+        DIR_FLAG_SET_POLICY = 1 << 0,
+        // a failure to prepare it is only logged and the dirs below it are prepared by their paths,
+        // a failure to set its policy is still returned
+        DIR_FLAG_OPTIONAL = 1 << 1,
+    };
+    using PolicyFunc = std::function<int32_t(const std::string &path)>;
+
+    explicit DirProvisioner(const std::string &tag);
+
+    void Add(const std::string &path, mode_t mode, uid_t uid, gid_t gid, uint32_t flags = DIR_FLAG_NONE);
+    void SetPolicyFunc(const PolicyFunc &func)
+    {
+        policy_ = func;
+    }
+    /**
+     * @brief Prepare every added dir, the dirs below a failed one are skipped unless it is optional.
+     * @return E_OK, the error of a failed policy, or E_PREPARE_DIR.
+     */
+    int32_t Run();
+
+private:
+    struct Node {
+        std::string path;
+        mode_t mode;
+        uid_t uid;
+        gid_t gid;
+        uint32_t flags;
+        int64_t parent = -1;
+        std::vector<size_t> children;
+        size_t pending = 0;
+        int fd = -1;
+    };
+
+    void BuildTree();
+    int32_t PrepareNode(Node &node);
+    int32_t SetPolicy(const Node &node);
+    int32_t SetPolicyIfOptional(const Node &node, int32_t err);
+    int CreateDir(int parentFd, const Node &node);
+
+    std::string tag_;
+    PolicyFunc policy_;
+    std::vector<Node> nodes_;
+    std::unordered_map<std::string, size_t> index_;
+};
+} // STORAGE_DAEMON
+} // OHOS
+
+#endif // OHOS_STORAGE_DAEMON_DIR_PROVISIONER_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_STORAGE_DAEMON_PROCESS_SCANNER_H
+#define OHOS_STORAGE_DAEMON_PROCESS_SCANNER_H
+
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+namespace OHOS {
+namespace StorageDaemon {
+struct ProcessInfo {
+    int pid;
+    std::string name;
+};
+
+/**
+ * A set of path prefixes compiled into one sorted table.
+ *
+ * Prefixes covered by a shorter one are dropped, so at most one candidate has to be compared per lookup. With
+ * wholeComponent a prefix only matches itself or a path below it, "/a" matches "/a/b" but not "/ab".
+ */
+class PathPrefixMatcher {
+public:
+    PathPrefixMatcher(const std::vector<std::string> &prefixes, bool wholeComponent);
+
+    bool Match(std::string_view path) const;
+    bool Empty() const
+    {
+        return prefixes_.empty();
+    }
+
+private:
+    std::vector<std::string> prefixes_;
+    bool wholeComponent_;
+};
+
+/**
+ * Finds the processes that use a file under a set of paths, through their maps, cwd, root, exe and optionally
+ * their open fds. The pids are inspected by a few threads in parallel.
+ */
+class ProcessScanner {
+public:
+    ProcessScanner(const PathPrefixMatcher &matcher, bool checkFds);
+
+    int32_t Scan(std::vector<ProcessInfo> &processInfos);
+
+private:
+    bool ListPids(std::vector<pid_t> &pids);
+    bool InspectPid(pid_t pid, ProcessInfo &info);
+    bool ReadName(int pidFd, ProcessInfo &info);
+    bool CheckMaps(int pidFd, pid_t pid);
+    bool CheckSymlink(int dirFd, const char *name, pid_t pid);
+    bool CheckFds(int pidFd, pid_t pid);
+
+    const PathPrefixMatcher &matcher_;
+    bool checkFds_;
+};
+} // STORAGE_DAEMON
+} // OHOS
+
+#endif // OHOS_STORAGE_DAEMON_PROCESS_SCANNER_H
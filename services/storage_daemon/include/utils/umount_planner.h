@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_STORAGE_DAEMON_UMOUNT_PLANNER_H
+#define OHOS_STORAGE_DAEMON_UMOUNT_PLANNER_H
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OHOS {
+namespace StorageDaemon {
+struct MountInfoEntry {
+    int32_t id = 0;
+    int32_t parentId = 0;
+    std::string mountPoint;
+    std::string fsType;
+    std::string source;
+};
+
+/**
+ * Unmounts groups of mounts taken from one parse of /proc/self/mountinfo.
+ *
+ * Within a phase a mount is only unmounted after every selected mount below it, mounts that do not depend on
+ * each other are unmounted by a few threads in parallel. Busy mounts are retried with a short backoff.
+ */
+class UmountPlanner {
+public:
+    using Filter = std::function<bool(const MountInfoEntry &)>;
+    using UmountFunc = std::function<int32_t(const std::string &)>;
+
+    explicit UmountPlanner(const std::string &tag);
+
+    int32_t Load(const std::string &path = "/proc/self/mountinfo");
+    void Parse(const std::string &content);
+    /**
+     * @brief Unmount the mounts accepted by filter, children before their parents.
+     * @return E_OK, or the errno of the last mount that could not be unmounted.
+     */
+    int32_t RunPhase(const std::string &name, const Filter &filter, std::list<std::string> &failList);
+    void Detach(const std::list<std::string> &paths);
+    void ReportTimeline() const;
+
+    const std::vector<MountInfoEntry> &Mounts() const
+    {
+        return mounts_;
+    }
+    // for tests, the default unmounts with umount(2)
+    void SetUmountFunc(const UmountFunc &func)
+    {
+        umount_ = func;
+    }
+
+private:
+    struct PhaseRecord {
+        std::string name;
+        size_t total;
+        size_t failed;
+        int64_t startMs;
+        int64_t endMs;
+    };
+
+    int32_t UmountWithRetry(const std::string &path);
+
+    std::string tag_;
+    int64_t createMs_;
+    UmountFunc umount_;
+    std::vector<MountInfoEntry> mounts_;
+    std::unordered_map<int32_t, size_t> index_;
+    std::vector<PhaseRecord> timeline_;
+};
+} // STORAGE_DAEMON
+} // OHOS
+
+#endif // OHOS_STORAGE_DAEMON_UMOUNT_PLANNER_H
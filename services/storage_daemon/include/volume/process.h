@@ -34,13 +34,6 @@ public:
 private:
     std::string path_;
     std::unordered_set<pid_t> pids_;
-
-    std::string Readlink(std::string path);
-    bool CheckSubDir(std::string line);
-
-    bool CheckMaps(std::string pidPath);
-    bool CheckSymlink(std::string path);
-    bool CheckFds(std::string pidPath);
 };
 } // STORAGE_DAEMON
 } // OHOS
@@ -1204,6 +1204,11 @@ int32_t StorageDaemon::GetOccupiedSpace(int32_t idType, int32_t id, int64_t &siz
     return QuotaManager::GetInstance()->GetOccupiedSpace(idType, id, size);
 }
 
+int32_t StorageDaemon::GetOccupiedSpaceBatch(int32_t idType, std::vector<int32_t> &ids, std::vector<int64_t> &sizes)
+{
+    return QuotaManager::GetInstance()->GetOccupiedSpaceBatch(idType, ids, sizes);
+}
+
 int32_t StorageDaemon::GetBundleStatsForIncrease(uint32_t userId, const std::vector<std::string> &bundleNames,
     const std::vector<int64_t> &incrementalBackTimes, std::vector<int64_t> &pkgFileSizes,
     std::vector<int64_t> &incPkgFileSizes)
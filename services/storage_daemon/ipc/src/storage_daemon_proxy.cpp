@@ -852,6 +852,45 @@ int32_t StorageDaemonProxy::GetOccupiedSpace(int32_t idType, int32_t id, int64_t
     return E_OK;
 }
 
+int32_t StorageDaemonProxy::GetOccupiedSpaceBatch(int32_t idType, std::vector<int32_t> &ids,
+    std::vector<int64_t> &sizes)
+{
+    MessageParcel data;
+    MessageParcel reply;
+    MessageOption option(MessageOption::TF_SYNC);
+    if (!data.WriteInterfaceToken(StorageDaemonProxy::GetDescriptor())) {
+        return E_WRITE_DESCRIPTOR_ERR;
+    }
+
+    if (!data.WriteInt32(idType)) {
+        return E_WRITE_PARCEL_ERR;
+    }
+
+    if (!data.WriteInt32Vector(ids)) {
+        return E_WRITE_PARCEL_ERR;
+    }
+
+    int32_t err = SendRequest(static_cast<int32_t>(StorageDaemonInterfaceCode::GET_SPACE_BATCH), data, reply,
+        option);
+    if (err != E_OK) {
+        LOGE("StorageDaemonProxy::SendRequest call err = %{public}d", err);
+        return err;
+    }
+    err = reply.ReadInt32();
+    if (err != E_OK) {
+        return err;
+    }
+    if (!reply.ReadInt32Vector(&ids)) {
+        LOGE("StorageDaemonProxy::GetOccupiedSpaceBatch read ids failed");
+        return E_WRITE_REPLY_ERR;
+    }
+    if (!reply.ReadInt64Vector(&sizes)) {
+        LOGE("StorageDaemonProxy::GetOccupiedSpaceBatch read sizes failed");
+        return E_WRITE_REPLY_ERR;
+    }
+    return E_OK;
+}
+
 int32_t StorageDaemonProxy::GetBundleStatsForIncrease(uint32_t userId, const std::vector<std::string> &bundleNames,
     const std::vector<int64_t> &incrementalBackTimes, std::vector<int64_t> &pkgFileSizes,
     std::vector<int64_t> &incPkgFileSizes)
@@ -82,6 +82,8 @@ StorageDaemonStub::StorageDaemonStub()
         &StorageDaemonStub::HandleSetBundleQuota;
     opToInterfaceMap_[static_cast<uint32_t>(StorageDaemonInterfaceCode::GET_SPACE)] =
         &StorageDaemonStub::HandleGetOccupiedSpace;
+    opToInterfaceMap_[static_cast<uint32_t>(StorageDaemonInterfaceCode::GET_SPACE_BATCH)] =
+        &StorageDaemonStub::HandleGetOccupiedSpaceBatch;
     opToInterfaceMap_[static_cast<uint32_t>(StorageDaemonInterfaceCode::UPDATE_MEM_PARA)] =
         &StorageDaemonStub::HandleUpdateMemoryPara;
     opToInterfaceMap_[static_cast<uint32_t>(StorageDaemonInterfaceCode::GET_BUNDLE_STATS_INCREASE)] =
@@ -142,6 +144,7 @@ int32_t StorageDaemonStub::OnRemoteRequest(uint32_t code, MessageParcel &data,
         case static_cast<uint32_t>(StorageDaemonInterfaceCode::DELETE_SHARE_FILE):
         case static_cast<uint32_t>(StorageDaemonInterfaceCode::SET_BUNDLE_QUOTA):
         case static_cast<uint32_t>(StorageDaemonInterfaceCode::GET_SPACE):
+        case static_cast<uint32_t>(StorageDaemonInterfaceCode::GET_SPACE_BATCH):
         case static_cast<uint32_t>(StorageDaemonInterfaceCode::UPDATE_MEM_PARA):
         case static_cast<uint32_t>(StorageDaemonInterfaceCode::GET_BUNDLE_STATS_INCREASE):
         case static_cast<uint32_t>(StorageDaemonInterfaceCode::MOUNT_DFS_DOCS):
@@ -237,6 +240,8 @@ int32_t StorageDaemonStub::OnRemoteRequestForApp(uint32_t code, MessageParcel &d
             return HandleSetBundleQuota(data, reply);
         case static_cast<uint32_t>(StorageDaemonInterfaceCode::GET_SPACE):
             return HandleGetOccupiedSpace(data, reply);
+        case static_cast<uint32_t>(StorageDaemonInterfaceCode::GET_SPACE_BATCH):
+            return HandleGetOccupiedSpaceBatch(data, reply);
         case static_cast<uint32_t>(StorageDaemonInterfaceCode::UPDATE_MEM_PARA):
             return HandleUpdateMemoryPara(data, reply);
         case static_cast<uint32_t>(StorageDaemonInterfaceCode::GET_BUNDLE_STATS_INCREASE):
@@ -699,6 +704,29 @@ int32_t StorageDaemonStub::HandleGetOccupiedSpace(MessageParcel &data, MessagePa
     }
     return E_OK;
 }
+
+int32_t StorageDaemonStub::HandleGetOccupiedSpaceBatch(MessageParcel &data, MessageParcel &reply)
+{
+    int32_t idType = data.ReadInt32();
+    std::vector<int32_t> ids;
+    if (!data.ReadInt32Vector(&ids)) {
+        return E_WRITE_REPLY_ERR;
+    }
+    std::vector<int64_t> sizes;
+    int32_t err = GetOccupiedSpaceBatch(idType, ids, sizes);
+    if (!reply.WriteInt32(err)) {
+        return E_WRITE_REPLY_ERR;
+    }
+    if (!reply.WriteInt32Vector(ids)) {
+        LOGE("StorageDaemonStub::HandleGetOccupiedSpaceBatch write ids failed");
+        return E_WRITE_REPLY_ERR;
+    }
+    if (!reply.WriteInt64Vector(sizes)) {
+        LOGE("StorageDaemonStub::HandleGetOccupiedSpaceBatch write sizes failed");
+        return E_WRITE_REPLY_ERR;
+    }
+    return E_OK;
+}
 int32_t StorageDaemonStub::HandleUpdateMemoryPara(MessageParcel &data, MessageParcel &reply)
 {
     int32_t size = data.ReadInt32();
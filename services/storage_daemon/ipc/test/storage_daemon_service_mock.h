@@ -219,6 +219,11 @@ public:
     {
         return E_OK;
     }
+    virtual int32_t GetOccupiedSpaceBatch(int32_t idType, std::vector<int32_t> &ids,
+        std::vector<int64_t> &sizes) override
+    {
+        return E_OK;
+    }
     virtual int32_t UpdateMemoryPara(int32_t size, int32_t &oldSize) override
     {
         return E_OK;
@@ -53,6 +53,7 @@ public:
     MOCK_METHOD3(CreateShareFile, std::vector<int32_t> (const std::vector<std::string> &, uint32_t, uint32_t));
     MOCK_METHOD2(DeleteShareFile, int32_t (uint32_t, const std::vector<std::string> &));
     MOCK_METHOD3(GetOccupiedSpace, int32_t (int32_t, int32_t, int64_t &));
+    MOCK_METHOD3(GetOccupiedSpaceBatch, int32_t (int32_t, std::vector<int32_t> &, std::vector<int64_t> &));
     MOCK_METHOD1(LockUserScreen, int32_t (uint32_t));
     MOCK_METHOD3(UnlockUserScreen, int32_t (uint32_t, const std::vector<uint8_t> &, const std::vector<uint8_t> &));
     MOCK_METHOD2(GetLockScreenStatus, int32_t (uint32_t, bool &));
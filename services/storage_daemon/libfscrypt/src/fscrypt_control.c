@@ -306,53 +306,72 @@ static int ReadKeyFile(const char *path, char *buf, size_t len)
     return 0;
 }
 
-static int SetPolicyLegacy(const char *keyDescPath,
-                           const char *toEncrypt,
-                           union FscryptPolicy *arg)
+static int ReadKeyFileInDir(const char *keyDir, const char *name, uint8_t *buf, size_t len)
 {
-    char keyDesc[FSCRYPT_KEY_DESCRIPTOR_SIZE] = {0};
-    int ret = ReadKeyFile(keyDescPath, keyDesc, FSCRYPT_KEY_DESCRIPTOR_SIZE);
+    char *pathBuf = NULL;
+    int ret = SpliceKeyPath(keyDir, strlen(keyDir), name, strlen(name), &pathBuf);
     if (ret != 0) {
+        LOGE("path splice error");
         return ret;
     }
-    arg->v1.version = FSCRYPT_POLICY_V1;
-    ret = memcpy_s(arg->v1.master_key_descriptor,
-        FSCRYPT_KEY_DESCRIPTOR_SIZE, keyDesc, FSCRYPT_KEY_DESCRIPTOR_SIZE);
+    ret = ReadKeyFile(pathBuf, (char *)buf, len);
+    free(pathBuf);
+    return ret;
+}
+
+int LoadPolicyHandle(const char *keyDir, struct FscryptPolicyHandle *handle)
+{
+    if (!keyDir || !handle) {
+        LOGE("load policy parameters is null");
+        return -EINVAL;
+    }
+    (void)memset_s(handle, sizeof(*handle), 0, sizeof(*handle));
+    int ret = InitFscryptPolicy();
     if (ret != 0) {
-        LOGE("memcpy_s copy failed");
+        LOGE("Get fscrypt policy error %d", ret);
         return ret;
     }
-    if (!KeyCtrlSetPolicy(toEncrypt, arg)) {
-        LOGE("Set Policy v1 failed");
-        return -EFAULT;
+
+    handle->policy.v1.filenames_encryption_mode = g_fscryptPolicy.fileName;
+    handle->policy.v1.contents_encryption_mode = g_fscryptPolicy.content;
+    handle->policy.v1.flags = g_fscryptPolicy.flags;
+    ret = -ENOTSUP;
+    uint8_t fscryptVer = KeyCtrlLoadVersion(keyDir);
+    if (fscryptVer == FSCRYPT_V1) {
+        handle->policy.v1.version = FSCRYPT_POLICY_V1;
+        ret = ReadKeyFileInDir(keyDir, PATH_KEYDESC, handle->policy.v1.master_key_descriptor,
+            FSCRYPT_KEY_DESCRIPTOR_SIZE);
+#ifdef SUPPORT_FSCRYPT_V2
+    } else if (fscryptVer == FSCRYPT_V2) {
+        handle->policy.v2.version = FSCRYPT_POLICY_V2;
+        ret = ReadKeyFileInDir(keyDir, PATH_KEYID, handle->policy.v2.master_key_identifier,
+            FSCRYPT_KEY_IDENTIFIER_SIZE);
+#endif
+    }
+    if (ret != 0) {
+        LOGE("load policy v%u fail, ret: %d", fscryptVer, ret);
+        return ret;
     }
+    handle->version = fscryptVer;
     return 0;
 }
 
-#ifdef SUPPORT_FSCRYPT_V2
-static int SetPolicyV2(const char *keyIdPath,
-                       const char *toEncrypt,
-                       union FscryptPolicy *arg)
+int SetPolicyByHandle(const struct FscryptPolicyHandle *handle, const char *dir)
 {
-    char keyId[FSCRYPT_KEY_IDENTIFIER_SIZE] = {0};
-    int ret = ReadKeyFile(keyIdPath, keyId, FSCRYPT_KEY_IDENTIFIER_SIZE);
-    if (ret != 0) {
-        return ret;
+    if (!handle || !dir) {
+        LOGE("set policy parameters is null");
+        return -EINVAL;
     }
-    arg->v2.version = FSCRYPT_POLICY_V2;
-    ret = memcpy_s(arg->v2.master_key_identifier,
-        FSCRYPT_KEY_IDENTIFIER_SIZE, keyId, FSCRYPT_KEY_IDENTIFIER_SIZE);
-    if (ret != 0) {
-        LOGE("memcpy_s copy failed");
-        return ret;
+    if (handle->version == FSCRYPT_INVALID) {
+        return -ENOTSUP;
     }
-    if (!KeyCtrlSetPolicy(toEncrypt, arg)) {
-        LOGE("Set Policy v2 failed");
+    union FscryptPolicy arg = handle->policy;
+    if (!KeyCtrlSetPolicy(dir, &arg)) {
+        LOGE("Set Policy v%u failed", handle->version);
         return -EFAULT;
     }
     return 0;
 }
-#endif
 
 int LoadAndSetPolicy(const char *keyDir, const char *dir)
 {
@@ -360,53 +379,12 @@ int LoadAndSetPolicy(const char *keyDir, const char *dir)
         LOGE("set policy parameters is null");
         return -EINVAL;
     }
-    int ret = InitFscryptPolicy();
+    struct FscryptPolicyHandle handle;
+    int ret = LoadPolicyHandle(keyDir, &handle);
     if (ret != 0) {
-        LOGE("Get fscrypt policy error %d", ret);
         return ret;
     }
-
-    union FscryptPolicy arg;
-    (void)memset_s(&arg, sizeof(arg), 0, sizeof(arg));
-    arg.v1.filenames_encryption_mode = g_fscryptPolicy.fileName;
-    arg.v1.contents_encryption_mode = g_fscryptPolicy.content;
-    arg.v1.flags = g_fscryptPolicy.flags;
-
-    char *pathBuf = NULL;
-    ret = -ENOTSUP;
-
-    uint8_t fscryptVer = KeyCtrlLoadVersion(keyDir);
-    if (fscryptVer == FSCRYPT_V1) {
-        ret = SpliceKeyPath(keyDir, strlen(keyDir), PATH_KEYDESC,
-            strlen(PATH_KEYDESC), &pathBuf);
-        if (ret != 0) {
-            LOGE("path splice error");
-            return ret;
-        }
-        ret = SetPolicyLegacy(pathBuf, dir, &arg);
-        if (ret != 0) {
-            LOGE("SetPolicyLegacy fail, ret: %d", ret);
-        }
-#ifdef SUPPORT_FSCRYPT_V2
-    } else if (fscryptVer == FSCRYPT_V2) {
-        ret = SpliceKeyPath(keyDir, strlen(keyDir), PATH_KEYID,
-            strlen(PATH_KEYID), &pathBuf);
-        if (ret != 0) {
-            LOGE("path splice error");
-            return ret;
-        }
-        ret = SetPolicyV2(pathBuf, dir, &arg);
-        if (ret != 0) {
-            LOGE("SetPolicyV2 fail, ret: %d", ret);
-        }
-#endif
-    }
-    if (pathBuf != NULL) {
-        free(pathBuf);
-        pathBuf = NULL;
-    }
-
-    return ret;
+    return SetPolicyByHandle(&handle, dir);
 }
 
 static int ActSetFileXattrActSetFileXattr(const char *path, char *keyDesc, int storageType)
@@ -439,49 +417,63 @@ static int ActSetFileXattrActSetFileXattr(const char *path, char *keyDesc, int s
     return ret;
 }
 
-int LoadAndSetEceAndSecePolicy(const char *keyDir, const char *dir, int type)
+int LoadEceAndSecePolicyHandle(const char *keyDir, struct FscryptPolicyHandle *handle)
+{
+    if (!keyDir || !handle) {
+        LOGE("load policy parameters is null");
+        return -EINVAL;
+    }
+    (void)memset_s(handle, sizeof(*handle), 0, sizeof(*handle));
+    // only v1 keys need the sdp policy, with v2 there is nothing to load
+    uint8_t fscryptVer = KeyCtrlLoadVersion(keyDir);
+    if (fscryptVer == FSCRYPT_V1) {
+        int ret = ReadKeyFileInDir(keyDir, PATH_KEYDESC, handle->policy.v1.master_key_descriptor,
+            FSCRYPT_KEY_DESCRIPTOR_SIZE);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+    handle->version = fscryptVer;
+    return 0;
+}
+
+int SetEceAndSecePolicyByHandle(const struct FscryptPolicyHandle *handle, const char *dir, int type)
 {
     int el3Key = 3; // el3
     int el4Key = 4; // el4
-    if (!keyDir || !dir) {
+    if (!handle || !dir) {
         LOGE("set policy parameters is null");
         return -EINVAL;
     }
-    char *pathBuf = NULL;
-    int ret = SpliceKeyPath(keyDir, strlen(keyDir), PATH_KEYDESC, strlen(PATH_KEYDESC), &pathBuf);
+    if (handle->version != FSCRYPT_V1 || (type != el3Key && type != el4Key)) {
+        return 0;
+    }
+    int storageType = (type == el3Key) ? FSCRYPT_SDP_SECE_CLASS : FSCRYPT_SDP_ECE_CLASS;
+    int ret = ActSetFileXattrActSetFileXattr(dir, (char *)handle->policy.v1.master_key_descriptor, storageType);
     if (ret != 0) {
-        LOGE("path splice error");
+        LOGE("ActSetFileXattr failed");
         return ret;
     }
+    return 0;
+}
 
-    uint8_t fscryptVer = KeyCtrlLoadVersion(keyDir);
-    if (fscryptVer == FSCRYPT_V1) {
-        if (type == el3Key || type == el4Key) {
-            if (type == el3Key) {
-                type = FSCRYPT_SDP_SECE_CLASS;
-            } else {
-                type = FSCRYPT_SDP_ECE_CLASS;
-            }
-            char keyDesc[FSCRYPT_KEY_DESCRIPTOR_SIZE] = {0};
-            ret = ReadKeyFile(pathBuf, keyDesc, FSCRYPT_KEY_DESCRIPTOR_SIZE);
-            if (ret != 0) {
-                return ret;
-            }
-            ret = ActSetFileXattrActSetFileXattr(dir, keyDesc, type);
-            if (ret != 0) {
-                LOGE("ActSetFileXattr failed");
-                return ret;
-            }
-        }
-#ifdef SUPPORT_FSCRYPT_V2
-    } else if (fscryptVer == FSCRYPT_V2) {
+int LoadAndSetEceAndSecePolicy(const char *keyDir, const char *dir, int type)
+{
+    int el3Key = 3; // el3
+    int el4Key = 4; // el4
+    if (!keyDir || !dir) {
+        LOGE("set policy parameters is null");
+        return -EINVAL;
+    }
+    if (type != el3Key && type != el4Key) {
         return 0;
-#endif
     }
-    if (pathBuf != NULL) {
-        free(pathBuf);
+    struct FscryptPolicyHandle handle;
+    int ret = LoadEceAndSecePolicyHandle(keyDir, &handle);
+    if (ret != 0) {
+        return ret;
     }
-    return ret;
+    return SetEceAndSecePolicyByHandle(&handle, dir, type);
 }
 
 int SetGlobalEl1DirPolicy(const char *dir)
@@ -51,4 +51,36 @@ int LoadAndSetEceAndSecePolicy(const char *keyDir, const char *dir, int type)
         return false;
     }
     return IFscryptControlMoc::fscryptControlMoc->LoadAndSetEceAndSecePolicy(keyDir, dir, type);
-}
\ No newline at end of file
+}
+
+int LoadPolicyHandle(const char *keyDir, struct FscryptPolicyHandle *handle)
+{
+    if (IFscryptControlMoc::fscryptControlMoc == nullptr) {
+        return false;
+    }
+    return IFscryptControlMoc::fscryptControlMoc->LoadPolicyHandle(keyDir, handle);
+}
+
+int SetPolicyByHandle(const struct FscryptPolicyHandle *handle, const char *dir)
+{
+    if (IFscryptControlMoc::fscryptControlMoc == nullptr) {
+        return false;
+    }
+    return IFscryptControlMoc::fscryptControlMoc->SetPolicyByHandle(handle, dir);
+}
+
+int LoadEceAndSecePolicyHandle(const char *keyDir, struct FscryptPolicyHandle *handle)
+{
+    if (IFscryptControlMoc::fscryptControlMoc == nullptr) {
+        return false;
+    }
+    return IFscryptControlMoc::fscryptControlMoc->LoadEceAndSecePolicyHandle(keyDir, handle);
+}
+
+int SetEceAndSecePolicyByHandle(const struct FscryptPolicyHandle *handle, const char *dir, int type)
+{
+    if (IFscryptControlMoc::fscryptControlMoc == nullptr) {
+        return false;
+    }
+    return IFscryptControlMoc::fscryptControlMoc->SetEceAndSecePolicyByHandle(handle, dir, type);
+}
@@ -15,32 +15,45 @@
 
 #include "mtp/mtp_device_monitor.h"
 
-#include <cstdio>
-#include <dirent.h>
+#include <chrono>
+#include <cstdlib>
 #include <filesystem>
-#include <iostream>
+#include <iomanip>
 #include <libmtp.h>
-#include <sys/stat.h>
+#include <random>
+#include <sstream>
 #include <sys/types.h>
-#include <unistd.h>
 #include <thread>
 #include "storage_service_errno.h"
 #include "storage_service_log.h"
-#include "utils/cmd_utils.h"
 #include "utils/file_utils.h"
 
 using namespace std;
 namespace OHOS {
 namespace StorageDaemon {
-static constexpr int32_t SLEEP_TIME = 1;
+// the usb device node may not be accessible yet when the uevent arrives
+static constexpr int32_t DETECT_RETRY_TIMES = 5;
+static constexpr std::chrono::milliseconds DETECT_RETRY_INTERVAL(100);
+// without uevents the devices are polled, a removed device that failed to umount is checked again as often
+static constexpr std::chrono::seconds CHECK_INTERVAL(1);
+#ifdef EXTERNAL_STORAGE_MANAGER
+static constexpr bool UEVENT_SUPPORTED = true;
+#else
+static constexpr bool UEVENT_SUPPORTED = false;
+#endif
+static constexpr int32_t UUID_BYTES = 16;
+static constexpr int32_t UUID_VERSION_BYTE = 6;
+static constexpr int32_t UUID_VARIANT_BYTE = 8;
 const std::string MTP_ROOT_PATH = "/mnt/data/external/";
-bool g_keepMonitoring = true;
+const std::string USB_DEVICE_TYPE = "usb_device";
+std::atomic<bool> g_keepMonitoring = true;
 
 MtpDeviceMonitor::MtpDeviceMonitor() {}
 
 MtpDeviceMonitor::~MtpDeviceMonitor()
 {
     LOGI("MtpDeviceMonitor Destructor.");
+    StopMonitor();
     UmountAllMtpDevice();
 }
 
@@ -50,49 +63,159 @@ void MtpDeviceMonitor::StartMonitor()
     std::thread([this]() { MonitorDevice(); }).detach();
 }
 
+void MtpDeviceMonitor::StopMonitor()
+{
+    {
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        g_keepMonitoring = false;
+    }
+    eventCond_.notify_all();
+}
+
+void MtpDeviceMonitor::Rescan()
+{
+    {
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        rescan_ = true;
+    }
+    eventCond_.notify_one();
+}
+
+void MtpDeviceMonitor::HandleUsbEvent(NetlinkData *data)
+{
+    NetlinkData::Actions action = data->GetAction();
+    if ((action != NetlinkData::Actions::ADD && action != NetlinkData::Actions::REMOVE) ||
+        data->GetParamView("DEVTYPE") != USB_DEVICE_TYPE) {
+        return;
+    }
+    std::string busNum = data->GetParam("BUSNUM");
+    std::string devNum = data->GetParam("DEVNUM");
+    if (busNum.empty() || devNum.empty()) {
+        return;
+    }
+    UsbEvent event = { action, static_cast<uint32_t>(std::strtoul(busNum.c_str(), nullptr, 10)),
+        static_cast<uint32_t>(std::strtoul(devNum.c_str(), nullptr, 10)) };
+    LOGI("usb device %{public}u-%{public}u %{public}s.", event.busNum, event.devNum,
+        action == NetlinkData::Actions::ADD ? "attached" : "detached");
+    {
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        events_.push_back(event);
+    }
+    eventCond_.notify_one();
+}
+
 void MtpDeviceMonitor::MonitorDevice()
 {
     LOGI("MonitorDevice: mtp device monitor thread begin.");
+    // devices attached before the daemon started do not send an uevent any more
+    DetectRawDevices(nullptr);
     while (g_keepMonitoring) {
-        sleep(SLEEP_TIME);
+        UsbEvent event;
+        if (WaitEvent(event)) {
+            if (event.action == NetlinkData::Actions::REMOVE) {
+                UmountRemovedMtpDevice(event);
+            } else {
+                DetectMtpDevice(event);
+            }
+            continue;
+        }
+        if (!g_keepMonitoring) {
+            break;
+        }
         CheckAndUmountRemovedMtpDevice();
+        if (rescan_.exchange(false) || !UEVENT_SUPPORTED) {
+            DetectRawDevices(nullptr);
+        }
+    }
+    LOGI("MonitorDevice: mtp device monitor thread end.");
+}
 
-        int rawDevSize;
-        LIBMTP_raw_device_t *rawDevices;
-        LIBMTP_error_number_t err = LIBMTP_Detect_Raw_Devices(&rawDevices, &rawDevSize);
-        if ((err == LIBMTP_ERROR_NO_DEVICE_ATTACHED) || (rawDevices == nullptr) || (rawDevSize <= 0)) {
-            continue;
+bool MtpDeviceMonitor::WaitEvent(UsbEvent &event)
+{
+    std::unique_lock<std::mutex> lock(eventMutex_);
+    auto ready = [this] { return !events_.empty() || rescan_ || !g_keepMonitoring; };
+    if (UEVENT_SUPPORTED && !umountRetry_) {
+        eventCond_.wait(lock, ready);
+    } else {
+        eventCond_.wait_for(lock, CHECK_INTERVAL, ready);
+    }
+    if (events_.empty()) {
+        return false;
+    }
+    event = events_.front();
+    events_.pop_front();
+    return true;
+}
+
+void MtpDeviceMonitor::DetectMtpDevice(const UsbEvent &event)
+{
+    for (int32_t i = 0; i < DETECT_RETRY_TIMES; i++) {
+        if (DetectRawDevices(&event)) {
+            return;
         }
+        std::this_thread::sleep_for(DETECT_RETRY_INTERVAL);
+    }
+    LOGI("usb device %{public}u-%{public}u is not a mtp device.", event.busNum, event.devNum);
+}
 
-        std::vector<MtpDeviceInfo> devInfos;
-        for (int index = 0; index < rawDevSize; ++index) {
-            LIBMTP_raw_device_t *rawDevice = &rawDevices[index];
-            if (rawDevice == nullptr) {
-                LOGE("MonitorDevice: rawDevice is nullptr.");
-                continue;
-            }
-            std::string cmd = "cat /proc/sys/kernel/random/uuid";
-            std::vector<string> uuids;
-            CmdUtils::GetInstance().RunCmd(cmd, uuids);
-
-            MtpDeviceInfo devInfo;
-            devInfo.uuid = uuids.front();
-            devInfo.devNum = rawDevice->devnum;
-            devInfo.busLocation = rawDevice->bus_location;
-            devInfo.vendor = rawDevice->device_entry.vendor;
-            devInfo.product = rawDevice->device_entry.product;
-            devInfo.vendorId = rawDevice->device_entry.vendor_id;
-            devInfo.productId = rawDevice->device_entry.product_id;
-            devInfo.id = "mtp-" + std::to_string(devInfo.vendorId) + "-" + std::to_string(devInfo.productId);
-            devInfo.path = MTP_ROOT_PATH + devInfo.id;
-            devInfos.push_back(devInfo);
-            LOGI("Detect new mtp device: id=%{public}s, vendor=%{public}s, product=%{public}s, devNum=%{public}d",
-                (devInfo.id).c_str(), (devInfo.vendor).c_str(), (devInfo.product).c_str(), devInfo.devNum);
-        }
-        MountMtpDevice(devInfos);
+bool MtpDeviceMonitor::DetectRawDevices(const UsbEvent *event)
+{
+    int rawDevSize = 0;
+    LIBMTP_raw_device_t *rawDevices = nullptr;
+    LIBMTP_error_number_t err = LIBMTP_Detect_Raw_Devices(&rawDevices, &rawDevSize);
+    if ((err == LIBMTP_ERROR_NO_DEVICE_ATTACHED) || (rawDevices == nullptr) || (rawDevSize <= 0)) {
         free(static_cast<void *>(rawDevices));
+        return false;
     }
-    LOGI("MonitorDevice: mtp device monitor thread end.");
+
+    std::vector<MtpDeviceInfo> devInfos;
+    for (int index = 0; index < rawDevSize; ++index) {
+        LIBMTP_raw_device_t *rawDevice = &rawDevices[index];
+        if (event != nullptr && (rawDevice->bus_location != event->busNum || rawDevice->devnum != event->devNum)) {
+            continue;
+        }
+        MtpDeviceInfo devInfo;
+        devInfo.uuid = GenerateUuid();
+        devInfo.devNum = rawDevice->devnum;
+        devInfo.busLocation = rawDevice->bus_location;
+        devInfo.vendor = rawDevice->device_entry.vendor;
+        devInfo.product = rawDevice->device_entry.product;
+        devInfo.vendorId = rawDevice->device_entry.vendor_id;
+        devInfo.productId = rawDevice->device_entry.product_id;
+        devInfo.id = "mtp-" + std::to_string(devInfo.vendorId) + "-" + std::to_string(devInfo.productId);
+        devInfo.path = MTP_ROOT_PATH + devInfo.id;
+        devInfos.push_back(devInfo);
+        LOGI("Detect new mtp device: id=%{public}s, vendor=%{public}s, product=%{public}s, devNum=%{public}d",
+            (devInfo.id).c_str(), (devInfo.vendor).c_str(), (devInfo.product).c_str(), devInfo.devNum);
+    }
+    free(static_cast<void *>(rawDevices));
+    if (devInfos.empty()) {
+        return false;
+    }
+    MountMtpDevice(devInfos);
+    return true;
+}
+
+std::string MtpDeviceMonitor::GenerateUuid()
+{
+    std::random_device rd;
+    std::uniform_int_distribution<uint32_t> dist(0, UINT8_MAX);
+    uint8_t bytes[UUID_BYTES];
+    for (int32_t i = 0; i < UUID_BYTES; i++) {
+        bytes[i] = static_cast<uint8_t>(dist(rd));
+    }
+    // random uuid, version 4 and variant 1 as in RFC 4122
+    bytes[UUID_VERSION_BYTE] = (bytes[UUID_VERSION_BYTE] & 0x0f) | 0x40;
+    bytes[UUID_VARIANT_BYTE] = (bytes[UUID_VARIANT_BYTE] & 0x3f) | 0x80;
+    std::ostringstream uuid;
+    uuid << std::hex << std::setfill('0');
+    for (int32_t i = 0; i < UUID_BYTES; i++) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            uuid << '-';
+        }
+        uuid << std::setw(2) << static_cast<uint32_t>(bytes[i]);
+    }
+    return uuid.str();
 }
 
 void MtpDeviceMonitor::MountMtpDevice(const std::vector<MtpDeviceInfo> &monitorDevices)
@@ -135,14 +258,31 @@ void MtpDeviceMonitor::UmountAllMtpDevice()
     lastestMtpDevList_.clear();
 }
 
+void MtpDeviceMonitor::UmountRemovedMtpDevice(const UsbEvent &event)
+{
+    std::lock_guard<std::mutex> lock(listMutex_);
+    for (auto iter = lastestMtpDevList_.begin(); iter != lastestMtpDevList_.end(); iter++) {
+        if (iter->busLocation != event.busNum || iter->devNum != event.devNum) {
+            continue;
+        }
+        LOGI("Mtp device mount path=%{public}s is removed, umount it.", (iter->path).c_str());
+        int32_t ret = DelayedSingleton<MtpDeviceManager>::GetInstance()->UmountDevice(*iter);
+        if (ret == E_OK) {
+            lastestMtpDevList_.erase(iter);
+        } else {
+            LOGE("Umount mtp device failed, path=%{public}s, retry later", (iter->path).c_str());
+            umountRetry_ = true;
+        }
+        return;
+    }
+}
+
 void MtpDeviceMonitor::CheckAndUmountRemovedMtpDevice()
 {
-    LOGI("Start check and umount removed mtp devices, lastestMtpDevList size=%{public}zu", lastestMtpDevList_.size());
     std::lock_guard<std::mutex> lock(listMutex_);
+    bool failed = false;
     for (auto iter = lastestMtpDevList_.begin(); iter != lastestMtpDevList_.end();) {
         int res = LIBMTP_Check_Specific_Device(iter->busLocation, iter->devNum);
-        LOGI("Check mtp device state result=%{public}d, devNum=%{public}d, busLocation=%{public}d.", res,
-            iter->devNum, iter->busLocation);
         if (IsDir(iter->path) && !std::filesystem::is_empty(iter->path) && (res > 0)) {
             iter++;
             continue;
@@ -154,9 +294,11 @@ void MtpDeviceMonitor::CheckAndUmountRemovedMtpDevice()
             iter = lastestMtpDevList_.erase(iter);
         } else {
             LOGE("Umount mtp device failed, path=%{public}s", (iter->path).c_str());
+            failed = true;
             iter++;
         }
     }
+    umountRetry_ = failed;
 }
 
 int32_t MtpDeviceMonitor::Mount(const std::string &id)
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "mtp/mtp_device_monitor.h"
+#include "netlink/netlink_data.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+using namespace testing::ext;
+
+namespace {
+const char *USB_ADD = "ACTION=add\0SUBSYSTEM=usb\0DEVTYPE=usb_device\0BUSNUM=001\0DEVNUM=005\0";
+const char *USB_REMOVE = "ACTION=remove\0SUBSYSTEM=usb\0DEVTYPE=usb_device\0BUSNUM=001\0DEVNUM=005\0";
+const char *USB_INTERFACE = "ACTION=add\0SUBSYSTEM=usb\0DEVTYPE=usb_interface\0BUSNUM=001\0DEVNUM=005\0";
+const char *USB_BIND = "ACTION=bind\0SUBSYSTEM=usb\0DEVTYPE=usb_device\0BUSNUM=001\0DEVNUM=005\0";
+const char *USB_NO_DEVNUM = "ACTION=add\0SUBSYSTEM=usb\0DEVTYPE=usb_device\0BUSNUM=001\0";
+const std::string NOT_MOUNTED_PATH = "/mnt/data/external/mtp-test-not-mounted";
+}
+
+class MtpDeviceMonitorTest : public testing::Test {
+public:
+    static void SetUpTestCase(void) {};
+    static void TearDownTestCase(void) {};
+    void SetUp()
+    {
+        monitor_ = DelayedSingleton<MtpDeviceMonitor>::GetInstance();
+        monitor_->events_.clear();
+        monitor_->lastestMtpDevList_.clear();
+        monitor_->umountRetry_ = false;
+    };
+    void TearDown()
+    {
+        monitor_->events_.clear();
+        monitor_->lastestMtpDevList_.clear();
+    };
+
+    void HandleMsg(const char *msg)
+    {
+        NetlinkData data;
+        data.Decode(msg);
+        monitor_->HandleUsbEvent(&data);
+    }
+
+    static MtpDeviceInfo NotMountedDevice()
+    {
+        MtpDeviceInfo device;
+        device.id = "mtp-test-not-mounted";
+        device.path = NOT_MOUNTED_PATH;
+        device.busLocation = 1;
+        device.devNum = 5;
+        device.vendorId = 0;
+        device.productId = 0;
+        return device;
+    }
+
+    std::shared_ptr<MtpDeviceMonitor> monitor_;
+};
+
+/**
+ * @tc.name: MtpDeviceMonitorTest_HandleUsbEvent_001
+ * @tc.desc: Verify that only the add and remove uevents of usb devices are queued with their bus and dev numbers.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpDeviceMonitorTest, MtpDeviceMonitorTest_HandleUsbEvent_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpDeviceMonitorTest_HandleUsbEvent_001 start";
+    HandleMsg(USB_INTERFACE);
+    HandleMsg(USB_BIND);
+    HandleMsg(USB_NO_DEVNUM);
+    EXPECT_TRUE(monitor_->events_.empty());
+
+    HandleMsg(USB_ADD);
+    HandleMsg(USB_REMOVE);
+    ASSERT_EQ(monitor_->events_.size(), 2);
+    EXPECT_EQ(monitor_->events_[0].action, NetlinkData::Actions::ADD);
+    EXPECT_EQ(monitor_->events_[0].busNum, 1);
+    EXPECT_EQ(monitor_->events_[0].devNum, 5);
+    EXPECT_EQ(monitor_->events_[1].action, NetlinkData::Actions::REMOVE);
+
+    MtpDeviceMonitor::UsbEvent event;
+    EXPECT_TRUE(monitor_->WaitEvent(event));
+    EXPECT_EQ(event.action, NetlinkData::Actions::ADD);
+    EXPECT_TRUE(monitor_->WaitEvent(event));
+    EXPECT_EQ(event.action, NetlinkData::Actions::REMOVE);
+    EXPECT_TRUE(monitor_->events_.empty());
+    GTEST_LOG_(INFO) << "MtpDeviceMonitorTest_HandleUsbEvent_001 end";
+}
+
+/**
+ * @tc.name: MtpDeviceMonitorTest_UmountRemovedMtpDevice_001
+ * @tc.desc: Verify that a remove event only umounts the device with the same bus and dev numbers.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpDeviceMonitorTest, MtpDeviceMonitorTest_UmountRemovedMtpDevice_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpDeviceMonitorTest_UmountRemovedMtpDevice_001 start";
+    monitor_->lastestMtpDevList_.push_back(NotMountedDevice());
+
+    MtpDeviceMonitor::UsbEvent other = { NetlinkData::Actions::REMOVE, 2, 5 };
+    monitor_->UmountRemovedMtpDevice(other);
+    EXPECT_EQ(monitor_->lastestMtpDevList_.size(), 1);
+
+    MtpDeviceMonitor::UsbEvent removed = { NetlinkData::Actions::REMOVE, 1, 5 };
+    monitor_->UmountRemovedMtpDevice(removed);
+    EXPECT_TRUE(monitor_->lastestMtpDevList_.empty());
+    EXPECT_FALSE(monitor_->umountRetry_);
+    GTEST_LOG_(INFO) << "MtpDeviceMonitorTest_UmountRemovedMtpDevice_001 end";
+}
+
+/**
+ * @tc.name: MtpDeviceMonitorTest_CheckAndUmountRemovedMtpDevice_001
+ * @tc.desc: Verify that the periodic check umounts a device that is gone and clears the retry flag.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpDeviceMonitorTest, MtpDeviceMonitorTest_CheckAndUmountRemovedMtpDevice_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpDeviceMonitorTest_CheckAndUmountRemovedMtpDevice_001 start";
+    monitor_->lastestMtpDevList_.push_back(NotMountedDevice());
+    monitor_->umountRetry_ = true;
+
+    monitor_->CheckAndUmountRemovedMtpDevice();
+    EXPECT_TRUE(monitor_->lastestMtpDevList_.empty());
+    EXPECT_FALSE(monitor_->umountRetry_);
+    GTEST_LOG_(INFO) << "MtpDeviceMonitorTest_CheckAndUmountRemovedMtpDevice_001 end";
+}
+
+/**
+ * @tc.name: MtpDeviceMonitorTest_WaitEvent_001
+ * @tc.desc: Verify that a stopped monitor does not wait for events.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpDeviceMonitorTest, MtpDeviceMonitorTest_WaitEvent_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpDeviceMonitorTest_WaitEvent_001 start";
+    monitor_->StopMonitor();
+    MtpDeviceMonitor::UsbEvent event;
+    EXPECT_FALSE(monitor_->WaitEvent(event));
+    GTEST_LOG_(INFO) << "MtpDeviceMonitorTest_WaitEvent_001 end";
+}
+} // STORAGE_DAEMON
+} // OHOS
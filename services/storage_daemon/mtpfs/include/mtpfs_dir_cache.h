@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MTPFS_DIR_CACHE_H
+#define MTPFS_DIR_CACHE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Bookkeeping for the fetched folder listings of the metadata tree.
+ *
+ * Tracks the last use and the entry count of every fetched folder to keep the tree within a memory budget,
+ * queues the folders to prefetch in the background and counts hits, misses and fetch latency. The tree itself
+ * is owned and modified by MtpFsDevice. Modification dates set through utimens only live in the tree, they are
+ * kept here by object id so a listing fetched again after an eviction gets them back.
+ */
+class MtpFsDirCache {
+public:
+    MtpFsDirCache();
+
+    void Touch(const std::string &path);
+    void RecordHit();
+    // returns true when the cached listings exceed the budget and some have to be evicted
+    bool RecordFetch(const std::string &path, size_t entries, uint64_t costUs, bool prefetch);
+    bool PickVictims(std::vector<std::string> &victims);
+    void Evicted(const std::string &path);
+
+    void SetLocalMtime(uint32_t id, time_t mtime);
+    bool LocalMtime(uint32_t id, time_t &mtime);
+    void DropLocalMtime(uint32_t id);
+
+    void PushPrefetch(const std::vector<std::string> &paths, uint32_t depth, bool boost);
+    bool WaitPrefetch(std::string &path, uint32_t &depth);
+    void Stop();
+    bool IsStopped();
+
+private:
+    struct DirEntry {
+        uint64_t lastUse = 0;
+        size_t entries = 0;
+    };
+    struct PrefetchTask {
+        std::string path;
+        uint32_t depth;
+    };
+
+    void DumpStatsLocked();
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::map<std::string, DirEntry> dirs_;
+    std::deque<PrefetchTask> queue_;
+    std::map<uint32_t, time_t> localMtimes_;
+    uint64_t useClock_;
+    size_t totalEntries_;
+    bool evictPending_;
+    bool stop_;
+
+    uint64_t hits_;
+    uint64_t misses_;
+    uint64_t prefetched_;
+    uint64_t evicted_;
+    uint64_t fetchTimeUs_;
+    uint64_t maxFetchUs_;
+};
+
+#endif // MTPFS_DIR_CACHE_H
@@ -16,6 +16,16 @@
 #ifndef MTPFS_MTP_DEVICE_H
 #define MTPFS_MTP_DEVICE_H
 
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+
+#include "mtpfs_dir_cache.h"
+#include "mtpfs_read_cache.h"
+#include "mtpfs_transfer_stats.h"
 #include "mtpfs_type_dir.h"
 #include "mtpfs_type_file.h"
 
@@ -57,6 +67,31 @@ public:
         bool editObjects_;
     };
 
+    /*
+     * Keeps the nodes of the metadata tree alive while pointers into it are used. Lookups take it shared,
+     * removals and renames take it exclusive. It is never held exclusive across a USB transaction.
+     */
+    class TreeLock {
+    public:
+        explicit TreeLock(MtpFsDevice &device, bool exclusive = false) : device_(device)
+        {
+            if (exclusive) {
+                pthread_rwlock_wrlock(&device_.treeLock_);
+            } else {
+                pthread_rwlock_rdlock(&device_.treeLock_);
+            }
+        }
+        ~TreeLock()
+        {
+            pthread_rwlock_unlock(&device_.treeLock_);
+        }
+        TreeLock(const TreeLock &) = delete;
+        TreeLock &operator = (const TreeLock &) = delete;
+
+    private:
+        MtpFsDevice &device_;
+    };
+
     MtpFsDevice();
     ~MtpFsDevice();
 
@@ -76,6 +111,7 @@ public:
     int DirCreateNew(const std::string &path);
     int DirRemove(const std::string &path);
     int DirReName(const std::string &oldPath, const std::string &newPath);
+    // the caller holds a TreeLock for as long as it uses the returned dir
     const MtpFsTypeDir *DirFetchContent(std::string path);
 
     int ReName(const std::string &oldPath, const std::string &newPath);
@@ -84,15 +120,22 @@ public:
     int FileWrite(const std::string &path, const char *buf, size_t size, off_t offset);
     int FilePull(const std::string &src, const std::string &dst);
     int FilePush(const std::string &src, const std::string &dst);
+    int FileWriteBack(const std::string &src, const std::string &dst, const std::map<uint64_t, uint64_t> &dirtyRanges);
     int FileRemove(const std::string &path);
     int FileRename(const std::string &oldPath, const std::string &newPath);
+    int FileSetModificationDate(const std::string &path, time_t mtime);
+    void FileReleaseCache(const std::string &path);
 
     Capabilities GetCapabilities() const;
 
 private:
-    void CriticalEnter()
+    void CriticalEnter(bool background = false)
     {
         deviceMutex_.lock();
+        if (!background) {
+            lastForegroundIo_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
     }
     void CriticalLeave()
     {
@@ -103,15 +146,31 @@ private:
     static Capabilities GetCapabilities(const MtpFsDevice &device);
     bool ConvertErrorCode(LIBMTP_error_number_t err);
     const void HandleDir(LIBMTP_file_t *content, MtpFsTypeDir *dir);
+    void FetchDirContent(const std::string &path, MtpFsTypeDir *dir, uint32_t depth, bool prefetch);
+    void StartPrefetchWorker();
+    void PrefetchWorker();
+    bool WaitForegroundIdle();
+    void EvictDirs();
+    MtpFsTypeDir *DirLookup(std::string path, bool fetch);
+    bool FileLookup(const std::string &path, uint32_t &id, uint64_t &size, int &err);
     void HandleDevNum(const std::string &devFile, int &devNo, int rawDevicesCnt, LIBMTP_raw_device_t *rawDevices);
     int ReNameInner(const std::string &oldPath, const std::string &newPath);
+    int FetchObjectRange(uint32_t objectId, uint64_t offset, uint32_t size, std::vector<char> &data);
+    int SendObjectRanges(const std::string &src, uint32_t fileId, const std::map<uint64_t, uint64_t> &dirtyRanges);
 
 private:
     LIBMTP_mtpdevice_t *device_;
     Capabilities capabilities_;
     std::mutex deviceMutex_;
+    pthread_rwlock_t treeLock_;
     MtpFsTypeDir rootDir_;
     bool moveEnabled_;
+    MtpFsReadCache readCache_;
+    MtpFsDirCache dirCache_;
+    MtpFsTransferStats transferStats_;
+    std::mutex prefetchMutex_;
+    std::thread prefetchWorker_;
+    std::atomic<int64_t> lastForegroundIo_;
     static uint32_t rootNode_;
 };
 
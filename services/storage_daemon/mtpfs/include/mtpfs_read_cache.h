@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MTPFS_READ_CACHE_H
+#define MTPFS_READ_CACHE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <sys/types.h>
+#include <thread>
+#include <vector>
+
+/*
+ * Block cache for partial object reads, keyed by MTP object id.
+ *
+ * Reads are served from fixed size blocks fetched with one USB transaction each. Once a reader is detected to
+ * be sequential, the following blocks are fetched ahead by a background thread with a growing window.
+ */
+class MtpFsReadCache {
+public:
+    using FetchFunc = std::function<int(uint32_t objectId, uint64_t offset, uint32_t size, std::vector<char> &data)>;
+
+    explicit MtpFsReadCache(const FetchFunc &fetch);
+    ~MtpFsReadCache();
+
+    int Read(uint32_t objectId, uint64_t objectSize, char *buf, size_t size, off_t offset);
+    void Invalidate(uint32_t objectId);
+    void Release(uint32_t objectId);
+
+private:
+    enum BlockState {
+        BLOCK_LOADING,
+        BLOCK_READY,
+    };
+    struct BlockKey {
+        uint32_t objectId;
+        uint64_t index;
+    };
+    struct Block {
+        BlockState state = BLOCK_LOADING;
+        // position in lru_, valid once the block is ready
+        std::list<BlockKey>::iterator lruIt;
+        std::vector<char> data;
+    };
+    struct ObjectCache {
+        uint64_t objectSize = 0;
+        uint64_t generation = 0;
+        uint64_t nextOffset = 0;
+        uint32_t seqCount = 0;
+        uint32_t window = 0;
+        std::map<uint64_t, Block> blocks;
+    };
+    struct ReadaheadTask {
+        uint32_t objectId;
+        uint64_t index;
+        uint64_t generation;
+    };
+
+    bool IsCachedLocked(const ObjectCache &obj, uint64_t start, uint64_t end);
+    const std::vector<char> *GetBlockLocked(std::unique_lock<std::mutex> &lock, uint32_t objectId, uint64_t index,
+        std::vector<char> &scratch);
+    bool FinishBlockLocked(uint32_t objectId, uint64_t index, uint64_t generation, int ret,
+        std::vector<char> &data);
+    void UpdatePatternLocked(uint32_t objectId, uint64_t offset, uint64_t end);
+    void ClearBlocksLocked(ObjectCache &obj);
+    void EvictLocked();
+    void ReadaheadWorker();
+
+    FetchFunc fetch_;
+    std::mutex mutex_;
+    std::condition_variable blockCond_;
+    std::condition_variable taskCond_;
+    std::map<uint32_t, ObjectCache> objects_;
+    std::deque<ReadaheadTask> tasks_;
+    // ready blocks of all objects, most recently used first
+    std::list<BlockKey> lru_;
+    std::thread worker_;
+    bool stop_;
+};
+
+#endif // MTPFS_READ_CACHE_H
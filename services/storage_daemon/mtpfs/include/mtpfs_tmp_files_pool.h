@@ -16,6 +16,8 @@
 #ifndef MTPFS_TMP_FILES_POOL_H
 #define MTPFS_TMP_FILES_POOL_H
 
+#include <mutex>
+
 #include "mtpfs_type_tmp_file.h"
 
 class MtpFsTmpFilesPool {
@@ -28,6 +30,16 @@ public:
         tmpDir_ = tmpDir;
     }
 
+    // guards the pool and the tmp files in it, FUSE operations run on several threads
+    void EnterCritical()
+    {
+        poolMutex_.lock();
+    }
+    void LeaveCritical()
+    {
+        poolMutex_.unlock();
+    }
+
     void AddFile(const MtpFsTypeTmpFile &tmp)
     {
         pool_.insert(tmp);
@@ -47,6 +59,7 @@ public:
 private:
     std::string tmpDir_;
     std::set<MtpFsTypeTmpFile> pool_;
+    std::mutex poolMutex_;
 };
 
 #endif // MTPFS_TMP_FILES_POOL_H
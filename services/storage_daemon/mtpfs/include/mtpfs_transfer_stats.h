@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MTPFS_TRANSFER_STATS_H
+#define MTPFS_TRANSFER_STATS_H
+
+#include <cstdint>
+#include <mutex>
+
+/*
+ * Bytes moved over USB and the time spent on it, per kind of transfer.
+ */
+class MtpFsTransferStats {
+public:
+    enum Kind {
+        TRANSFER_PULL = 0,
+        TRANSFER_PUSH,
+        TRANSFER_PARTIAL_READ,
+        TRANSFER_PARTIAL_WRITE,
+        TRANSFER_KIND_NUM,
+    };
+
+    MtpFsTransferStats();
+
+    void Record(Kind kind, uint64_t bytes, uint64_t costUs);
+    void Dump();
+
+private:
+    struct Counter {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+        uint64_t costUs = 0;
+    };
+
+    std::mutex mutex_;
+    Counter counters_[TRANSFER_KIND_NUM];
+};
+
+#endif // MTPFS_TRANSFER_STATS_H
@@ -16,33 +16,48 @@
 #ifndef MTPFS_TYPE_DIR_H
 #define MTPFS_TYPE_DIR_H
 
-#include <mutex>
-#include <set>
+#include <atomic>
+#include <map>
+#include <pthread.h>
 #include <string>
+#include <unordered_map>
 
 #include "mtpfs_type_basic.h"
 #include "mtpfs_type_file.h"
 
+/*
+ * Children of a directory, indexed by name for path lookups and by object id for device side events.
+ * Listings walk the entries in place under the shared lock instead of copying them out.
+ */
 class MtpFsTypeDir : public MtpFsTypeBasic {
 public:
     MtpFsTypeDir();
     MtpFsTypeDir(uint32_t id, uint32_t parentId, uint32_t storageId, const std::string &name);
     MtpFsTypeDir(LIBMTP_file_t *file);
     MtpFsTypeDir(const MtpFsTypeDir &copy);
+    ~MtpFsTypeDir();
 
     void EnterCritical() const
     {
-        accessMutex_.lock();
+        pthread_rwlock_wrlock(&accessLock_);
+    }
+    void EnterShared() const
+    {
+        pthread_rwlock_rdlock(&accessLock_);
     }
     void LeaveCritical() const
     {
-        accessMutex_.unlock();
+        pthread_rwlock_unlock(&accessLock_);
     }
 
     void Clear()
     {
+        EnterCritical();
         dirs_.clear();
         files_.clear();
+        dirIds_.clear();
+        fileIds_.clear();
+        LeaveCritical();
     }
     void SetFetched(bool f = true)
     {
@@ -50,31 +65,47 @@ public:
     }
     bool IsFetched() const
     {
-        return fetched_;
+        return fetched_.load();
     }
     void AddDir(const MtpFsTypeDir &dir);
     void AddFile(const MtpFsTypeFile &file);
     bool RemoveDir(const MtpFsTypeDir &dir);
     bool RemoveFile(const MtpFsTypeFile &file);
     bool ReplaceFile(const MtpFsTypeFile &oldFile, const MtpFsTypeFile &newFile);
+    bool RenameDir(const std::string &oldName, const std::string &newName);
+    bool RenameFile(const std::string &oldName, const std::string &newName);
 
-    std::set<MtpFsTypeDir>::size_type DirCount() const
+    std::map<std::string, MtpFsTypeDir>::size_type DirCount() const
     {
         return dirs_.size();
     }
-    std::set<MtpFsTypeFile>::size_type FileCount() const
+    std::map<std::string, MtpFsTypeFile>::size_type FileCount() const
     {
         return files_.size();
     }
     const MtpFsTypeDir *Dir(const std::string &name) const;
     const MtpFsTypeFile *File(const std::string &name) const;
-    std::set<MtpFsTypeDir> Dirs() const
+    const MtpFsTypeDir *DirById(uint32_t id) const;
+    const MtpFsTypeFile *FileById(uint32_t id) const;
+
+    // func is called for every child in name order with the shared lock held, it must not modify this dir
+    template<typename Func>
+    void ForEachDir(Func func) const
     {
-        return dirs_;
+        EnterShared();
+        for (const auto &entry : dirs_) {
+            func(entry.second);
+        }
+        LeaveCritical();
     }
-    std::set<MtpFsTypeFile> Files() const
+    template<typename Func>
+    void ForEachFile(Func func) const
     {
-        return files_;
+        EnterShared();
+        for (const auto &entry : files_) {
+            func(entry.second);
+        }
+        LeaveCritical();
     }
     bool IsEmpty() const
     {
@@ -110,10 +141,15 @@ public:
     }
 
 private:
-    std::set<MtpFsTypeDir> dirs_;
-    std::set<MtpFsTypeFile> files_;
-    mutable std::mutex accessMutex_;
-    bool fetched_;
+    void RebuildIndex();
+
+    std::map<std::string, MtpFsTypeDir> dirs_;
+    std::map<std::string, MtpFsTypeFile> files_;
+    // map nodes never move, so the id index can point into them
+    std::unordered_map<uint32_t, MtpFsTypeDir *> dirIds_;
+    std::unordered_map<uint32_t, MtpFsTypeFile *> fileIds_;
+    mutable pthread_rwlock_t accessLock_;
+    std::atomic<bool> fetched_;
     time_t modifyDate_;
 };
 
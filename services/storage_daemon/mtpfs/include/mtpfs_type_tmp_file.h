@@ -16,6 +16,8 @@
 #ifndef MTPFS_TYPE_TMP_FILE_H
 #define MTPFS_TYPE_TMP_FILE_H
 
+#include <cstdint>
+#include <map>
 #include <set>
 #include <string>
 #include "mtpfs_type_file.h"
@@ -44,6 +46,23 @@ public:
         modified_ = modified;
     }
 
+    // merged [start, end) ranges written since the file was opened, used to write back only what changed
+    void AddDirtyRange(uint64_t offset, uint64_t size);
+    std::map<uint64_t, uint64_t> DirtyRanges() const
+    {
+        return dirtyRanges_;
+    }
+    // the local copy did not start from the device content, it has to be pushed as a whole
+    bool IsTruncated() const
+    {
+        return truncated_;
+    }
+    void SetTruncated()
+    {
+        truncated_ = true;
+        dirtyRanges_.clear();
+    }
+
     std::set<int> FileDescriptors() const
     {
         return fileDescriptors_;
@@ -82,7 +101,9 @@ private:
     std::string pathDevice_;
     std::string pathTmp_;
     std::set<int> fileDescriptors_;
+    std::map<uint64_t, uint64_t> dirtyRanges_;
     bool modified_;
+    bool truncated_;
 };
 
 #endif // MTPFS_TYPE_TMP_FILE_H
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mtpfs_dir_cache.h"
+
+#include <algorithm>
+
+#include "storage_service_log.h"
+
+namespace {
+// about 200 bytes per cached file or folder
+const size_t MAX_CACHED_ENTRIES = 100000;
+const size_t EVICT_TARGET_ENTRIES = MAX_CACHED_ENTRIES * 9 / 10;
+const size_t MAX_PREFETCH_QUEUE = 512;
+const uint64_t STATS_DUMP_INTERVAL = 128;
+}
+
+MtpFsDirCache::MtpFsDirCache()
+    : useClock_(0),
+      totalEntries_(0),
+      evictPending_(false),
+      stop_(false),
+      hits_(0),
+      misses_(0),
+      prefetched_(0),
+      evicted_(0),
+      fetchTimeUs_(0),
+      maxFetchUs_(0)
+{}
+
+void MtpFsDirCache::Touch(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = dirs_.find(path);
+    if (it != dirs_.end()) {
+        it->second.lastUse = ++useClock_;
+    }
+}
+
+void MtpFsDirCache::RecordHit()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    hits_++;
+}
+
+bool MtpFsDirCache::RecordFetch(const std::string &path, size_t entries, uint64_t costUs, bool prefetch)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    DirEntry &dir = dirs_[path];
+    totalEntries_ = totalEntries_ - dir.entries + entries;
+    dir.entries = entries;
+    dir.lastUse = ++useClock_;
+    if (prefetch) {
+        prefetched_++;
+    } else {
+        misses_++;
+    }
+    fetchTimeUs_ += costUs;
+    maxFetchUs_ = std::max(maxFetchUs_, costUs);
+    if ((misses_ + prefetched_) % STATS_DUMP_INTERVAL == 0) {
+        DumpStatsLocked();
+    }
+    if (totalEntries_ <= MAX_CACHED_ENTRIES) {
+        return false;
+    }
+    evictPending_ = true;
+    cond_.notify_one();
+    return true;
+}
+
+bool MtpFsDirCache::PickVictims(std::vector<std::string> &victims)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (totalEntries_ <= MAX_CACHED_ENTRIES) {
+        return false;
+    }
+    std::vector<std::pair<uint64_t, std::map<std::string, DirEntry>::const_iterator>> order;
+    order.reserve(dirs_.size());
+    for (auto it = dirs_.cbegin(); it != dirs_.cend(); ++it) {
+        order.push_back(std::make_pair(it->second.lastUse, it));
+    }
+    std::sort(order.begin(), order.end(),
+        [](const std::pair<uint64_t, std::map<std::string, DirEntry>::const_iterator> &a,
+            const std::pair<uint64_t, std::map<std::string, DirEntry>::const_iterator> &b) {
+            return a.first < b.first;
+        });
+    // evict down to below the budget, so every new listing does not trigger another pass
+    size_t remaining = totalEntries_;
+    for (const auto &item : order) {
+        if (remaining <= EVICT_TARGET_ENTRIES) {
+            break;
+        }
+        victims.push_back(item.second->first);
+        remaining -= std::min(remaining, item.second->second.entries);
+    }
+    return !victims.empty();
+}
+
+void MtpFsDirCache::Evicted(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // the listings below an evicted folder are dropped with it
+    const std::string prefix = path == "/" ? path : path + "/";
+    auto it = dirs_.find(path);
+    if (it != dirs_.end()) {
+        totalEntries_ -= std::min(totalEntries_, it->second.entries);
+        evicted_++;
+        dirs_.erase(it);
+    }
+    it = dirs_.lower_bound(prefix);
+    while (it != dirs_.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+        totalEntries_ -= std::min(totalEntries_, it->second.entries);
+        evicted_++;
+        it = dirs_.erase(it);
+    }
+}
+
+void MtpFsDirCache::SetLocalMtime(uint32_t id, time_t mtime)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    localMtimes_[id] = mtime;
+}
+
+bool MtpFsDirCache::LocalMtime(uint32_t id, time_t &mtime)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = localMtimes_.find(id);
+    if (it == localMtimes_.end()) {
+        return false;
+    }
+    mtime = it->second;
+    return true;
+}
+
+void MtpFsDirCache::DropLocalMtime(uint32_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    localMtimes_.erase(id);
+}
+
+void MtpFsDirCache::PushPrefetch(const std::vector<std::string> &paths, uint32_t depth, bool boost)
+{
+    if (paths.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (boost) {
+        // children of what the user just opened are the most likely next step
+        for (auto it = paths.rbegin(); it != paths.rend(); ++it) {
+            queue_.push_front({ *it, depth });
+        }
+    } else {
+        for (const std::string &path : paths) {
+            queue_.push_back({ path, depth });
+        }
+    }
+    while (queue_.size() > MAX_PREFETCH_QUEUE) {
+        queue_.pop_back();
+    }
+    cond_.notify_one();
+}
+
+bool MtpFsDirCache::WaitPrefetch(std::string &path, uint32_t &depth)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return stop_ || evictPending_ || !queue_.empty(); });
+    if (stop_) {
+        return false;
+    }
+    if (evictPending_) {
+        evictPending_ = false;
+        path.clear();
+        return true;
+    }
+    path = queue_.front().path;
+    depth = queue_.front().depth;
+    queue_.pop_front();
+    return true;
+}
+
+void MtpFsDirCache::Stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_) {
+        return;
+    }
+    stop_ = true;
+    queue_.clear();
+    DumpStatsLocked();
+    cond_.notify_all();
+}
+
+bool MtpFsDirCache::IsStopped()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stop_;
+}
+
+void MtpFsDirCache::DumpStatsLocked()
+{
+    uint64_t fetches = misses_ + prefetched_;
+    LOGI("dir cache: hit %{public}llu miss %{public}llu prefetch %{public}llu evict %{public}llu, "
+        "fetch avg %{public}llu us max %{public}llu us, %{public}zu entries in %{public}zu dirs",
+        static_cast<unsigned long long>(hits_), static_cast<unsigned long long>(misses_),
+        static_cast<unsigned long long>(prefetched_), static_cast<unsigned long long>(evicted_),
+        static_cast<unsigned long long>(fetches == 0 ? 0 : fetchTimeUs_ / fetches),
+        static_cast<unsigned long long>(maxFetchUs_), totalEntries_, dirs_.size());
+}
@@ -249,7 +249,6 @@ MtpFileSystem::~MtpFileSystem()
 bool MtpFileSystem::ParseOptionsInner()
 {
     fuse_opt_add_arg(&args_, options_.mountPoint_);
-    fuse_opt_add_arg(&args_, "-s");
 
     if (options_.verBose_) {
         fuse_opt_add_arg(&args_, "-f");
@@ -374,6 +373,7 @@ int MtpFileSystem::GetAttr(const char *path, struct stat *buf, struct fuse_file
     } else {
         std::string tmpPath(SmtpfsDirName(path));
         std::string tmpFile(SmtpfsBaseName(path));
+        MtpFsDevice::TreeLock lock(device_);
         const MtpFsTypeDir *content = device_.DirFetchContent(tmpPath);
         if (!content) {
             return -ENOENT;
@@ -529,26 +529,13 @@ int MtpFileSystem::Truncate(const char *path, off_t new_size, struct fuse_file_i
     return 0;
 }
 
-int MtpFileSystem::UTimens(const char *path, const struct timespec tv[2], struct fuse_file_info *fi)
+int MtpFileSystem::UTimens(const char *path, const struct timespec tv[2], struct fuse_file_info *fi)
 {
-    std::string tmpBaseName(SmtpfsBaseName(std::string(path)));
-    std::string tmpDirName(SmtpfsDirName(std::string(path)));
-
     int ret = utimensat(0, path, tv, AT_SYMLINK_NOFOLLOW);
     if (ret == -1) {
         return -ENOENT;
     }
-    const MtpFsTypeDir *parent = device_.DirFetchContent(tmpDirName);
-    if (!parent) {
-        return -ENOENT;
-    }
-    const MtpFsTypeFile *file = parent->File(tmpBaseName);
-    if (!file) {
-        return -ENOENT;
-    }
-    const_cast<MtpFsTypeFile *>(file)->SetModificationDate(tv->tv_sec);
-
-    return 0;
+    return device_.FileSetModificationDate(std::string(path), tv->tv_sec);
 }
 
 
@@ -562,7 +549,9 @@ int MtpFileSystem::Create(const char *path, mode_t mode, fuse_file_info *fileInf
     }
 
     fileInfo->fh = rval;
+    tmpFilesPool_.EnterCritical();
     tmpFilesPool_.AddFile(MtpFsTypeTmpFile(std::string(path), tmpPath, rval, true));
+    tmpFilesPool_.LeaveCritical();
     rval = device_.FilePush(tmpPath, std::string(path));
     if (rval != 0) {
         return rval;
@@ -577,16 +566,16 @@ int MtpFileSystem::Open(const char *path, struct fuse_file_info *fileInfo)
     }
     const std::string stdPath(path);
 
-    MtpFsTypeTmpFile *tmpFile = const_cast<MtpFsTypeTmpFile *>(tmpFilesPool_.GetFile(stdPath));
+    tmpFilesPool_.EnterCritical();
+    const MtpFsTypeTmpFile *tmpFile = tmpFilesPool_.GetFile(stdPath);
+    std::string tmpPath = tmpFile ? tmpFile->PathTmp() : std::string();
+    tmpFilesPool_.LeaveCritical();
 
-    std::string tmpPath;
-    if (tmpFile) {
-        tmpPath = tmpFile->PathTmp();
-    } else {
+    if (tmpPath.empty()) {
         tmpPath = tmpFilesPool_.MakeTmpPath(stdPath);
 
-        // only copy the file if needed
-        if (!HasPartialObjectSupport()) {
+        // only copy the file if needed, a truncated file starts empty anyway
+        if (!HasPartialObjectSupport() && !(fileInfo->flags & O_TRUNC)) {
             int rval = device_.FilePull(stdPath, tmpPath);
             if (rval != 0) {
                 return -rval;
@@ -605,13 +594,31 @@ int MtpFileSystem::Open(const char *path, struct fuse_file_info *fileInfo)
         return -errno;
     }
 
+    tmpFilesPool_.EnterCritical();
+    tmpFile = tmpFilesPool_.GetFile(stdPath);
+    if (tmpFile && tmpFile->PathTmp() != tmpPath) {
+        // another thread opened the same file meanwhile, share its copy
+        ::close(fd);
+        ::unlink(tmpPath.c_str());
+        fd = ::open(tmpFile->PathTmp().c_str(), fileInfo->flags);
+        if (fd < 0) {
+            int errnoTmp = errno;
+            tmpFilesPool_.LeaveCritical();
+            return -errnoTmp;
+        }
+    }
     fileInfo->fh = fd;
 
     if (tmpFile) {
-        tmpFile->AddFileDescriptor(fd);
+        const_cast<MtpFsTypeTmpFile *>(tmpFile)->AddFileDescriptor(fd);
     } else {
         tmpFilesPool_.AddFile(MtpFsTypeTmpFile(stdPath, tmpPath, fd));
+        tmpFile = tmpFilesPool_.GetFile(stdPath);
+    }
+    if (tmpFile && (fileInfo->flags & O_TRUNC)) {
+        const_cast<MtpFsTypeTmpFile *>(tmpFile)->SetTruncated();
     }
+    tmpFilesPool_.LeaveCritical();
     return 0;
 }
 
@@ -638,15 +645,21 @@ int MtpFileSystem::Write(const char *path, const char *buf, size_t size, off_t o
         const std::string stdPath(path);
         rval = device_.FileWrite(stdPath, buf, size, offset);
     } else {
+        tmpFilesPool_.EnterCritical();
         const MtpFsTypeTmpFile *tmpFile = tmpFilesPool_.GetFile(std::string(path));
         if (!tmpFile) {
+            tmpFilesPool_.LeaveCritical();
             return -EINVAL;
         }
         rval = ::pwrite(fileInfo->fh, buf, size, offset);
         if (rval < 0) {
-            return -errno;
+            int errnoTmp = errno;
+            tmpFilesPool_.LeaveCritical();
+            return -errnoTmp;
         }
         const_cast<MtpFsTypeTmpFile *>(tmpFile)->SetModified();
+        const_cast<MtpFsTypeTmpFile *>(tmpFile)->AddDirtyRange(offset, rval);
+        tmpFilesPool_.LeaveCritical();
     }
     return rval;
 }
@@ -661,16 +674,28 @@ int MtpFileSystem::Release(const char *path, struct fuse_file_info *fileInfo)
     if (stdPath == std::string("-")) {
         return 0;
     }
+    tmpFilesPool_.EnterCritical();
     MtpFsTypeTmpFile *tmpFile = const_cast<MtpFsTypeTmpFile *>(tmpFilesPool_.GetFile(stdPath));
+    if (!tmpFile) {
+        tmpFilesPool_.LeaveCritical();
+        return 0;
+    }
     tmpFile->RemoveFileDescriptor(fileInfo->fh);
     if (tmpFile->RefCnt() != 0) {
+        tmpFilesPool_.LeaveCritical();
         return 0;
     }
     const bool modIf = tmpFile->IsModified();
     const std::string tmpPath = tmpFile->PathTmp();
+    // a truncated copy has no dirty ranges and is pushed as a whole
+    const std::map<uint64_t, uint64_t> dirtyRanges = tmpFile->DirtyRanges();
     tmpFilesPool_.RemoveFile(stdPath);
+    tmpFilesPool_.LeaveCritical();
+    if (HasPartialObjectSupport()) {
+        device_.FileReleaseCache(stdPath);
+    }
     if (modIf) {
-        rval = device_.FilePush(tmpPath, stdPath);
+        rval = device_.FileWriteBack(tmpPath, stdPath, dirtyRanges);
         if (rval != 0) {
             ::unlink(tmpPath.c_str());
             return -rval;
@@ -717,6 +742,7 @@ int MtpFileSystem::FSync(const char *path, int datasync, struct fuse_file_info *
 
 int MtpFileSystem::OpenDir(const char *path, struct fuse_file_info *fileInfo)
 {
+    MtpFsDevice::TreeLock lock(device_);
     const MtpFsTypeDir *content = device_.DirFetchContent(std::string(path));
     if (!content) {
         return -ENOENT;
@@ -728,14 +754,12 @@ int MtpFileSystem::ReadDir(const char *path, void *buf, fuse_fill_dir_t filler,
     struct fuse_file_info *fileInfo, enum fuse_readdir_flags flag)
 {
     enum fuse_fill_dir_flags fillFlags = FUSE_FILL_DIR_PLUS;
+    MtpFsDevice::TreeLock lock(device_);
     const MtpFsTypeDir *content = device_.DirFetchContent(std::string(path));
     if (!content) {
         return -ENOENT;
     }
-    const std::set<MtpFsTypeDir> dirs = content->Dirs();
-    const std::set<MtpFsTypeFile> files = content->Files();
-
-    for (const MtpFsTypeDir &d : dirs) {
+    content->ForEachDir([buf, filler, fillFlags](const MtpFsTypeDir &d) {
         struct stat st;
         if (memset_s(&st, sizeof(st), 0, sizeof(st)) != EOK) {
             LOGE("memset st fail");
@@ -743,9 +767,9 @@ int MtpFileSystem::ReadDir(const char *path, void *buf, fuse_fill_dir_t filler,
         st.st_ino = d.Id();
         st.st_mode = S_IFDIR | PERMISSION_ONE;
         filler(buf, d.Name().c_str(), &st, 0, fillFlags);
-    }
+    });
 
-    for (const MtpFsTypeFile &f : files) {
+    content->ForEachFile([buf, filler, fillFlags](const MtpFsTypeFile &f) {
         struct stat st;
         if (memset_s(&st, sizeof(st), 0, sizeof(st)) != EOK) {
             LOGE("memset st fail");
@@ -753,7 +777,7 @@ int MtpFileSystem::ReadDir(const char *path, void *buf, fuse_fill_dir_t filler,
         st.st_ino = f.Id();
         st.st_mode = S_IFREG | PERMISSION_TWO;
         filler(buf, f.Name().c_str(), &st, 0, fillFlags);
-    }
+    });
     return 0;
 }
 
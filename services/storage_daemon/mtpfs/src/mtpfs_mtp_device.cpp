@@ -15,6 +15,9 @@
 
 #include "mtpfs_mtp_device.h"
 
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
 #include <sstream>
 #include <unistd.h>
 
@@ -25,8 +28,35 @@
 
 uint32_t MtpFsDevice::rootNode_ = ~0;
 
-MtpFsDevice::MtpFsDevice() : device_(nullptr), capabilities_(), deviceMutex_(), rootDir_(), moveEnabled_(false)
+namespace {
+// how deep below a folder opened by the user the listings are prefetched
+const uint32_t PREFETCH_DEPTH = 2;
+// prefetch only runs once the USB link has been idle for a while, user transfers go first
+const int64_t PREFETCH_IDLE_MS = 200;
+// dirty ranges are written back in pieces of this size
+const uint64_t WRITE_BACK_CHUNK = 1024 * 1024;
+
+int64_t SteadyNowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t SteadyNowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+MtpFsDevice::MtpFsDevice()
+    : device_(nullptr), capabilities_(), deviceMutex_(), rootDir_(), moveEnabled_(false),
+      readCache_([this](uint32_t objectId, uint64_t offset, uint32_t size, std::vector<char> &data) {
+          return FetchObjectRange(objectId, offset, size, data);
+      }),
+      lastForegroundIo_(0)
 {
+    pthread_rwlock_init(&treeLock_, nullptr);
     MtpFsUtil::Off();
     LIBMTP_Init();
     MtpFsUtil::On();
@@ -36,6 +66,7 @@ MtpFsDevice::~MtpFsDevice()
 {
     LOGI("MtpFsDevice Destructor.");
     Disconnect();
+    pthread_rwlock_destroy(&treeLock_);
 }
 
 bool MtpFsDevice::Connect(LIBMTP_raw_device_t *dev)
@@ -167,6 +198,17 @@ bool MtpFsDevice::ConnectByDevFile(const std::string &devFile)
 
 void MtpFsDevice::Disconnect()
 {
+    dirCache_.Stop();
+    // a fetch of the worker calls StartPrefetchWorker when it is done, so it is not joined under the mutex
+    std::thread worker;
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        worker = std::move(prefetchWorker_);
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    transferStats_.Dump();
     if (!device_) {
         return;
     }
@@ -202,6 +244,7 @@ bool MtpFsDevice::EnumStorages()
         LOGE("Could not retrieve device storage.");
         LIBMTP_Dump_Errorstack(device_);
         LIBMTP_Clear_Errorstack(device_);
+        CriticalLeave();
         return false;
     }
     CriticalLeave();
@@ -219,82 +262,203 @@ const void MtpFsDevice::HandleDir(LIBMTP_file_t *content, MtpFsTypeDir *dir)
         if (f->filetype == LIBMTP_FILETYPE_FOLDER) {
             dir->AddDir(MtpFsTypeDir(f));
         } else {
-            dir->AddFile(MtpFsTypeFile(f));
+            MtpFsTypeFile file(f);
+            time_t mtime = 0;
+            // the device does not know the dates set through utimens, apply them again after an eviction
+            if (dirCache_.LocalMtime(file.Id(), mtime)) {
+                file.SetModificationDate(mtime);
+            }
+            dir->AddFile(file);
         }
     }
 }
 
-const MtpFsTypeDir *MtpFsDevice::DirFetchContent(std::string path)
+void MtpFsDevice::FetchDirContent(const std::string &path, MtpFsTypeDir *dir, uint32_t depth, bool prefetch)
+{
+    // only the tree lock is shared here, cached lookups go on while the listing is transferred
+    CriticalEnter(prefetch);
+    if (dir->IsFetched()) {
+        CriticalLeave();
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    LIBMTP_file_t *content = LIBMTP_Get_Files_And_Folders(device_, dir->StorageId(), dir->Id());
+    HandleDir(content, dir);
+    LIBMTPFreeFilesAndFolders(&content);
+    dir->SetFetched();
+    CriticalLeave();
+    uint64_t costUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+
+    bool overBudget = dirCache_.RecordFetch(path, dir->DirCount() + dir->FileCount(), costUs, prefetch);
+    std::vector<std::string> children;
+    if (depth > 0) {
+        const std::string prefix = path == "/" ? path : path + "/";
+        dir->ForEachDir([&children, &prefix](const MtpFsTypeDir &child) { children.push_back(prefix + child.Name()); });
+        dirCache_.PushPrefetch(children, depth - 1, !prefetch);
+    }
+    if (overBudget || !children.empty()) {
+        StartPrefetchWorker();
+    }
+}
+
+void MtpFsDevice::StartPrefetchWorker()
+{
+    std::lock_guard<std::mutex> lock(prefetchMutex_);
+    if (!prefetchWorker_.joinable() && !dirCache_.IsStopped()) {
+        // started on demand, fuse_main forks into the background after the device is connected
+        prefetchWorker_ = std::thread(&MtpFsDevice::PrefetchWorker, this);
+    }
+}
+
+void MtpFsDevice::PrefetchWorker()
+{
+    pthread_setname_np(pthread_self(), "mtpfs_prefetch");
+    std::string path;
+    uint32_t depth = 0;
+    while (dirCache_.WaitPrefetch(path, depth)) {
+        if (path.empty()) {
+            EvictDirs();
+            continue;
+        }
+        if (!WaitForegroundIdle()) {
+            break;
+        }
+        TreeLock lock(*this);
+        MtpFsTypeDir *dir = DirLookup(path, false);
+        if (dir != nullptr && dir != &rootDir_ && !dir->IsFetched()) {
+            FetchDirContent(path, dir, depth, true);
+        }
+    }
+}
+
+bool MtpFsDevice::WaitForegroundIdle()
+{
+    while (!dirCache_.IsStopped()) {
+        int64_t idleMs = SteadyNowMs() - lastForegroundIo_.load();
+        if (idleMs >= PREFETCH_IDLE_MS) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(PREFETCH_IDLE_MS - idleMs));
+    }
+    return false;
+}
+
+void MtpFsDevice::EvictDirs()
+{
+    std::vector<std::string> victims;
+    if (!dirCache_.PickVictims(victims)) {
+        return;
+    }
+    TreeLock lock(*this, true);
+    for (const std::string &path : victims) {
+        MtpFsTypeDir *dir = DirLookup(path, false);
+        if (dir != nullptr && dir != &rootDir_) {
+            dir->Clear();
+            dir->SetFetched(false);
+        }
+        dirCache_.Evicted(path);
+    }
+    LOGI("Evicted %{public}zu dir listings", victims.size());
+}
+
+MtpFsTypeDir *MtpFsDevice::DirLookup(std::string path, bool fetch)
 {
     if (!rootDir_.IsFetched()) {
-        for (LIBMTP_devicestorage_t *s = device_->storage; s; s = s->next) {
-            rootDir_.AddDir(MtpFsTypeDir(rootNode_, 0, s->id, std::string(s->StorageDescription)));
+        CriticalEnter();
+        if (!rootDir_.IsFetched()) {
+            for (LIBMTP_devicestorage_t *s = device_->storage; s; s = s->next) {
+                rootDir_.AddDir(MtpFsTypeDir(rootNode_, 0, s->id, std::string(s->StorageDescription)));
+            }
             rootDir_.SetFetched();
         }
+        CriticalLeave();
     }
 
-    if (rootDir_.DirCount() == 1) {
-        path = '/' + rootDir_.Dirs().begin()->Name() + path;
+    // the dir cache is keyed by the path seen through the mount, without the hidden storage folder
+    const std::string key = path;
+    bool hiddenStorage = rootDir_.DirCount() == 1;
+    if (hiddenStorage) {
+        rootDir_.ForEachDir([&path](const MtpFsTypeDir &storage) { path = '/' + storage.Name() + path; });
     }
     if (path == "/") {
         return &rootDir_;
     }
 
     std::string member;
+    std::string memberPath;
     std::istringstream ss(path);
     MtpFsTypeDir *dir = &rootDir_;
+    bool fetched = false;
     while (std::getline(ss, member, '/')) {
         if (member.empty()) {
             continue;
         }
         const MtpFsTypeDir *tmp = dir->Dir(member);
-        if (!tmp && !dir->IsFetched()) {
-            CriticalEnter();
-            LIBMTP_file_t *content = LIBMTP_Get_Files_And_Folders(device_, dir->StorageId(), dir->Id());
-            CriticalLeave();
-            HandleDir(content, dir);
-            LIBMTPFreeFilesAndFolders(&content);
-            dir->SetFetched();
+        if (!tmp && fetch && !dir->IsFetched()) {
+            FetchDirContent(memberPath.empty() ? "/" : memberPath, dir, PREFETCH_DEPTH, false);
+            fetched = true;
             tmp = dir->Dir(member);
         }
         if (!tmp) {
             return nullptr;
         }
+        if (hiddenStorage && dir == &rootDir_) {
+            memberPath.clear();
+        } else {
+            memberPath += "/" + member;
+        }
         dir = const_cast<MtpFsTypeDir *>(tmp);
     }
 
-    if (dir->IsFetched()) {
+    if (!fetch) {
         return dir;
     }
-    CriticalEnter();
-    dir->SetFetched();
-    LIBMTP_file_t *content = LIBMTP_Get_Files_And_Folders(device_, dir->StorageId(), dir->Id());
-    CriticalLeave();
-    HandleDir(content, dir);
-    LIBMTPFreeFilesAndFolders(&content);
+    if (!dir->IsFetched()) {
+        FetchDirContent(key, dir, PREFETCH_DEPTH, false);
+    } else if (!fetched) {
+        dirCache_.RecordHit();
+        dirCache_.Touch(key);
+    }
     return dir;
 }
 
+const MtpFsTypeDir *MtpFsDevice::DirFetchContent(std::string path)
+{
+    return DirLookup(path, true);
+}
+
 int MtpFsDevice::DirCreateNew(const std::string &path)
 {
     const std::string tmpBaseName(SmtpfsBaseName(path));
     const std::string tmpDirName(SmtpfsDirName(path));
-    const MtpFsTypeDir *dirParent = DirFetchContent(tmpDirName);
-    if (!dirParent || dirParent->Id() == 0) {
-        LOGE("Can not remove directory: %{public}s", path.c_str());
-        return -EINVAL;
+    uint32_t parentId = 0;
+    uint32_t storageId = 0;
+    {
+        TreeLock lock(*this);
+        const MtpFsTypeDir *dirParent = DirFetchContent(tmpDirName);
+        if (!dirParent || dirParent->Id() == 0) {
+            LOGE("Can not remove directory: %{public}s", path.c_str());
+            return -EINVAL;
+        }
+        parentId = dirParent->Id();
+        storageId = dirParent->StorageId();
     }
     char *cName = strdup(tmpBaseName.c_str());
     CriticalEnter();
-    uint32_t newId = LIBMTP_Create_Folder(device_, cName, dirParent->Id(), dirParent->StorageId());
-    CriticalLeave();
+    uint32_t newId = LIBMTP_Create_Folder(device_, cName, parentId, storageId);
     if (newId == 0) {
         LOGE("Could not create directory: %{public}s", path.c_str());
         LIBMTP_Dump_Errorstack(device_);
         LIBMTP_Clear_Errorstack(device_);
-    } else {
-        const_cast<MtpFsTypeDir *>(dirParent)
-            ->AddDir(MtpFsTypeDir(newId, dirParent->Id(), dirParent->StorageId(), tmpBaseName));
+    }
+    CriticalLeave();
+    if (newId != 0) {
+        TreeLock lock(*this, true);
+        MtpFsTypeDir *dirParent = DirLookup(tmpDirName, false);
+        if (dirParent) {
+            dirParent->AddDir(MtpFsTypeDir(newId, parentId, storageId, tmpBaseName));
+        }
         LOGI("Directory %{public}s created", path.c_str());
     }
     free(static_cast<void *>(cName));
@@ -305,25 +469,37 @@ int MtpFsDevice::DirRemove(const std::string &path)
 {
     const std::string tmpBaseName(SmtpfsBaseName(path));
     const std::string tmpDirName(SmtpfsDirName(path));
-    const MtpFsTypeDir *dirParent = DirFetchContent(tmpDirName);
-    const MtpFsTypeDir *dirToRemove = dirParent ? dirParent->Dir(tmpBaseName) : nullptr;
-    if (!dirParent || !dirToRemove || dirParent->Id() == 0) {
-        LOGE("No such directory %{public}s to remove", path.c_str());
-        return -ENOENT;
-    }
-    if (!dirToRemove->IsEmpty()) {
-        return -ENOTEMPTY;
+    uint32_t dirId = 0;
+    {
+        TreeLock lock(*this);
+        const MtpFsTypeDir *dirParent = DirFetchContent(tmpDirName);
+        const MtpFsTypeDir *dirToRemove = dirParent ? dirParent->Dir(tmpBaseName) : nullptr;
+        if (!dirParent || !dirToRemove || dirParent->Id() == 0) {
+            LOGE("No such directory %{public}s to remove", path.c_str());
+            return -ENOENT;
+        }
+        if (!dirToRemove->IsEmpty()) {
+            return -ENOTEMPTY;
+        }
+        dirId = dirToRemove->Id();
     }
     CriticalEnter();
-    int rval = LIBMTP_Delete_Object(device_, dirToRemove->Id());
-    CriticalLeave();
+    int rval = LIBMTP_Delete_Object(device_, dirId);
     if (rval != 0) {
         LOGE("Could not remove the directory: %{public}s", path.c_str());
         LIBMTP_Dump_Errorstack(device_);
         LIBMTP_Clear_Errorstack(device_);
+    }
+    CriticalLeave();
+    if (rval != 0) {
         return -EINVAL;
     }
-    const_cast<MtpFsTypeDir *>(dirParent)->RemoveDir(*dirToRemove);
+    TreeLock lock(*this, true);
+    MtpFsTypeDir *dirParent = DirLookup(tmpDirName, false);
+    const MtpFsTypeDir *dirToRemove = dirParent ? dirParent->Dir(tmpBaseName) : nullptr;
+    if (dirToRemove && dirToRemove->Id() == dirId) {
+        dirParent->RemoveDir(*dirToRemove);
+    }
     LOGI("Folder %{public}s removed", path.c_str());
     return 0;
 }
@@ -334,30 +510,40 @@ int MtpFsDevice::DirReName(const std::string &oldPath, const std::string &newPat
     const std::string tmpOldDirName(SmtpfsDirName(oldPath));
     const std::string tmpNewBaseName(SmtpfsBaseName(newPath));
     const std::string tmpNewDirName(SmtpfsDirName(newPath));
-    const MtpFsTypeDir *dirParent = DirFetchContent(tmpOldDirName);
-    const MtpFsTypeDir *dirToReName = dirParent ? dirParent->Dir(tmpOldBaseName) : nullptr;
-    if (!dirParent || !dirToReName || dirParent->Id() == 0) {
-        LOGE("Can not rename %{public}s to %{public}s ", tmpOldBaseName.c_str(), tmpNewBaseName.c_str());
-        return -EINVAL;
-    }
-    if (tmpOldDirName != tmpNewDirName) {
-        LOGE("Can not move %{public}s to %{public}s", oldPath.c_str(), newPath.c_str());
-        return -EINVAL;
+    LIBMTP_folder_t *folder = nullptr;
+    {
+        TreeLock lock(*this);
+        const MtpFsTypeDir *dirParent = DirFetchContent(tmpOldDirName);
+        const MtpFsTypeDir *dirToReName = dirParent ? dirParent->Dir(tmpOldBaseName) : nullptr;
+        if (!dirParent || !dirToReName || dirParent->Id() == 0) {
+            LOGE("Can not rename %{public}s to %{public}s ", tmpOldBaseName.c_str(), tmpNewBaseName.c_str());
+            return -EINVAL;
+        }
+        if (tmpOldDirName != tmpNewDirName) {
+            LOGE("Can not move %{public}s to %{public}s", oldPath.c_str(), newPath.c_str());
+            return -EINVAL;
+        }
+        folder = dirToReName->ToLIBMTPFolder();
     }
 
-    LIBMTP_folder_t *folder = dirToReName->ToLIBMTPFolder();
     CriticalEnter();
     int ret = LIBMTP_Set_Folder_Name(device_, folder, tmpNewBaseName.c_str());
-    CriticalLeave();
-    free(static_cast<void *>(folder->name));
-    free(static_cast<void *>(folder));
     if (ret != 0) {
         LOGE("Could not rename %{public}s to %{public}s", oldPath.c_str(), tmpNewBaseName.c_str());
         LIBMTP_Dump_Errorstack(device_);
         LIBMTP_Clear_Errorstack(device_);
+    }
+    CriticalLeave();
+    free(static_cast<void *>(folder->name));
+    free(static_cast<void *>(folder));
+    if (ret != 0) {
         return -EINVAL;
     }
-    const_cast<MtpFsTypeDir *>(dirToReName)->SetName(tmpNewBaseName);
+    TreeLock lock(*this, true);
+    MtpFsTypeDir *dirParent = DirLookup(tmpOldDirName, false);
+    if (dirParent) {
+        dirParent->RenameDir(tmpOldBaseName, tmpNewBaseName);
+    }
     LOGI("Directory %{public}s renamed to %{public}s", oldPath.c_str(), tmpNewBaseName.c_str());
     return 0;
 }
@@ -368,32 +554,30 @@ int MtpFsDevice::ReNameInner(const std::string &oldPath, const std::string &newP
     const std::string tmpOldDirName(SmtpfsDirName(oldPath));
     const std::string tmpNewBaseName(SmtpfsBaseName(newPath));
     const std::string tmpNewDirName(SmtpfsDirName(newPath));
-    const MtpFsTypeDir *dirOldParent = DirFetchContent(tmpOldDirName);
-    const MtpFsTypeDir *dirNewParent = DirFetchContent(tmpNewDirName);
-    const MtpFsTypeDir *dirToReName = dirOldParent ? dirOldParent->Dir(tmpOldBaseName) : nullptr;
-    const MtpFsTypeFile *fileToReName = dirOldParent ? dirOldParent->File(tmpOldBaseName) : nullptr;
-
-    LOGD("dirToReName:%{public}s", dirToReName);
-    LOGD("fileToReName:%{public}s", fileToReName);
-
-    if (!dirOldParent || !dirNewParent || dirOldParent->Id() == 0) {
-        return -EINVAL;
-    }
-    const MtpFsTypeBasic *objectToReName = dirToReName ? static_cast<const MtpFsTypeBasic *>(dirToReName) :
+    uint32_t objectId = 0;
+    uint32_t newParentId = 0;
+    {
+        TreeLock lock(*this);
+        const MtpFsTypeDir *dirOldParent = DirFetchContent(tmpOldDirName);
+        const MtpFsTypeDir *dirNewParent = DirFetchContent(tmpNewDirName);
+        if (!dirOldParent || !dirNewParent || dirOldParent->Id() == 0) {
+            return -EINVAL;
+        }
+        const MtpFsTypeDir *dirToReName = dirOldParent->Dir(tmpOldBaseName);
+        const MtpFsTypeFile *fileToReName = dirOldParent->File(tmpOldBaseName);
+        const MtpFsTypeBasic *objectToReName = dirToReName ? static_cast<const MtpFsTypeBasic *>(dirToReName) :
                                                              static_cast<const MtpFsTypeBasic *>(fileToReName);
-
-    LOGD("objectToReName:%{public}s", objectToReName);
-    LOGD("objectToReName->id:%{public}d", objectToReName->Id());
-
-    if (!objectToReName) {
-        LOGE("No such file or directory to rename/move!");
-        return -ENOENT;
+        if (!objectToReName) {
+            LOGE("No such file or directory to rename/move!");
+            return -ENOENT;
+        }
+        objectId = objectToReName->Id();
+        newParentId = dirNewParent->Id();
     }
 
     if (tmpOldDirName != tmpNewDirName) {
         CriticalEnter();
-        int rval =
-            LIBMTP_Set_Object_u32(device_, objectToReName->Id(), LIBMTP_PROPERTY_ParentObject, dirNewParent->Id());
+        int rval = LIBMTP_Set_Object_u32(device_, objectId, LIBMTP_PROPERTY_ParentObject, newParentId);
         CriticalLeave();
         if (rval != 0) {
             LOGE("Could not move %{public}s to %{public}s", oldPath.c_str(), newPath.c_str());
@@ -401,12 +585,19 @@ int MtpFsDevice::ReNameInner(const std::string &oldPath, const std::string &newP
             LIBMTP_Clear_Errorstack(device_);
             return -EINVAL;
         }
-        const_cast<MtpFsTypeBasic *>(objectToReName)->SetParent(dirNewParent->Id());
+        TreeLock lock(*this, true);
+        MtpFsTypeDir *dirOldParent = DirLookup(tmpOldDirName, false);
+        const MtpFsTypeDir *dirMoved = dirOldParent ? dirOldParent->Dir(tmpOldBaseName) : nullptr;
+        const MtpFsTypeFile *fileMoved = dirOldParent ? dirOldParent->File(tmpOldBaseName) : nullptr;
+        if (dirMoved && dirMoved->Id() == objectId) {
+            const_cast<MtpFsTypeDir *>(dirMoved)->SetParent(newParentId);
+        } else if (fileMoved && fileMoved->Id() == objectId) {
+            const_cast<MtpFsTypeFile *>(fileMoved)->SetParent(newParentId);
+        }
     }
     if (tmpOldBaseName != tmpNewBaseName) {
         CriticalEnter();
-        int rval =
-            LIBMTP_Set_Object_String(device_, objectToReName->Id(), LIBMTP_PROPERTY_Name, tmpNewBaseName.c_str());
+        int rval = LIBMTP_Set_Object_String(device_, objectId, LIBMTP_PROPERTY_Name, tmpNewBaseName.c_str());
         CriticalLeave();
         if (rval != 0) {
             LOGE("Could not rename %{public}s to %{public}s", oldPath.c_str(), newPath.c_str());
@@ -428,12 +619,16 @@ int MtpFsDevice::ReName(const std::string &oldPath, const std::string &newPath)
         return -EINVAL;
     }
 
-    const MtpFsTypeDir *dirParent = DirFetchContent(tmpOldDirName);
-    if (!dirParent || dirParent->Id() == 0) {
-        return -EINVAL;
+    bool isDir = false;
+    {
+        TreeLock lock(*this);
+        const MtpFsTypeDir *dirParent = DirFetchContent(tmpOldDirName);
+        if (!dirParent || dirParent->Id() == 0) {
+            return -EINVAL;
+        }
+        isDir = dirParent->Dir(tmpOldBaseName) != nullptr;
     }
-    const MtpFsTypeDir *dirToReName = dirParent->Dir(tmpOldBaseName);
-    if (dirToReName) {
+    if (isDir) {
         return DirReName(oldPath, newPath);
     } else {
         return FileRename(oldPath, newPath);
@@ -448,89 +643,138 @@ int MtpFsDevice::ReName(const std::string &oldPath, const std::string &newPath)
 #endif
 }
 
-int MtpFsDevice::FileRead(const std::string &path, char *buf, size_t size, off_t offset)
+int MtpFsDevice::FileSetModificationDate(const std::string &path, time_t mtime)
 {
-    const std::string pathBaseName(SmtpfsBaseName(path));
-    const std::string pathDirName(SmtpfsDirName(path));
-    const MtpFsTypeDir *dirParent = DirFetchContent(pathDirName);
-    const MtpFsTypeFile *fileToFetch = dirParent ? dirParent->File(pathBaseName) : nullptr;
+    const std::string tmpBaseName(SmtpfsBaseName(path));
+    const std::string tmpDirName(SmtpfsDirName(path));
+    {
+        // fetching the listing may take a USB transaction, it is done before the tree is locked exclusive
+        TreeLock lock(*this);
+        const MtpFsTypeDir *dirParent = DirFetchContent(tmpDirName);
+        if (!dirParent || !dirParent->File(tmpBaseName)) {
+            return -ENOENT;
+        }
+    }
+    TreeLock lock(*this, true);
+    MtpFsTypeDir *dirParent = DirLookup(tmpDirName, false);
+    const MtpFsTypeFile *file = dirParent ? dirParent->File(tmpBaseName) : nullptr;
+    if (!file) {
+        return -ENOENT;
+    }
+    const_cast<MtpFsTypeFile *>(file)->SetModificationDate(mtime);
+    dirCache_.SetLocalMtime(file->Id(), mtime);
+    return 0;
+}
+
+bool MtpFsDevice::FileLookup(const std::string &path, uint32_t &id, uint64_t &size, int &err)
+{
+    TreeLock lock(*this);
+    const MtpFsTypeDir *dirParent = DirFetchContent(SmtpfsDirName(path));
+    const MtpFsTypeFile *file = dirParent ? dirParent->File(SmtpfsBaseName(path)) : nullptr;
     if (!dirParent) {
         LOGE("Can not fetch %{public}s", path.c_str());
-        return -EINVAL;
+        err = -EINVAL;
+        return false;
     }
-    if (!fileToFetch) {
+    if (!file) {
         LOGE("No such file %{public}s", path.c_str());
-        return -ENOENT;
+        err = -ENOENT;
+        return false;
     }
+    id = file->Id();
+    size = file->Size();
+    return true;
+}
 
-    // all systems clear
-    unsigned char *tmpBuf;
-    unsigned int tmpSize;
-    int rval = LIBMTP_GetPartialObject(device_, fileToFetch->Id(), offset, size, &tmpBuf, &tmpSize);
-    if (tmpSize > 0) {
-        if (memcpy_s(buf, tmpSize, tmpBuf, tmpSize) != EOK) {
-            LOGE("memcpy_s tmpBuf fail");
-        }
-        free(tmpBuf);
+int MtpFsDevice::FileRead(const std::string &path, char *buf, size_t size, off_t offset)
+{
+    uint32_t fileId = 0;
+    uint64_t fileSize = 0;
+    int err = 0;
+    if (!FileLookup(path, fileId, fileSize, err)) {
+        return err;
     }
+    return readCache_.Read(fileId, fileSize, buf, size, offset);
+}
 
+int MtpFsDevice::FetchObjectRange(uint32_t objectId, uint64_t offset, uint32_t size, std::vector<char> &data)
+{
+    unsigned char *tmpBuf = nullptr;
+    unsigned int tmpSize = 0;
+    uint64_t startUs = SteadyNowUs();
+    CriticalEnter();
+    int rval = LIBMTP_GetPartialObject(device_, objectId, offset, size, &tmpBuf, &tmpSize);
+    CriticalLeave();
+    transferStats_.Record(MtpFsTransferStats::TRANSFER_PARTIAL_READ, tmpSize, SteadyNowUs() - startUs);
+    if (tmpSize > 0 && tmpBuf != nullptr) {
+        data.assign(reinterpret_cast<char *>(tmpBuf), reinterpret_cast<char *>(tmpBuf) + tmpSize);
+    }
+    free(tmpBuf);
     if (rval != 0) {
+        LOGE("GetPartialObject of %{public}u at %{public}llu fail", objectId, static_cast<unsigned long long>(offset));
         return -EIO;
     }
-    return tmpSize;
+    return 0;
 }
 
-int MtpFsDevice::FileWrite(const std::string &path, const char *buf, size_t size, off_t offset)
+void MtpFsDevice::FileReleaseCache(const std::string &path)
 {
-    const std::string pathBaseName(SmtpfsBaseName(path));
-    const std::string pathDirName(SmtpfsDirName(path));
-    const MtpFsTypeDir *dirParent = DirFetchContent(pathDirName);
-    const MtpFsTypeFile *fileToFetch = dirParent ? dirParent->File(pathBaseName) : nullptr;
-    if (!dirParent) {
-        LOGE("Can not fetch %{public}s", path.c_str());
-        return -EINVAL;
+    uint32_t fileId = 0;
+    uint64_t fileSize = 0;
+    int err = 0;
+    if (FileLookup(path, fileId, fileSize, err)) {
+        readCache_.Release(fileId);
     }
-    if (!fileToFetch) {
-        LOGE("No such file %{public}s", path.c_str());
-        return -ENOENT;
+}
+
+int MtpFsDevice::FileWrite(const std::string &path, const char *buf, size_t size, off_t offset)
+{
+    uint32_t fileId = 0;
+    uint64_t fileSize = 0;
+    int err = 0;
+    if (!FileLookup(path, fileId, fileSize, err)) {
+        return err;
     }
 
     // all systems clear
-    int rval = LIBMTP_SendPartialObject(device_, fileToFetch->Id(), offset, (unsigned char *)buf, size);
+    readCache_.Invalidate(fileId);
+    uint64_t startUs = SteadyNowUs();
+    CriticalEnter();
+    int rval = LIBMTP_SendPartialObject(device_, fileId, offset, (unsigned char *)buf, size);
+    CriticalLeave();
     if (rval < 0) {
         return -EIO;
     }
+    transferStats_.Record(MtpFsTransferStats::TRANSFER_PARTIAL_WRITE, size, SteadyNowUs() - startUs);
     return size;
 }
 
 int MtpFsDevice::FilePull(const std::string &src, const std::string &dst)
 {
-    const std::string srcBaseName(SmtpfsBaseName(src));
-    const std::string srcDirName(SmtpfsDirName(src));
-    const MtpFsTypeDir *dirParent = DirFetchContent(srcDirName);
-    const MtpFsTypeFile *fileToFetch = dirParent ? dirParent->File(srcBaseName) : nullptr;
-    if (!dirParent) {
-        LOGE("Can not fetch %{public}s", src.c_str());
-        return -EINVAL;
+    uint32_t fileId = 0;
+    uint64_t fileSize = 0;
+    int err = 0;
+    if (!FileLookup(src, fileId, fileSize, err)) {
+        return err;
     }
-    if (!fileToFetch) {
-        LOGE("No such file %{public}s", src.c_str());
-        return -ENOENT;
-    }
-    if (fileToFetch->Size() == 0) {
+    if (fileSize == 0) {
         int fd = ::creat(dst.c_str(), S_IRUSR | S_IWUSR);
         ::close(fd);
     } else {
         LOGI("Started fetching %{public}s", src.c_str());
+        uint64_t startUs = SteadyNowUs();
         CriticalEnter();
-        int rval = LIBMTP_Get_File_To_File(device_, fileToFetch->Id(), dst.c_str(), nullptr, nullptr);
-        CriticalLeave();
+        int rval = LIBMTP_Get_File_To_File(device_, fileId, dst.c_str(), nullptr, nullptr);
         if (rval != 0) {
             LOGE("Could not fetch file %{public}s", src.c_str());
             LIBMTP_Dump_Errorstack(device_);
             LIBMTP_Clear_Errorstack(device_);
+        }
+        CriticalLeave();
+        if (rval != 0) {
             return -ENOENT;
         }
+        transferStats_.Record(MtpFsTransferStats::TRANSFER_PULL, fileSize, SteadyNowUs() - startUs);
     }
     LOGI("File fetched %{public}s", src.c_str());
     return 0;
@@ -540,44 +784,69 @@ int MtpFsDevice::FilePush(const std::string &src, const std::string &dst)
 {
     const std::string dstBaseName(SmtpfsBaseName(dst));
     const std::string dstDirName(SmtpfsDirName(dst));
-    const MtpFsTypeDir *dirParent = DirFetchContent(dstDirName);
-    const MtpFsTypeFile *fileToRemove = dirParent ? dirParent->File(dstBaseName) : nullptr;
-    if (dirParent && fileToRemove) {
+    uint32_t parentId = 0;
+    uint32_t storageId = 0;
+    uint32_t oldFileId = 0;
+    bool hasOldFile = false;
+    {
+        TreeLock lock(*this);
+        const MtpFsTypeDir *dirParent = DirFetchContent(dstDirName);
+        if (!dirParent) {
+            LOGE("Can not upload %{public}s to %{public}s", src.c_str(), dst.c_str());
+            return -ENOENT;
+        }
+        parentId = dirParent->Id();
+        storageId = dirParent->StorageId();
+        const MtpFsTypeFile *fileToRemove = dirParent->File(dstBaseName);
+        if (fileToRemove) {
+            hasOldFile = true;
+            oldFileId = fileToRemove->Id();
+        }
+    }
+    if (hasOldFile) {
+        readCache_.Release(oldFileId);
         CriticalEnter();
-        int rval = LIBMTP_Delete_Object(device_, fileToRemove->Id());
+        int rval = LIBMTP_Delete_Object(device_, oldFileId);
         CriticalLeave();
         if (rval != 0) {
             LOGE("Can not upload %{public}s to %{public}s", src.c_str(), dst.c_str());
             return -EINVAL;
         }
+        dirCache_.DropLocalMtime(oldFileId);
     }
 
     struct stat fileStat;
     stat(src.c_str(), &fileStat);
-    MtpFsTypeFile fileToUpload(0, dirParent->Id(), dirParent->StorageId(), dstBaseName,
-        static_cast<uint64_t>(fileStat.st_size), 0);
+    MtpFsTypeFile fileToUpload(0, parentId, storageId, dstBaseName, static_cast<uint64_t>(fileStat.st_size), 0);
     LIBMTP_file_t *f = fileToUpload.ToLIBMTPFile();
     if (fileStat.st_size) {
         LOGI("Started uploading %{public}s", dst.c_str());
     }
+    uint64_t startUs = SteadyNowUs();
     CriticalEnter();
     int rval = LIBMTP_Send_File_From_File(device_, src.c_str(), f, nullptr, nullptr);
-    CriticalLeave();
     if (rval != 0) {
         LOGE("Could not upload file %{public}s", src.c_str());
         LIBMTP_Dump_Errorstack(device_);
         LIBMTP_Clear_Errorstack(device_);
+    }
+    CriticalLeave();
+    if (rval != 0) {
         rval = -EINVAL;
     } else {
+        transferStats_.Record(MtpFsTransferStats::TRANSFER_PUSH, fileToUpload.Size(), SteadyNowUs() - startUs);
         fileToUpload.SetId(f->item_id);
         fileToUpload.SetParent(f->parent_id);
         fileToUpload.SetStorage(f->storage_id);
         fileToUpload.SetName(std::string(f->filename));
         fileToUpload.SetModificationDate(fileStat.st_mtime);
-        if (fileToRemove) {
-            const_cast<MtpFsTypeDir *>(dirParent)->ReplaceFile(*fileToRemove, fileToUpload);
-        } else {
-            const_cast<MtpFsTypeDir *>(dirParent)->AddFile(fileToUpload);
+        TreeLock lock(*this, true);
+        MtpFsTypeDir *dirParent = DirLookup(dstDirName, false);
+        const MtpFsTypeFile *oldFile = dirParent ? dirParent->File(dstBaseName) : nullptr;
+        if (oldFile) {
+            dirParent->ReplaceFile(*oldFile, fileToUpload);
+        } else if (dirParent) {
+            dirParent->AddFile(fileToUpload);
         }
     }
     free(static_cast<void *>(f->filename));
@@ -585,24 +854,106 @@ int MtpFsDevice::FilePush(const std::string &src, const std::string &dst)
     return rval;
 }
 
+int MtpFsDevice::FileWriteBack(const std::string &src, const std::string &dst,
+    const std::map<uint64_t, uint64_t> &dirtyRanges)
+{
+    // Temp files are only staged for devices without both partial object operations. Of those, only the ones
+    // that can send but not get partial objects are written back in place, the others push the whole file.
+    if (dirtyRanges.empty() || !capabilities_.CanSendPartialObject()) {
+        return FilePush(src, dst);
+    }
+    uint32_t fileId = 0;
+    uint64_t fileSize = 0;
+    int err = 0;
+    struct stat fileStat;
+    if (!FileLookup(dst, fileId, fileSize, err) || stat(src.c_str(), &fileStat) != 0 ||
+        static_cast<uint64_t>(fileStat.st_size) != fileSize) {
+        // partial objects can not change the object size, the whole file has to be replaced
+        LOGI("Size of %{public}s changed, upload it as a whole", dst.c_str());
+        return FilePush(src, dst);
+    }
+    if (SendObjectRanges(src, fileId, dirtyRanges) != 0) {
+        LOGE("Could not write back %{public}s in place, upload it as a whole", dst.c_str());
+        return FilePush(src, dst);
+    }
+    uint64_t dirtySize = 0;
+    for (const auto &range : dirtyRanges) {
+        dirtySize += range.second - range.first;
+    }
+    LOGI("Wrote back %{public}zu dirty ranges of %{public}s, %{public}llu of %{public}llu bytes", dirtyRanges.size(),
+        dst.c_str(), static_cast<unsigned long long>(dirtySize), static_cast<unsigned long long>(fileSize));
+    return 0;
+}
+
+int MtpFsDevice::SendObjectRanges(const std::string &src, uint32_t fileId,
+    const std::map<uint64_t, uint64_t> &dirtyRanges)
+{
+    int fd = ::open(src.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOGE("Could not open %{public}s, errno %{public}d", src.c_str(), errno);
+        return -errno;
+    }
+    readCache_.Invalidate(fileId);
+    std::vector<unsigned char> buf(WRITE_BACK_CHUNK);
+    uint64_t sent = 0;
+    uint64_t startUs = SteadyNowUs();
+    int rval = 0;
+    for (auto it = dirtyRanges.begin(); it != dirtyRanges.end() && rval == 0; ++it) {
+        for (uint64_t offset = it->first; offset < it->second;) {
+            size_t len = static_cast<size_t>(std::min(WRITE_BACK_CHUNK, it->second - offset));
+            ssize_t readLen = ::pread(fd, buf.data(), len, static_cast<off_t>(offset));
+            if (readLen <= 0) {
+                rval = -EIO;
+                break;
+            }
+            CriticalEnter();
+            int ret = LIBMTP_SendPartialObject(device_, fileId, offset, buf.data(), static_cast<uint32_t>(readLen));
+            CriticalLeave();
+            if (ret < 0) {
+                rval = -EIO;
+                break;
+            }
+            offset += static_cast<uint64_t>(readLen);
+            sent += static_cast<uint64_t>(readLen);
+        }
+    }
+    ::close(fd);
+    if (rval == 0) {
+        transferStats_.Record(MtpFsTransferStats::TRANSFER_PARTIAL_WRITE, sent, SteadyNowUs() - startUs);
+    }
+    return rval;
+}
+
 int MtpFsDevice::FileRemove(const std::string &path)
 {
     const std::string tmpBaseName(SmtpfsBaseName(path));
     const std::string tmpDirName(SmtpfsDirName(path));
-    const MtpFsTypeDir *dirParent = DirFetchContent(tmpDirName);
-    const MtpFsTypeFile *fileToRemove = dirParent ? dirParent->File(tmpBaseName) : nullptr;
-    if (!dirParent || !fileToRemove) {
-        LOGE("No such file %{public}s to remove", path.c_str());
-        return -ENOENT;
+    uint32_t fileId = 0;
+    {
+        TreeLock lock(*this);
+        const MtpFsTypeDir *dirParent = DirFetchContent(tmpDirName);
+        const MtpFsTypeFile *fileToRemove = dirParent ? dirParent->File(tmpBaseName) : nullptr;
+        if (!dirParent || !fileToRemove) {
+            LOGE("No such file %{public}s to remove", path.c_str());
+            return -ENOENT;
+        }
+        fileId = fileToRemove->Id();
     }
+    readCache_.Release(fileId);
     CriticalEnter();
-    int rval = LIBMTP_Delete_Object(device_, fileToRemove->Id());
+    int rval = LIBMTP_Delete_Object(device_, fileId);
     CriticalLeave();
     if (rval != 0) {
         LOGE("Could not remove the directory %{public}s", path.c_str());
         return -EINVAL;
     }
-    const_cast<MtpFsTypeDir *>(dirParent)->RemoveFile(*fileToRemove);
+    dirCache_.DropLocalMtime(fileId);
+    TreeLock lock(*this, true);
+    MtpFsTypeDir *dirParent = DirLookup(tmpDirName, false);
+    const MtpFsTypeFile *fileToRemove = dirParent ? dirParent->File(tmpBaseName) : nullptr;
+    if (fileToRemove && fileToRemove->Id() == fileId) {
+        dirParent->RemoveFile(*fileToRemove);
+    }
     LOGI("File %{public}s removed", path.c_str());
     return 0;
 }
@@ -613,26 +964,36 @@ int MtpFsDevice::FileRename(const std::string &oldPath, const std::string &newPa
     const std::string tmpOldDirName(SmtpfsDirName(oldPath));
     const std::string tmpNewBaseName(SmtpfsBaseName(newPath));
     const std::string tmpNewDirName(SmtpfsDirName(newPath));
-    const MtpFsTypeDir *dirParent = DirFetchContent(tmpOldDirName);
-    const MtpFsTypeFile *fileToReName = dirParent ? dirParent->File(tmpOldBaseName) : nullptr;
-    if (!dirParent || !fileToReName || tmpOldDirName != tmpNewDirName) {
-        LOGE("Can not rename %{public}s to %{public}s", oldPath.c_str(), tmpNewBaseName.c_str());
-        return -EINVAL;
+    LIBMTP_file_t *file = nullptr;
+    {
+        TreeLock lock(*this);
+        const MtpFsTypeDir *dirParent = DirFetchContent(tmpOldDirName);
+        const MtpFsTypeFile *fileToReName = dirParent ? dirParent->File(tmpOldBaseName) : nullptr;
+        if (!dirParent || !fileToReName || tmpOldDirName != tmpNewDirName) {
+            LOGE("Can not rename %{public}s to %{public}s", oldPath.c_str(), tmpNewBaseName.c_str());
+            return -EINVAL;
+        }
+        file = fileToReName->ToLIBMTPFile();
     }
 
-    LIBMTP_file_t *file = fileToReName->ToLIBMTPFile();
     CriticalEnter();
     int rval = LIBMTP_Set_File_Name(device_, file, tmpNewBaseName.c_str());
-    CriticalLeave();
-    free(static_cast<void *>(file->filename));
-    free(static_cast<void *>(file));
     if (rval > 0) {
         LOGE("Could not rename %{public}s to %{public}s", oldPath.c_str(), newPath.c_str());
         LIBMTP_Dump_Errorstack(device_);
         LIBMTP_Clear_Errorstack(device_);
+    }
+    CriticalLeave();
+    free(static_cast<void *>(file->filename));
+    free(static_cast<void *>(file));
+    if (rval > 0) {
         return -EINVAL;
     }
-    const_cast<MtpFsTypeFile *>(fileToReName)->SetName(tmpNewBaseName);
+    TreeLock lock(*this, true);
+    MtpFsTypeDir *dirParent = DirLookup(tmpOldDirName, false);
+    if (dirParent) {
+        dirParent->RenameFile(tmpOldBaseName, tmpNewBaseName);
+    }
     LOGI("File %{public}s renamed to %{public}s", oldPath.c_str(), tmpNewBaseName.c_str());
     return 0;
 }
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mtpfs_read_cache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <pthread.h>
+
+#include "securec.h"
+#include "storage_service_log.h"
+
+namespace {
+const uint32_t READ_BLOCK_SIZE = 512 * 1024;
+const uint32_t MAX_READAHEAD_BLOCKS = 8;
+const uint32_t MAX_CACHED_BLOCKS = 64;
+// number of back to back reads before a reader is handled as a sequential stream
+const uint32_t SEQ_READ_THRESHOLD = 2;
+}
+
+MtpFsReadCache::MtpFsReadCache(const FetchFunc &fetch) : fetch_(fetch), stop_(false) {}
+
+MtpFsReadCache::~MtpFsReadCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    taskCond_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+int MtpFsReadCache::Read(uint32_t objectId, uint64_t objectSize, char *buf, size_t size, off_t offset)
+{
+    if (offset < 0) {
+        return -EINVAL;
+    }
+    uint64_t start = static_cast<uint64_t>(offset);
+    if (start >= objectSize || size == 0) {
+        return 0;
+    }
+    uint64_t end = std::min<uint64_t>(start + size, objectSize);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    ObjectCache &obj = objects_[objectId];
+    if (obj.objectSize != objectSize) {
+        obj.objectSize = objectSize;
+        obj.generation++;
+        ClearBlocksLocked(obj);
+        blockCond_.notify_all();
+    }
+    bool sequential = start == obj.nextOffset && obj.seqCount + 1 >= SEQ_READ_THRESHOLD;
+    if (!sequential && !IsCachedLocked(obj, start, end)) {
+        // random access, fetch exactly what is asked for and leave the cache alone
+        UpdatePatternLocked(objectId, start, end);
+        lock.unlock();
+        std::vector<char> data;
+        int ret = fetch_(objectId, start, static_cast<uint32_t>(end - start), data);
+        if (ret != 0) {
+            return ret;
+        }
+        if (!data.empty() && memcpy_s(buf, size, data.data(), data.size()) != EOK) {
+            LOGE("memcpy_s partial object fail");
+            return -EIO;
+        }
+        return static_cast<int>(data.size());
+    }
+
+    uint64_t pos = start;
+    std::vector<char> scratch;
+    while (pos < end) {
+        uint64_t index = pos / READ_BLOCK_SIZE;
+        const std::vector<char> *data = GetBlockLocked(lock, objectId, index, scratch);
+        if (data == nullptr) {
+            if (pos == start) {
+                return -EIO;
+            }
+            break;
+        }
+        uint64_t inBlock = pos - index * READ_BLOCK_SIZE;
+        if (inBlock >= data->size()) {
+            break;
+        }
+        size_t len = static_cast<size_t>(std::min<uint64_t>(end - pos, data->size() - inBlock));
+        if (memcpy_s(buf + (pos - start), size - (pos - start), data->data() + inBlock, len) != EOK) {
+            LOGE("memcpy_s cached block fail");
+            return -EIO;
+        }
+        pos += len;
+    }
+    UpdatePatternLocked(objectId, start, pos);
+    return static_cast<int>(pos - start);
+}
+
+void MtpFsReadCache::Invalidate(uint32_t objectId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = objects_.find(objectId);
+    if (it == objects_.end()) {
+        return;
+    }
+    it->second.generation++;
+    ClearBlocksLocked(it->second);
+    it->second.nextOffset = 0;
+    it->second.seqCount = 0;
+    it->second.window = 0;
+    blockCond_.notify_all();
+}
+
+void MtpFsReadCache::Release(uint32_t objectId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = objects_.find(objectId);
+    if (it == objects_.end()) {
+        return;
+    }
+    ClearBlocksLocked(it->second);
+    objects_.erase(it);
+    blockCond_.notify_all();
+}
+
+bool MtpFsReadCache::IsCachedLocked(const ObjectCache &obj, uint64_t start, uint64_t end)
+{
+    for (uint64_t index = start / READ_BLOCK_SIZE; index * READ_BLOCK_SIZE < end; index++) {
+        auto it = obj.blocks.find(index);
+        if (it == obj.blocks.end() || it->second.state != BLOCK_READY) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const std::vector<char> *MtpFsReadCache::GetBlockLocked(std::unique_lock<std::mutex> &lock, uint32_t objectId,
+    uint64_t index, std::vector<char> &scratch)
+{
+    for (;;) {
+        auto objIt = objects_.find(objectId);
+        if (objIt == objects_.end()) {
+            return nullptr;
+        }
+        auto it = objIt->second.blocks.find(index);
+        if (it == objIt->second.blocks.end()) {
+            break;
+        }
+        if (it->second.state == BLOCK_READY) {
+            lru_.splice(lru_.begin(), lru_, it->second.lruIt);
+            return &it->second.data;
+        }
+        // fetched by the readahead thread or another reader right now
+        blockCond_.wait(lock);
+    }
+
+    ObjectCache &obj = objects_[objectId];
+    uint64_t offset = index * READ_BLOCK_SIZE;
+    uint32_t size = static_cast<uint32_t>(std::min<uint64_t>(READ_BLOCK_SIZE, obj.objectSize - offset));
+    uint64_t generation = obj.generation;
+    obj.blocks[index].state = BLOCK_LOADING;
+    lock.unlock();
+    scratch.clear();
+    int ret = fetch_(objectId, offset, size, scratch);
+    lock.lock();
+    if (!FinishBlockLocked(objectId, index, generation, ret, scratch)) {
+        return ret == 0 ? &scratch : nullptr;
+    }
+    return &objects_[objectId].blocks[index].data;
+}
+
+bool MtpFsReadCache::FinishBlockLocked(uint32_t objectId, uint64_t index, uint64_t generation, int ret,
+    std::vector<char> &data)
+{
+    blockCond_.notify_all();
+    auto objIt = objects_.find(objectId);
+    if (objIt == objects_.end() || objIt->second.generation != generation) {
+        return false;
+    }
+    auto it = objIt->second.blocks.find(index);
+    if (it == objIt->second.blocks.end()) {
+        return false;
+    }
+    if (ret != 0) {
+        objIt->second.blocks.erase(it);
+        return false;
+    }
+    it->second.data.swap(data);
+    it->second.state = BLOCK_READY;
+    it->second.lruIt = lru_.insert(lru_.begin(), { objectId, index });
+    EvictLocked();
+    return true;
+}
+
+void MtpFsReadCache::UpdatePatternLocked(uint32_t objectId, uint64_t offset, uint64_t end)
+{
+    auto objIt = objects_.find(objectId);
+    if (objIt == objects_.end()) {
+        return;
+    }
+    ObjectCache &obj = objIt->second;
+    if (offset == obj.nextOffset) {
+        obj.seqCount++;
+    } else {
+        obj.seqCount = 0;
+        obj.window = 0;
+    }
+    obj.nextOffset = end;
+    if (obj.seqCount < SEQ_READ_THRESHOLD || end >= obj.objectSize) {
+        return;
+    }
+    // double the window on every sequential read, the way the kernel page cache ramps up its readahead
+    obj.window = std::min(std::max(obj.window * 2, 1U), MAX_READAHEAD_BLOCKS);
+    uint64_t first = end / READ_BLOCK_SIZE;
+    bool queued = false;
+    for (uint64_t index = first; index < first + obj.window && index * READ_BLOCK_SIZE < obj.objectSize; index++) {
+        if (obj.blocks.find(index) != obj.blocks.end()) {
+            continue;
+        }
+        obj.blocks[index].state = BLOCK_LOADING;
+        tasks_.push_back({ objectId, index, obj.generation });
+        queued = true;
+    }
+    if (!queued) {
+        return;
+    }
+    if (!worker_.joinable()) {
+        // started on demand, fuse_main forks into the background after the cache is constructed
+        worker_ = std::thread(&MtpFsReadCache::ReadaheadWorker, this);
+    }
+    taskCond_.notify_one();
+}
+
+void MtpFsReadCache::ClearBlocksLocked(ObjectCache &obj)
+{
+    for (auto &blockPair : obj.blocks) {
+        if (blockPair.second.state == BLOCK_READY) {
+            lru_.erase(blockPair.second.lruIt);
+        }
+    }
+    obj.blocks.clear();
+}
+
+void MtpFsReadCache::EvictLocked()
+{
+    while (lru_.size() > MAX_CACHED_BLOCKS) {
+        const BlockKey &victim = lru_.back();
+        auto objIt = objects_.find(victim.objectId);
+        if (objIt != objects_.end()) {
+            objIt->second.blocks.erase(victim.index);
+        }
+        lru_.pop_back();
+    }
+}
+
+void MtpFsReadCache::ReadaheadWorker()
+{
+    pthread_setname_np(pthread_self(), "mtpfs_readahead");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (tasks_.empty()) {
+            taskCond_.wait(lock);
+            continue;
+        }
+        ReadaheadTask task = tasks_.front();
+        tasks_.pop_front();
+        auto objIt = objects_.find(task.objectId);
+        if (objIt == objects_.end() || objIt->second.generation != task.generation) {
+            continue;
+        }
+        uint64_t offset = task.index * READ_BLOCK_SIZE;
+        uint32_t size = static_cast<uint32_t>(std::min<uint64_t>(READ_BLOCK_SIZE, objIt->second.objectSize - offset));
+        lock.unlock();
+        std::vector<char> data;
+        int ret = fetch_(task.objectId, offset, size, data);
+        lock.lock();
+        FinishBlockLocked(task.objectId, task.index, task.generation, ret, data);
+    }
+}
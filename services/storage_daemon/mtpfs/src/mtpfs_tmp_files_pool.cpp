@@ -15,12 +15,13 @@
 
 #include "mtpfs_tmp_files_pool.h"
 
+#include <atomic>
 #include <sstream>
 
 #include "mtpfs_sha.h"
 #include "mtpfs_util.h"
 
-MtpFsTmpFilesPool::MtpFsTmpFilesPool() : tmpDir_(SmtpfsGetTmpDir()), pool_() {}
+MtpFsTmpFilesPool::MtpFsTmpFilesPool() : tmpDir_(SmtpfsGetTmpDir()), pool_(), poolMutex_() {}
 
 MtpFsTmpFilesPool::~MtpFsTmpFilesPool() {}
 
@@ -44,7 +45,7 @@ const MtpFsTypeTmpFile *MtpFsTmpFilesPool::GetFile(const std::string &path) cons
 
 std::string MtpFsTmpFilesPool::MakeTmpPath(const std::string &pathDevice) const
 {
-    static int cnt = 0;
+    static std::atomic<int> cnt(0);
     std::stringstream ss;
     ss << pathDevice << ++cnt;
     return tmpDir_ + std::string("/") + MtpFsSha::SumString(ss.str());
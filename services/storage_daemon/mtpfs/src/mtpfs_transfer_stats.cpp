@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mtpfs_transfer_stats.h"
+
+#include "storage_service_log.h"
+
+namespace {
+const char *TRANSFER_NAMES[MtpFsTransferStats::TRANSFER_KIND_NUM] = {
+    "pull",
+    "push",
+    "partial read",
+    "partial write",
+};
+// single transfers above this size are logged with their throughput
+const uint64_t LOG_TRANSFER_BYTES = 1024 * 1024;
+const uint64_t KB = 1024;
+const uint64_t US_PER_MS = 1000;
+
+uint64_t ThroughputKBps(uint64_t bytes, uint64_t costUs)
+{
+    return costUs == 0 ? 0 : bytes * US_PER_MS / costUs * US_PER_MS / KB;
+}
+}
+
+MtpFsTransferStats::MtpFsTransferStats() {}
+
+void MtpFsTransferStats::Record(Kind kind, uint64_t bytes, uint64_t costUs)
+{
+    if (kind < 0 || kind >= TRANSFER_KIND_NUM) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        counters_[kind].count++;
+        counters_[kind].bytes += bytes;
+        counters_[kind].costUs += costUs;
+    }
+    if (bytes >= LOG_TRANSFER_BYTES) {
+        LOGI("mtp %{public}s of %{public}llu bytes took %{public}llu ms, %{public}llu KB/s", TRANSFER_NAMES[kind],
+            static_cast<unsigned long long>(bytes), static_cast<unsigned long long>(costUs / US_PER_MS),
+            static_cast<unsigned long long>(ThroughputKBps(bytes, costUs)));
+    }
+}
+
+void MtpFsTransferStats::Dump()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < TRANSFER_KIND_NUM; i++) {
+        const Counter &counter = counters_[i];
+        if (counter.count == 0) {
+            continue;
+        }
+        LOGI("mtp %{public}s total: %{public}llu transfers, %{public}llu bytes, %{public}llu KB/s", TRANSFER_NAMES[i],
+            static_cast<unsigned long long>(counter.count), static_cast<unsigned long long>(counter.bytes),
+            static_cast<unsigned long long>(ThroughputKBps(counter.bytes, counter.costUs)));
+    }
+}
@@ -15,34 +15,71 @@
 
 #include "mtpfs_type_dir.h"
 
-MtpFsTypeDir::MtpFsTypeDir() : MtpFsTypeBasic(), dirs_(), files_(), accessMutex_(), fetched_(false), modifyDate_(0) {}
+MtpFsTypeDir::MtpFsTypeDir()
+    : MtpFsTypeBasic(), dirs_(), files_(), dirIds_(), fileIds_(), fetched_(false), modifyDate_(0)
+{
+    pthread_rwlock_init(&accessLock_, nullptr);
+}
 
 MtpFsTypeDir::MtpFsTypeDir(uint32_t id, uint32_t parentId, uint32_t storageId, const std::string &name)
     : MtpFsTypeBasic(id, parentId, storageId, name),
       dirs_(),
       files_(),
-      accessMutex_(),
+      dirIds_(),
+      fileIds_(),
       fetched_(false),
       modifyDate_(0)
-{}
+{
+    pthread_rwlock_init(&accessLock_, nullptr);
+}
 
 MtpFsTypeDir::MtpFsTypeDir(LIBMTP_file_t *file)
     : MtpFsTypeBasic(file->item_id, file->parent_id, file->storage_id, std::string(file->filename)),
       dirs_(),
       files_(),
-      accessMutex_(),
+      dirIds_(),
+      fileIds_(),
       fetched_(false),
       modifyDate_(file->modificationdate)
-{}
+{
+    pthread_rwlock_init(&accessLock_, nullptr);
+}
 
 MtpFsTypeDir::MtpFsTypeDir(const MtpFsTypeDir &copy)
     : MtpFsTypeBasic(copy),
-      dirs_(copy.dirs_),
-      files_(copy.files_),
-      accessMutex_(),
-      fetched_(copy.fetched_),
+      dirs_(),
+      files_(),
+      dirIds_(),
+      fileIds_(),
+      fetched_(copy.fetched_.load()),
       modifyDate_(copy.modifyDate_)
-{}
+{
+    pthread_rwlock_init(&accessLock_, nullptr);
+    copy.EnterShared();
+    dirs_ = copy.dirs_;
+    files_ = copy.files_;
+    copy.LeaveCritical();
+    RebuildIndex();
+}
+
+MtpFsTypeDir::~MtpFsTypeDir()
+{
+    pthread_rwlock_destroy(&accessLock_);
+}
+
+void MtpFsTypeDir::RebuildIndex()
+{
+    dirIds_.clear();
+    fileIds_.clear();
+    dirIds_.reserve(dirs_.size());
+    fileIds_.reserve(files_.size());
+    for (auto &entry : dirs_) {
+        dirIds_.emplace(entry.second.Id(), &entry.second);
+    }
+    for (auto &entry : files_) {
+        fileIds_.emplace(entry.second.Id(), &entry.second);
+    }
+}
 
 LIBMTP_folder_t *MtpFsTypeDir::ToLIBMTPFolder() const
 {
@@ -62,25 +99,36 @@ LIBMTP_folder_t *MtpFsTypeDir::ToLIBMTPFolder() const
 void MtpFsTypeDir::AddDir(const MtpFsTypeDir &dir)
 {
     EnterCritical();
-    dirs_.insert(dir);
+    auto ret = dirs_.emplace(dir.Name(), dir);
+    if (ret.second) {
+        // the storages below the root all share the root node id, keep the first one
+        dirIds_.emplace(dir.Id(), &ret.first->second);
+    }
     LeaveCritical();
 }
 
 void MtpFsTypeDir::AddFile(const MtpFsTypeFile &file)
 {
     EnterCritical();
-    files_.insert(file);
+    auto ret = files_.emplace(file.Name(), file);
+    if (ret.second) {
+        fileIds_[file.Id()] = &ret.first->second;
+    }
     LeaveCritical();
 }
 
 bool MtpFsTypeDir::RemoveDir(const MtpFsTypeDir &dir)
 {
     EnterCritical();
-    auto it = std::find(dirs_.begin(), dirs_.end(), dir);
+    auto it = dirs_.find(dir.Name());
     if (it == dirs_.end()) {
         LeaveCritical();
         return false;
     }
+    auto idIt = dirIds_.find(it->second.Id());
+    if (idIt != dirIds_.end() && idIt->second == &it->second) {
+        dirIds_.erase(idIt);
+    }
     dirs_.erase(it);
     LeaveCritical();
     return true;
@@ -89,11 +137,15 @@ bool MtpFsTypeDir::RemoveDir(const MtpFsTypeDir &dir)
 bool MtpFsTypeDir::RemoveFile(const MtpFsTypeFile &file)
 {
     EnterCritical();
-    auto it = std::find(files_.begin(), files_.end(), file);
+    auto it = files_.find(file.Name());
     if (it == files_.end()) {
         LeaveCritical();
         return false;
     }
+    auto idIt = fileIds_.find(it->second.Id());
+    if (idIt != fileIds_.end() && idIt->second == &it->second) {
+        fileIds_.erase(idIt);
+    }
     files_.erase(it);
     LeaveCritical();
     return true;
@@ -102,44 +154,121 @@ bool MtpFsTypeDir::RemoveFile(const MtpFsTypeFile &file)
 bool MtpFsTypeDir::ReplaceFile(const MtpFsTypeFile &oldFile, const MtpFsTypeFile &newFile)
 {
     EnterCritical();
-    auto it = std::find(files_.begin(), files_.end(), oldFile);
+    auto it = files_.find(oldFile.Name());
     if (it == files_.end()) {
         LeaveCritical();
         return false;
     }
+    auto idIt = fileIds_.find(it->second.Id());
+    if (idIt != fileIds_.end() && idIt->second == &it->second) {
+        fileIds_.erase(idIt);
+    }
+    files_.erase(it);
+    auto ret = files_.emplace(newFile.Name(), newFile);
+    if (ret.second) {
+        fileIds_[newFile.Id()] = &ret.first->second;
+    }
+    LeaveCritical();
+    return true;
+}
+
+bool MtpFsTypeDir::RenameDir(const std::string &oldName, const std::string &newName)
+{
+    EnterCritical();
+    auto it = dirs_.find(oldName);
+    if (it == dirs_.end() || dirs_.find(newName) != dirs_.end()) {
+        LeaveCritical();
+        return false;
+    }
+    // move the subtree over by swapping, a rename must not deep copy a fetched folder
+    MtpFsTypeDir &renamed = dirs_[newName];
+    MtpFsTypeDir &old = it->second;
+    renamed.MtpFsTypeBasic::operator = (old);
+    renamed.SetName(newName);
+    renamed.dirs_.swap(old.dirs_);
+    renamed.files_.swap(old.files_);
+    renamed.dirIds_.swap(old.dirIds_);
+    renamed.fileIds_.swap(old.fileIds_);
+    renamed.fetched_ = old.fetched_.load();
+    renamed.modifyDate_ = old.modifyDate_;
+    auto idIt = dirIds_.find(old.Id());
+    if (idIt != dirIds_.end() && idIt->second == &old) {
+        idIt->second = &renamed;
+    }
+    dirs_.erase(it);
+    LeaveCritical();
+    return true;
+}
+
+bool MtpFsTypeDir::RenameFile(const std::string &oldName, const std::string &newName)
+{
+    EnterCritical();
+    auto it = files_.find(oldName);
+    if (it == files_.end() || files_.find(newName) != files_.end()) {
+        LeaveCritical();
+        return false;
+    }
+    MtpFsTypeFile &renamed = files_[newName];
+    renamed = it->second;
+    renamed.SetName(newName);
+    auto idIt = fileIds_.find(renamed.Id());
+    if (idIt != fileIds_.end() && idIt->second == &it->second) {
+        idIt->second = &renamed;
+    }
     files_.erase(it);
-    files_.insert(newFile);
     LeaveCritical();
     return true;
 }
 
 MtpFsTypeDir &MtpFsTypeDir::operator = (const MtpFsTypeDir &rhs)
 {
+    if (this == &rhs) {
+        return *this;
+    }
     MtpFsTypeBasic::operator = (rhs);
+    EnterCritical();
+    rhs.EnterShared();
     dirs_ = rhs.dirs_;
     files_ = rhs.files_;
-    fetched_ = rhs.fetched_;
+    rhs.LeaveCritical();
+    RebuildIndex();
+    LeaveCritical();
+    fetched_ = rhs.fetched_.load();
     return *this;
 }
 
 const MtpFsTypeDir *MtpFsTypeDir::Dir(const std::string &name) const
 {
-    EnterCritical();
-    auto it = std::find(dirs_.begin(), dirs_.end(), name);
+    EnterShared();
+    auto it = dirs_.find(name);
+    const MtpFsTypeDir *dir = it == dirs_.end() ? nullptr : &it->second;
     LeaveCritical();
-    if (it == dirs_.end()) {
-        return nullptr;
-    }
-    return &*it;
+    return dir;
 }
 
 const MtpFsTypeFile *MtpFsTypeDir::File(const std::string &name) const
 {
-    EnterCritical();
-    auto it = std::find(files_.begin(), files_.end(), name);
+    EnterShared();
+    auto it = files_.find(name);
+    const MtpFsTypeFile *file = it == files_.end() ? nullptr : &it->second;
     LeaveCritical();
-    if (it == files_.end()) {
-        return nullptr;
-    }
-    return &*it;
+    return file;
+}
+
+const MtpFsTypeDir *MtpFsTypeDir::DirById(uint32_t id) const
+{
+    EnterShared();
+    auto it = dirIds_.find(id);
+    const MtpFsTypeDir *dir = it == dirIds_.end() ? nullptr : it->second;
+    LeaveCritical();
+    return dir;
+}
+
+const MtpFsTypeFile *MtpFsTypeDir::FileById(uint32_t id) const
+{
+    EnterShared();
+    auto it = fileIds_.find(id);
+    const MtpFsTypeFile *file = it == fileIds_.end() ? nullptr : it->second;
+    LeaveCritical();
+    return file;
 }
@@ -15,11 +15,15 @@
 
 #include "mtpfs_type_tmp_file.h"
 
-MtpFsTypeTmpFile::MtpFsTypeTmpFile() : pathDevice_(), pathTmp_(), fileDescriptors_(), modified_(false) {}
+#include <algorithm>
+#include <iterator>
+
+MtpFsTypeTmpFile::MtpFsTypeTmpFile() : pathDevice_(), pathTmp_(), fileDescriptors_(), dirtyRanges_(), modified_(false),
+    truncated_(false) {}
 
 MtpFsTypeTmpFile::MtpFsTypeTmpFile(const std::string &pathDevice, const std::string &pathTmp, int fileDesc,
     bool modified)
-    : pathDevice_(pathDevice), pathTmp_(pathTmp), modified_(modified)
+    : pathDevice_(pathDevice), pathTmp_(pathTmp), modified_(modified), truncated_(false)
 {
     fileDescriptors_.insert(fileDesc);
 }
@@ -28,7 +32,9 @@ MtpFsTypeTmpFile::MtpFsTypeTmpFile(const MtpFsTypeTmpFile &copy)
     : pathDevice_(copy.pathDevice_),
       pathTmp_(copy.pathTmp_),
       fileDescriptors_(copy.fileDescriptors_),
-      modified_(copy.modified_)
+      dirtyRanges_(copy.dirtyRanges_),
+      modified_(copy.modified_),
+      truncated_(copy.truncated_)
 {}
 
 bool MtpFsTypeTmpFile::HasFileDescriptor(int fd)
@@ -46,11 +52,36 @@ void MtpFsTypeTmpFile::RemoveFileDescriptor(int fd)
     fileDescriptors_.erase(it);
 }
 
+void MtpFsTypeTmpFile::AddDirtyRange(uint64_t offset, uint64_t size)
+{
+    if (size == 0 || truncated_) {
+        return;
+    }
+    uint64_t start = offset;
+    uint64_t end = offset + size;
+    // merge with every range that overlaps or touches [start, end)
+    auto it = dirtyRanges_.upper_bound(start);
+    if (it != dirtyRanges_.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second >= start) {
+            it = prev;
+        }
+    }
+    while (it != dirtyRanges_.end() && it->first <= end) {
+        start = std::min(start, it->first);
+        end = std::max(end, it->second);
+        it = dirtyRanges_.erase(it);
+    }
+    dirtyRanges_[start] = end;
+}
+
 MtpFsTypeTmpFile &MtpFsTypeTmpFile::operator = (const MtpFsTypeTmpFile &rhs)
 {
     pathDevice_ = rhs.pathDevice_;
     pathTmp_ = rhs.pathTmp_;
     fileDescriptors_ = rhs.fileDescriptors_;
+    dirtyRanges_ = rhs.dirtyRanges_;
     modified_ = rhs.modified_;
+    truncated_ = rhs.truncated_;
     return *this;
 }
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "mtpfs_dir_cache.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+using namespace testing::ext;
+
+namespace {
+// MAX_CACHED_ENTRIES and MAX_PREFETCH_QUEUE of mtpfs_dir_cache.cpp
+const size_t MAX_CACHED_ENTRIES = 100000;
+const size_t MAX_PREFETCH_QUEUE = 512;
+const size_t DIR_ENTRIES = 40000;
+const uint64_t FETCH_COST_US = 1000;
+}
+
+class MtpFsDirCacheTest : public testing::Test {
+public:
+    static void SetUpTestCase(void) {};
+    static void TearDownTestCase(void) {};
+    void SetUp() {};
+    void TearDown() {};
+};
+
+/**
+ * @tc.name: MtpFsDirCacheTest_PickVictims_001
+ * @tc.desc: Verify that the least recently used listings are evicted until the cache is below the budget.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsDirCacheTest, MtpFsDirCacheTest_PickVictims_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsDirCacheTest_PickVictims_001 start";
+    MtpFsDirCache cache;
+    std::vector<std::string> victims;
+    EXPECT_FALSE(cache.RecordFetch("/a", DIR_ENTRIES, FETCH_COST_US, false));
+    EXPECT_FALSE(cache.RecordFetch("/b", DIR_ENTRIES, FETCH_COST_US, true));
+    EXPECT_FALSE(cache.PickVictims(victims));
+
+    cache.Touch("/a");
+    EXPECT_TRUE(cache.RecordFetch("/c", DIR_ENTRIES, FETCH_COST_US, false));
+    EXPECT_TRUE(cache.PickVictims(victims));
+    ASSERT_EQ(victims.size(), 1);
+    EXPECT_EQ(victims[0], "/b");
+
+    cache.Evicted("/b");
+    EXPECT_EQ(cache.totalEntries_, DIR_ENTRIES * 2);
+    victims.clear();
+    EXPECT_FALSE(cache.PickVictims(victims));
+    EXPECT_TRUE(victims.empty());
+    GTEST_LOG_(INFO) << "MtpFsDirCacheTest_PickVictims_001 end";
+}
+
+/**
+ * @tc.name: MtpFsDirCacheTest_Evicted_001
+ * @tc.desc: Verify that evicting a folder drops the listings below it and a refetch replaces the old count.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsDirCacheTest, MtpFsDirCacheTest_Evicted_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsDirCacheTest_Evicted_001 start";
+    MtpFsDirCache cache;
+    EXPECT_FALSE(cache.RecordFetch("/x", DIR_ENTRIES, FETCH_COST_US, false));
+    EXPECT_FALSE(cache.RecordFetch("/x/y", DIR_ENTRIES, FETCH_COST_US, false));
+    EXPECT_FALSE(cache.RecordFetch("/xy", 2, FETCH_COST_US, false));
+    EXPECT_FALSE(cache.RecordFetch("/xy", 1, FETCH_COST_US, false));
+    EXPECT_EQ(cache.totalEntries_, DIR_ENTRIES * 2 + 1);
+
+    cache.Evicted("/x");
+    EXPECT_EQ(cache.totalEntries_, 1);
+    ASSERT_EQ(cache.dirs_.size(), 1);
+    EXPECT_EQ(cache.dirs_.begin()->first, "/xy");
+    EXPECT_FALSE(cache.RecordFetch("/z", MAX_CACHED_ENTRIES - 1, FETCH_COST_US, false));
+    EXPECT_TRUE(cache.RecordFetch("/w", 1, FETCH_COST_US, false));
+    GTEST_LOG_(INFO) << "MtpFsDirCacheTest_Evicted_001 end";
+}
+
+/**
+ * @tc.name: MtpFsDirCacheTest_WaitPrefetch_001
+ * @tc.desc: Verify the prefetch queue order, its bound, the eviction wakeup and the stop.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsDirCacheTest, MtpFsDirCacheTest_WaitPrefetch_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsDirCacheTest_WaitPrefetch_001 start";
+    MtpFsDirCache cache;
+    std::string path;
+    uint32_t depth = 0;
+    cache.PushPrefetch({ "/a", "/b" }, 1, false);
+    cache.PushPrefetch({ "/c", "/d" }, 2, true);
+    EXPECT_TRUE(cache.WaitPrefetch(path, depth));
+    EXPECT_EQ(path, "/c");
+    EXPECT_EQ(depth, 2);
+    EXPECT_TRUE(cache.WaitPrefetch(path, depth));
+    EXPECT_EQ(path, "/d");
+    EXPECT_TRUE(cache.WaitPrefetch(path, depth));
+    EXPECT_EQ(path, "/a");
+    EXPECT_EQ(depth, 1);
+    EXPECT_TRUE(cache.WaitPrefetch(path, depth));
+    EXPECT_EQ(path, "/b");
+
+    std::vector<std::string> paths;
+    for (size_t i = 0; i <= MAX_PREFETCH_QUEUE; i++) {
+        paths.push_back("/dir" + std::to_string(i));
+    }
+    cache.PushPrefetch(paths, 0, false);
+    EXPECT_EQ(cache.queue_.size(), MAX_PREFETCH_QUEUE);
+    EXPECT_EQ(cache.queue_.back().path, paths[MAX_PREFETCH_QUEUE - 1]);
+
+    // an eviction is served before the queued folders
+    EXPECT_TRUE(cache.RecordFetch("/big", MAX_CACHED_ENTRIES + 1, FETCH_COST_US, false));
+    EXPECT_TRUE(cache.WaitPrefetch(path, depth));
+    EXPECT_TRUE(path.empty());
+    EXPECT_TRUE(cache.WaitPrefetch(path, depth));
+    EXPECT_EQ(path, "/dir0");
+
+    cache.Stop();
+    EXPECT_TRUE(cache.IsStopped());
+    EXPECT_TRUE(cache.queue_.empty());
+    EXPECT_FALSE(cache.WaitPrefetch(path, depth));
+    GTEST_LOG_(INFO) << "MtpFsDirCacheTest_WaitPrefetch_001 end";
+}
+
+/**
+ * @tc.name: MtpFsDirCacheTest_LocalMtime_001
+ * @tc.desc: Verify that the local modification dates survive the eviction of the listings.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsDirCacheTest, MtpFsDirCacheTest_LocalMtime_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsDirCacheTest_LocalMtime_001 start";
+    MtpFsDirCache cache;
+    time_t mtime = 0;
+    EXPECT_FALSE(cache.LocalMtime(1, mtime));
+
+    cache.SetLocalMtime(1, 100);
+    cache.SetLocalMtime(1, 200);
+    EXPECT_FALSE(cache.RecordFetch("/a", DIR_ENTRIES, FETCH_COST_US, false));
+    cache.Evicted("/a");
+    EXPECT_TRUE(cache.LocalMtime(1, mtime));
+    EXPECT_EQ(mtime, 200);
+
+    cache.DropLocalMtime(1);
+    EXPECT_FALSE(cache.LocalMtime(1, mtime));
+    GTEST_LOG_(INFO) << "MtpFsDirCacheTest_LocalMtime_001 end";
+}
+} // namespace StorageDaemon
+} // namespace OHOS
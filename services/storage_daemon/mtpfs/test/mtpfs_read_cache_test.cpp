@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mtpfs_read_cache.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+using namespace testing::ext;
+
+namespace {
+// READ_BLOCK_SIZE, MAX_READAHEAD_BLOCKS and MAX_CACHED_BLOCKS of mtpfs_read_cache.cpp
+const uint64_t READ_BLOCK_SIZE = 512 * 1024;
+const uint32_t MAX_READAHEAD_BLOCKS = 8;
+const size_t MAX_CACHED_BLOCKS = 64;
+const uint32_t OBJECT_ID = 1;
+const int WAIT_RETRY_TIMES = 500;
+const std::chrono::milliseconds WAIT_INTERVAL(10);
+
+// a device that returns the low byte of the offset for every byte and records the fetched ranges
+class FakeDevice {
+public:
+    MtpFsReadCache::FetchFunc Fetcher()
+    {
+        return [this](uint32_t objectId, uint64_t offset, uint32_t size, std::vector<char> &data) {
+            data.resize(size);
+            for (uint32_t i = 0; i < size; i++) {
+                data[i] = static_cast<char>((offset + i) & 0xff);
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            fetches_.emplace_back(offset, size);
+            return 0;
+        };
+    }
+    std::vector<std::pair<uint64_t, uint32_t>> Fetches()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return fetches_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::pair<uint64_t, uint32_t>> fetches_;
+};
+
+bool WaitReadaheadIdle(MtpFsReadCache &cache)
+{
+    for (int i = 0; i < WAIT_RETRY_TIMES; i++) {
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex_);
+            bool loading = false;
+            for (auto &objPair : cache.objects_) {
+                for (auto &blockPair : objPair.second.blocks) {
+                    loading = loading || blockPair.second.state == MtpFsReadCache::BLOCK_LOADING;
+                }
+            }
+            if (cache.tasks_.empty() && !loading) {
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(WAIT_INTERVAL);
+    }
+    return false;
+}
+}
+
+class MtpFsReadCacheTest : public testing::Test {
+public:
+    static void SetUpTestCase(void) {};
+    static void TearDownTestCase(void) {};
+    void SetUp() {};
+    void TearDown() {};
+};
+
+/**
+ * @tc.name: MtpFsReadCacheTest_Read_001
+ * @tc.desc: Verify that random reads are fetched as asked and the third back to back read goes through blocks.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsReadCacheTest, MtpFsReadCacheTest_Read_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsReadCacheTest_Read_001 start";
+    FakeDevice device;
+    MtpFsReadCache cache(device.Fetcher());
+    const uint64_t objectSize = READ_BLOCK_SIZE * 4;
+    const size_t readSize = 4096;
+    std::vector<char> buf(readSize);
+    EXPECT_EQ(cache.Read(OBJECT_ID, objectSize, buf.data(), readSize, -1), -EINVAL);
+    EXPECT_EQ(cache.Read(OBJECT_ID, objectSize, buf.data(), readSize, objectSize), 0);
+
+    EXPECT_EQ(cache.Read(OBJECT_ID, objectSize, buf.data(), readSize, READ_BLOCK_SIZE), readSize);
+    EXPECT_EQ(buf[1], 1);
+    EXPECT_EQ(cache.Read(OBJECT_ID, objectSize, buf.data(), readSize, 0), readSize);
+    auto fetches = device.Fetches();
+    ASSERT_EQ(fetches.size(), 2);
+    EXPECT_EQ(fetches[1], std::make_pair(static_cast<uint64_t>(0), static_cast<uint32_t>(readSize)));
+    EXPECT_TRUE(cache.lru_.empty());
+
+    // the second read in a row is still served as asked, the third one fetches the whole block
+    EXPECT_EQ(cache.Read(OBJECT_ID, objectSize, buf.data(), readSize, readSize), readSize);
+    EXPECT_EQ(device.Fetches().size(), 3);
+    EXPECT_EQ(cache.Read(OBJECT_ID, objectSize, buf.data(), readSize, readSize * 2), readSize);
+    fetches = device.Fetches();
+    ASSERT_EQ(fetches.size(), 4);
+    EXPECT_EQ(fetches[3], std::make_pair(static_cast<uint64_t>(0), static_cast<uint32_t>(READ_BLOCK_SIZE)));
+    EXPECT_EQ(buf[0], static_cast<char>((readSize * 2) & 0xff));
+    EXPECT_EQ(cache.lru_.size(), 1);
+
+    // a seek breaks the stream, a cached range is still served from memory
+    EXPECT_EQ(cache.Read(OBJECT_ID, objectSize, buf.data(), readSize, 0), readSize);
+    EXPECT_EQ(device.Fetches().size(), 4);
+    EXPECT_EQ(cache.objects_[OBJECT_ID].seqCount, 0);
+    GTEST_LOG_(INFO) << "MtpFsReadCacheTest_Read_001 end";
+}
+
+/**
+ * @tc.name: MtpFsReadCacheTest_Readahead_001
+ * @tc.desc: Verify that the readahead window doubles on every sequential read up to its bound.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsReadCacheTest, MtpFsReadCacheTest_Readahead_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsReadCacheTest_Readahead_001 start";
+    FakeDevice device;
+    MtpFsReadCache cache(device.Fetcher());
+    const uint64_t objectSize = READ_BLOCK_SIZE * 32;
+    std::vector<char> buf(READ_BLOCK_SIZE);
+    const std::vector<uint32_t> expectWindows = { 0, 1, 2, 4, 8, 8 };
+    for (size_t i = 0; i < expectWindows.size(); i++) {
+        uint64_t offset = READ_BLOCK_SIZE * i;
+        EXPECT_EQ(cache.Read(OBJECT_ID, objectSize, buf.data(), buf.size(), offset), buf.size());
+        EXPECT_EQ(buf[1], static_cast<char>((offset + 1) & 0xff));
+        std::lock_guard<std::mutex> lock(cache.mutex_);
+        EXPECT_EQ(cache.objects_[OBJECT_ID].window, expectWindows[i]);
+    }
+    ASSERT_TRUE(WaitReadaheadIdle(cache));
+
+    // blocks up to the window past the last read are fetched ahead, each block once
+    const uint64_t lastBlock = expectWindows.size() - 1 + MAX_READAHEAD_BLOCKS;
+    auto fetches = device.Fetches();
+    std::vector<bool> fetched(lastBlock + 1, false);
+    for (size_t i = 1; i < fetches.size(); i++) {
+        uint64_t index = fetches[i].first / READ_BLOCK_SIZE;
+        ASSERT_LE(index, lastBlock);
+        EXPECT_FALSE(fetched[index]);
+        fetched[index] = true;
+    }
+    for (uint64_t index = 1; index <= lastBlock; index++) {
+        EXPECT_TRUE(fetched[index]);
+    }
+    GTEST_LOG_(INFO) << "MtpFsReadCacheTest_Readahead_001 end";
+}
+
+/**
+ * @tc.name: MtpFsReadCacheTest_Invalidate_001
+ * @tc.desc: Verify that a size change, Invalidate and Release drop the cached blocks of the object.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsReadCacheTest, MtpFsReadCacheTest_Invalidate_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsReadCacheTest_Invalidate_001 start";
+    FakeDevice device;
+    MtpFsReadCache cache(device.Fetcher());
+    const uint64_t objectSize = READ_BLOCK_SIZE * 2;
+    std::vector<char> buf(READ_BLOCK_SIZE);
+    for (uint64_t offset = 0; offset < objectSize; offset += READ_BLOCK_SIZE / 2) {
+        EXPECT_EQ(cache.Read(OBJECT_ID, objectSize, buf.data(), READ_BLOCK_SIZE / 2, offset), READ_BLOCK_SIZE / 2);
+    }
+    ASSERT_TRUE(WaitReadaheadIdle(cache));
+    EXPECT_EQ(cache.objects_[OBJECT_ID].generation, 1);
+    EXPECT_EQ(cache.lru_.size(), 2);
+
+    EXPECT_EQ(cache.Read(OBJECT_ID, objectSize + 1, buf.data(), 1, 0), 1);
+    EXPECT_EQ(cache.objects_[OBJECT_ID].generation, 2);
+    EXPECT_TRUE(cache.objects_[OBJECT_ID].blocks.empty());
+    EXPECT_TRUE(cache.lru_.empty());
+
+    for (uint64_t offset = 0; offset < objectSize; offset += READ_BLOCK_SIZE / 2) {
+        cache.Read(OBJECT_ID, objectSize + 1, buf.data(), READ_BLOCK_SIZE / 2, offset);
+    }
+    ASSERT_TRUE(WaitReadaheadIdle(cache));
+    EXPECT_FALSE(cache.lru_.empty());
+    cache.Invalidate(OBJECT_ID);
+    EXPECT_EQ(cache.objects_[OBJECT_ID].generation, 3);
+    EXPECT_TRUE(cache.objects_[OBJECT_ID].blocks.empty());
+    EXPECT_EQ(cache.objects_[OBJECT_ID].seqCount, 0);
+    EXPECT_EQ(cache.objects_[OBJECT_ID].window, 0);
+    EXPECT_TRUE(cache.lru_.empty());
+
+    for (uint64_t offset = 0; offset < objectSize; offset += READ_BLOCK_SIZE / 2) {
+        cache.Read(OBJECT_ID, objectSize + 1, buf.data(), READ_BLOCK_SIZE / 2, offset);
+    }
+    ASSERT_TRUE(WaitReadaheadIdle(cache));
+    EXPECT_FALSE(cache.lru_.empty());
+    cache.Release(OBJECT_ID);
+    EXPECT_TRUE(cache.objects_.empty());
+    EXPECT_TRUE(cache.lru_.empty());
+    GTEST_LOG_(INFO) << "MtpFsReadCacheTest_Invalidate_001 end";
+}
+
+/**
+ * @tc.name: MtpFsReadCacheTest_Evict_001
+ * @tc.desc: Verify that the least recently used block is evicted once more than 64 blocks are ready.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsReadCacheTest, MtpFsReadCacheTest_Evict_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsReadCacheTest_Evict_001 start";
+    FakeDevice device;
+    MtpFsReadCache cache(device.Fetcher());
+    const uint32_t otherObjectId = OBJECT_ID + 1;
+    std::vector<char> scratch;
+    std::unique_lock<std::mutex> lock(cache.mutex_);
+    cache.objects_[OBJECT_ID].objectSize = READ_BLOCK_SIZE * MAX_CACHED_BLOCKS;
+    cache.objects_[otherObjectId].objectSize = READ_BLOCK_SIZE * 2;
+    for (uint64_t index = 0; index < MAX_CACHED_BLOCKS; index++) {
+        ASSERT_NE(cache.GetBlockLocked(lock, OBJECT_ID, index, scratch), nullptr);
+    }
+    EXPECT_EQ(cache.lru_.size(), MAX_CACHED_BLOCKS);
+
+    // a hit makes block 0 the most recently used, block 1 becomes the oldest one
+    ASSERT_NE(cache.GetBlockLocked(lock, OBJECT_ID, 0, scratch), nullptr);
+    EXPECT_EQ(device.Fetches().size(), MAX_CACHED_BLOCKS);
+    ASSERT_NE(cache.GetBlockLocked(lock, otherObjectId, 0, scratch), nullptr);
+    EXPECT_EQ(cache.lru_.size(), MAX_CACHED_BLOCKS);
+    auto &blocks = cache.objects_[OBJECT_ID].blocks;
+    EXPECT_EQ(blocks.count(1), 0);
+    EXPECT_EQ(blocks.count(0), 1);
+    EXPECT_EQ(blocks.size(), MAX_CACHED_BLOCKS - 1);
+
+    ASSERT_NE(cache.GetBlockLocked(lock, otherObjectId, 1, scratch), nullptr);
+    EXPECT_EQ(blocks.count(2), 0);
+    EXPECT_EQ(cache.lru_.front().objectId, otherObjectId);
+    EXPECT_EQ(cache.lru_.back().index, 3);
+    GTEST_LOG_(INFO) << "MtpFsReadCacheTest_Evict_001 end";
+}
+} // namespace StorageDaemon
+} // namespace OHOS
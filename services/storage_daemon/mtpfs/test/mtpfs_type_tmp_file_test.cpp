@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "mtpfs_type_tmp_file.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+using namespace testing::ext;
+
+namespace {
+const std::string PATH_DEVICE = "/Internal storage/DCIM/video.mp4";
+const std::string PATH_TMP = "/data/local/tmp/mtpfs_tmp_file_test";
+}
+
+class MtpFsTypeTmpFileTest : public testing::Test {
+public:
+    static void SetUpTestCase(void) {};
+    static void TearDownTestCase(void) {};
+    void SetUp() {};
+    void TearDown() {};
+};
+
+/**
+ * @tc.name: MtpFsTypeTmpFileTest_AddDirtyRange_001
+ * @tc.desc: Verify that disjoint ranges are kept apart and empty writes are ignored.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsTypeTmpFileTest, MtpFsTypeTmpFileTest_AddDirtyRange_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsTypeTmpFileTest_AddDirtyRange_001 start";
+    MtpFsTypeTmpFile tmpFile(PATH_DEVICE, PATH_TMP, 0);
+    tmpFile.AddDirtyRange(100, 0);
+    EXPECT_TRUE(tmpFile.DirtyRanges().empty());
+
+    tmpFile.AddDirtyRange(100, 10);
+    tmpFile.AddDirtyRange(0, 10);
+    tmpFile.AddDirtyRange(200, 10);
+    std::map<uint64_t, uint64_t> expected = { { 0, 10 }, { 100, 110 }, { 200, 210 } };
+    EXPECT_EQ(tmpFile.DirtyRanges(), expected);
+    GTEST_LOG_(INFO) << "MtpFsTypeTmpFileTest_AddDirtyRange_001 end";
+}
+
+/**
+ * @tc.name: MtpFsTypeTmpFileTest_AddDirtyRange_002
+ * @tc.desc: Verify that touching ranges are merged on both sides.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsTypeTmpFileTest, MtpFsTypeTmpFileTest_AddDirtyRange_002, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsTypeTmpFileTest_AddDirtyRange_002 start";
+    MtpFsTypeTmpFile tmpFile(PATH_DEVICE, PATH_TMP, 0);
+    tmpFile.AddDirtyRange(0, 10);
+    tmpFile.AddDirtyRange(20, 10);
+    // [10, 20) touches the end of the first range and the start of the second one
+    tmpFile.AddDirtyRange(10, 10);
+    std::map<uint64_t, uint64_t> expected = { { 0, 30 } };
+    EXPECT_EQ(tmpFile.DirtyRanges(), expected);
+
+    tmpFile.AddDirtyRange(30, 5);
+    expected = { { 0, 35 } };
+    EXPECT_EQ(tmpFile.DirtyRanges(), expected);
+    GTEST_LOG_(INFO) << "MtpFsTypeTmpFileTest_AddDirtyRange_002 end";
+}
+
+/**
+ * @tc.name: MtpFsTypeTmpFileTest_AddDirtyRange_003
+ * @tc.desc: Verify that overlapping and contained ranges are merged into one.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsTypeTmpFileTest, MtpFsTypeTmpFileTest_AddDirtyRange_003, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsTypeTmpFileTest_AddDirtyRange_003 start";
+    MtpFsTypeTmpFile tmpFile(PATH_DEVICE, PATH_TMP, 0);
+    tmpFile.AddDirtyRange(10, 10);
+    tmpFile.AddDirtyRange(40, 10);
+    tmpFile.AddDirtyRange(70, 10);
+    tmpFile.AddDirtyRange(12, 4);
+    std::map<uint64_t, uint64_t> expected = { { 10, 20 }, { 40, 50 }, { 70, 80 } };
+    EXPECT_EQ(tmpFile.DirtyRanges(), expected);
+
+    // spans the first two ranges and overlaps them at both ends
+    tmpFile.AddDirtyRange(5, 40);
+    expected = { { 5, 50 }, { 70, 80 } };
+    EXPECT_EQ(tmpFile.DirtyRanges(), expected);
+
+    tmpFile.AddDirtyRange(0, 100);
+    expected = { { 0, 100 } };
+    EXPECT_EQ(tmpFile.DirtyRanges(), expected);
+    GTEST_LOG_(INFO) << "MtpFsTypeTmpFileTest_AddDirtyRange_003 end";
+}
+
+/**
+ * @tc.name: MtpFsTypeTmpFileTest_AddDirtyRange_004
+ * @tc.desc: Verify that a truncated file drops its ranges and records no new ones, also across copies.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(MtpFsTypeTmpFileTest, MtpFsTypeTmpFileTest_AddDirtyRange_004, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "MtpFsTypeTmpFileTest_AddDirtyRange_004 start";
+    MtpFsTypeTmpFile tmpFile(PATH_DEVICE, PATH_TMP, 0);
+    tmpFile.AddDirtyRange(0, 10);
+    EXPECT_FALSE(tmpFile.IsTruncated());
+
+    tmpFile.SetTruncated();
+    EXPECT_TRUE(tmpFile.IsTruncated());
+    EXPECT_TRUE(tmpFile.DirtyRanges().empty());
+    tmpFile.AddDirtyRange(20, 10);
+    EXPECT_TRUE(tmpFile.DirtyRanges().empty());
+
+    MtpFsTypeTmpFile copy(tmpFile);
+    copy.AddDirtyRange(20, 10);
+    EXPECT_TRUE(copy.IsTruncated());
+    EXPECT_TRUE(copy.DirtyRanges().empty());
+    GTEST_LOG_(INFO) << "MtpFsTypeTmpFileTest_AddDirtyRange_004 end";
+}
+} // namespace StorageDaemon
+} // namespace OHOS
@@ -14,58 +14,104 @@
  */
 #include "netlink/netlink_data.h"
 
+#include <charconv>
+
 #include "ipc/storage_daemon.h"
 #include "storage_service_errno.h"
 #include "storage_service_log.h"
 
 namespace OHOS {
 namespace StorageDaemon {
-constexpr int ACTION_PRE_LEN = 7;
-constexpr int DEVPATH_PRE_LEN = 8;
-constexpr int SUBSYSTEM_PRE_LEN = 10;
-constexpr int NL_PARAMS_MAX = 128;
-const std::string EMPTY_STRING = "";
+namespace {
+constexpr std::string_view SYS_PATH_PREFIX = "/sys";
+// the order follows the Keys of NetlinkData
+constexpr std::string_view KEY_NAMES[] = { "ACTION", "DEVPATH", "SUBSYSTEM", "MAJOR", "MINOR", "DEVTYPE", "PARTN" };
 
-void NetlinkData::Decode(const char *msg)
+int32_t ParseNumber(std::string_view value)
+{
+    int32_t number = -1;
+    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (ec != std::errc() || ptr != value.data() + value.size() || number < 0) {
+        return -1;
+    }
+    return number;
+}
+} // namespace
+
+const std::map<std::string, NetlinkData::Actions, std::less<>> NetlinkData::actionMaps = {
+    {"add", Actions::ADD},
+    {"remove", Actions::REMOVE},
+    {"move", Actions::MOVE},
+    {"change", Actions::CHANGE},
+    {"online", Actions::ONLINE},
+    {"offline", Actions::OFFLINE},
+    {"bind", Actions::BIND},
+    {"unbind", Actions::UNBIND}
+};
+
+void NetlinkData::Reset()
 {
-    int32_t paramIdx = 0;
+    keys_.fill(std::string_view());
+    paramCnt_ = 0;
+    major_ = -1;
+    minor_ = -1;
+    partn_ = -1;
+    action_ = Actions::UNKNOWN;
+}
 
+void NetlinkData::Decode(const char *msg)
+{
+    Reset();
     while (*msg) {
-        if (!strncmp(msg, "ACTION=", ACTION_PRE_LEN)) {
-            msg += ACTION_PRE_LEN;
-            auto iter = actionMaps.find(msg);
-            if (iter != actionMaps.end()) {
-                action_ = iter->second;
-            }
-        } else if (!strncmp(msg, "DEVPATH=", DEVPATH_PRE_LEN)) {
-            msg += DEVPATH_PRE_LEN;
-            devPath_ = std::string(msg);
-            sysPath_ = "/sys" + devPath_;
-        } else if (!strncmp(msg, "SUBSYSTEM=", SUBSYSTEM_PRE_LEN)) {
-            msg += SUBSYSTEM_PRE_LEN;
-            subSystem_ = std::string(msg);
-        } else if (paramIdx < NL_PARAMS_MAX) {
-            params_.push_back(std::string(msg));
-            ++paramIdx;
+        std::string_view field(msg);
+        msg += field.size() + 1;
+        size_t pos = field.find('=');
+        if (pos == std::string_view::npos) {
+            continue;
+        }
+        std::string_view name = field.substr(0, pos);
+        std::string_view value = field.substr(pos + 1);
+        size_t key = 0;
+        while (key < KEY_MAX && KEY_NAMES[key] != name) {
+            key++;
+        }
+        if (key < KEY_MAX) {
+            keys_[key] = value;
+        } else if (paramCnt_ < NL_PARAMS_MAX) {
+            names_[paramCnt_] = name;
+            values_[paramCnt_] = value;
+            paramCnt_++;
         }
-        while (*msg++);
     }
-    return;
+
+    auto iter = actionMaps.find(keys_[KEY_ACTION]);
+    if (iter != actionMaps.end()) {
+        action_ = iter->second;
+    }
+    major_ = ParseNumber(keys_[KEY_MAJOR]);
+    minor_ = ParseNumber(keys_[KEY_MINOR]);
+    partn_ = ParseNumber(keys_[KEY_PARTN]);
 }
 
 std::string NetlinkData::GetSyspath()
 {
-    return sysPath_.empty() ? EMPTY_STRING : sysPath_;
+    if (keys_[KEY_DEVPATH].empty()) {
+        return "";
+    }
+    std::string sysPath;
+    sysPath.reserve(SYS_PATH_PREFIX.size() + keys_[KEY_DEVPATH].size());
+    sysPath.append(SYS_PATH_PREFIX).append(keys_[KEY_DEVPATH]);
+    return sysPath;
 }
 
 std::string NetlinkData::GetDevpath()
 {
-    return devPath_.empty() ? EMPTY_STRING : devPath_;
+    return std::string(keys_[KEY_DEVPATH]);
 }
 
 std::string NetlinkData::GetSubsystem()
 {
-    return subSystem_.empty() ? EMPTY_STRING : subSystem_;
+    return std::string(keys_[KEY_SUBSYSTEM]);
 }
 
 NetlinkData::Actions NetlinkData::GetAction()
@@ -75,17 +121,22 @@ NetlinkData::Actions NetlinkData::GetAction()
 
 const std::string NetlinkData::GetParam(const std::string paramName)
 {
-    size_t len = paramName.size();
+    return std::string(GetParamView(paramName));
+}
 
-    std::vector<std::string>::iterator iter;
-    for (iter = params_.begin(); iter != params_.end(); ++iter) {
-        const char *ptr = iter->c_str() + len;
-        if (strncmp(iter->c_str(), paramName.c_str(), len) == 0 && *ptr == '=') {
-            return ++ptr;
+std::string_view NetlinkData::GetParamView(std::string_view paramName) const
+{
+    for (size_t key = 0; key < KEY_MAX; key++) {
+        if (KEY_NAMES[key] == paramName) {
+            return keys_[key];
         }
     }
-
-    return EMPTY_STRING;
+    for (size_t i = 0; i < paramCnt_; i++) {
+        if (names_[i] == paramName) {
+            return values_[i];
+        }
+    }
+    return std::string_view();
 }
 } // namespace StorageDaemon
 } // namespace OHOS
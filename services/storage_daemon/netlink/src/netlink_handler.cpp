@@ -16,6 +16,9 @@
 #include "netlink/netlink_handler.h"
 
 #include "disk/disk_manager.h"
+#ifdef SUPPORT_OPEN_SOURCE_MTP_DEVICE
+#include "mtp/mtp_device_monitor.h"
+#endif
 #include "netlink/netlink_data.h"
 #include "storage_service_errno.h"
 #include "storage_service_log.h"
@@ -36,14 +39,29 @@ int32_t NetlinkHandler::Stop()
 
 void NetlinkHandler::OnEvent(char *msg)
 {
-    auto nlData = std::make_unique<NetlinkData>();
-    nlData->Decode(msg);
-    if (strcmp(nlData->GetSubsystem().c_str(), "block") == 0) {
+    // decoding only indexes msg, nothing is copied until an event of interest is handled
+    NetlinkData nlData;
+    nlData.Decode(msg);
+    std::string_view subsystem = nlData.GetSubsystemView();
+    if (subsystem == "block") {
         LOGI("OnEvent GetSyspath: %{public}s, GetDevpath: %{public}s, GetSubsystem: %{public}s, GetAction: %{public}d",
-            nlData->GetSyspath().c_str(), nlData->GetDevpath().c_str(),
-            nlData->GetSubsystem().c_str(), nlData->GetAction());
-        DiskManager::Instance()->HandleDiskEvent(nlData.get());
+            nlData.GetSyspath().c_str(), nlData.GetDevpath().c_str(),
+            nlData.GetSubsystem().c_str(), nlData.GetAction());
+        DiskManager::Instance()->HandleDiskEvent(&nlData);
     }
+#ifdef SUPPORT_OPEN_SOURCE_MTP_DEVICE
+    if (subsystem == "usb") {
+        DelayedSingleton<MtpDeviceMonitor>::GetInstance()->HandleUsbEvent(&nlData);
+    }
+#endif
+}
+
+void NetlinkHandler::OnOverrun()
+{
+    DiskManager::Instance()->RescanDisks();
+#ifdef SUPPORT_OPEN_SOURCE_MTP_DEVICE
+    DelayedSingleton<MtpDeviceMonitor>::GetInstance()->Rescan();
+#endif
 }
 } // StorageDaemon
 } // OHOS
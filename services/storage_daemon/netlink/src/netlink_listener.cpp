@@ -15,6 +15,8 @@
 
 #include "netlink/netlink_listener.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <memory>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -26,66 +28,166 @@
 
 constexpr int POLL_IDLE_TIME = 1000;
 constexpr int UEVENT_MSG_LEN = 1024;
+constexpr int UEVENT_BATCH_SIZE = 16;
+constexpr int32_t MAX_RCV_BUF_SIZE = 4 * 1024 * 1024;
+// beyond this the handlers fell behind, the events dropped are recovered as after a socket overrun
+constexpr size_t MAX_PENDING_EVENTS = 4096;
 
 namespace OHOS {
 namespace StorageDaemon {
-ssize_t UeventKernelMulticastRecv(int32_t socket, char *buffer, size_t length)
+namespace {
+struct UeventBatch {
+    char bufs[UEVENT_BATCH_SIZE][UEVENT_MSG_LEN];
+    char controls[UEVENT_BATCH_SIZE][CMSG_SPACE(sizeof(struct ucred))];
+    struct iovec iovs[UEVENT_BATCH_SIZE];
+    struct sockaddr_nl addrs[UEVENT_BATCH_SIZE];
+    struct mmsghdr hdrs[UEVENT_BATCH_SIZE];
+
+    void Reset()
+    {
+        for (int i = 0; i < UEVENT_BATCH_SIZE; i++) {
+            iovs[i] = { bufs[i], UEVENT_MSG_LEN };
+            struct msghdr &hdr = hdrs[i].msg_hdr;
+            hdr.msg_name = &addrs[i];
+            hdr.msg_namelen = sizeof(addrs[i]);
+            hdr.msg_iov = &iovs[i];
+            hdr.msg_iovlen = 1;
+            hdr.msg_control = controls[i];
+            hdr.msg_controllen = sizeof(controls[i]);
+            hdr.msg_flags = 0;
+            hdrs[i].msg_len = 0;
+        }
+    }
+};
+
+bool CheckUeventSender(struct msghdr &hdr)
 {
-    struct iovec iov = { buffer, length };
-    struct sockaddr_nl addr;
-    char control[CMSG_SPACE(sizeof(struct ucred))];
-    struct msghdr hdr = {
-        .msg_name = &addr,
-        .msg_namelen = sizeof(addr),
-        .msg_iov = &iov,
-        .msg_iovlen = 1,
-        .msg_control = control,
-        .msg_controllen = sizeof(control),
-        .msg_flags = 0,
-    };
-    struct cmsghdr *cmsg;
-
-    ssize_t n = recvmsg(socket, &hdr, 0);
-    if (n <= 0) {
-        LOGE("Recvmsg failed, errno %{public}d", errno);
-        return n;
-    }
-
-    if (addr.nl_groups == 0 || addr.nl_pid != 0) {
-        return E_ERR;
+    auto addr = static_cast<struct sockaddr_nl *>(hdr.msg_name);
+    if (addr->nl_groups == 0 || addr->nl_pid != 0) {
+        return false;
     }
 
-    cmsg = CMSG_FIRSTHDR(&hdr);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
     if (cmsg == nullptr || cmsg->cmsg_type != SCM_CREDENTIALS) {
         LOGE("SCM_CREDENTIALS check failed");
-        return E_ERR;
+        return false;
     }
 
     struct ucred cred;
     if (memcpy_s(&cred, sizeof(cred), CMSG_DATA(cmsg), sizeof(struct ucred)) != EOK || cred.uid != 0) {
         LOGE("Uid check failed");
-        return E_ERR;
+        return false;
     }
-
-    return n;
+    return true;
 }
+} // namespace
 
 void NetlinkListener::RecvUeventMsg()
 {
-    auto msg = std::make_unique<char[]>(UEVENT_MSG_LEN + 1);
+    auto batch = std::make_unique<UeventBatch>();
+    std::deque<UeventMsg> received;
 
     while (1) {
-        auto count = UeventKernelMulticastRecv(socketFd_, msg.get(), UEVENT_MSG_LEN);
-        if (count <= 0) {
-            (void)memset_s(msg.get(), UEVENT_MSG_LEN + 1, 0, UEVENT_MSG_LEN + 1);
+        batch->Reset();
+        int count = recvmmsg(socketFd_, batch->hdrs, UEVENT_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == ENOBUFS) {
+                LOGE("Uevent socket overrun, events are lost");
+                received.push_back({ "", true });
+                GrowRecvBuffer();
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOGE("Recvmmsg failed, errno %{public}d", errno);
+            }
             break;
         }
-        if (count >= UEVENT_MSG_LEN) {
-            continue;
+
+        for (int i = 0; i < count; i++) {
+            struct msghdr &hdr = batch->hdrs[i].msg_hdr;
+            size_t len = batch->hdrs[i].msg_len;
+            if (len == 0 || len >= UEVENT_MSG_LEN || (static_cast<uint32_t>(hdr.msg_flags) & MSG_TRUNC) ||
+                !CheckUeventSender(hdr)) {
+                continue;
+            }
+            // the string keeps a terminating zero behind the data, which ends the field list for the decoder
+            received.push_back({ std::string(batch->bufs[i], len), false });
+        }
+        // a storm is handed over batch by batch, so the handlers run while the socket is still drained
+        PushEvents(received);
+        if (count < UEVENT_BATCH_SIZE) {
+            break;
+        }
+    }
+    PushEvents(received);
+}
+
+void NetlinkListener::GrowRecvBuffer()
+{
+    // the kernel reports twice the size that was set, setting the reported size doubles the buffer
+    int32_t size = 0;
+    socklen_t len = sizeof(size);
+    if (getsockopt(socketFd_, SOL_SOCKET, SO_RCVBUF, &size, &len) != 0 || size <= 0) {
+        LOGE("Get SO_RCVBUF failed, errno %{public}d", errno);
+        return;
+    }
+    if (size / 2 >= MAX_RCV_BUF_SIZE) {
+        return;
+    }
+    size = std::min(size, MAX_RCV_BUF_SIZE);
+    if (setsockopt(socketFd_, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0 &&
+        setsockopt(socketFd_, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) != 0) {
+        LOGE("Grow receive buffer failed, errno %{public}d", errno);
+        return;
+    }
+    LOGI("Grow uevent receive buffer to %{public}d", size);
+}
+
+void NetlinkListener::PushEvents(std::deque<UeventMsg> &batch)
+{
+    if (batch.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        for (auto &event : batch) {
+            if (event.overrun || events_.size() < MAX_PENDING_EVENTS) {
+                events_.push_back(std::move(event));
+            } else if (!events_.back().overrun) {
+                events_.push_back({ "", true });
+            }
         }
+    }
+    batch.clear();
+    eventCond_.notify_one();
+}
 
-        msg.get()[count] = '\0';
-        OnEvent(msg.get());
+void NetlinkListener::DispatchEvents()
+{
+    std::unique_lock<std::mutex> lock(eventMutex_);
+    while (1) {
+        eventCond_.wait(lock, [this] { return !events_.empty() || !dispatching_; });
+        if (events_.empty()) {
+            return;
+        }
+        UeventMsg event = std::move(events_.front());
+        events_.pop_front();
+        if (event.overrun) {
+            // one re-scan covers every overrun queued behind it
+            while (!events_.empty() && events_.front().overrun) {
+                events_.pop_front();
+            }
+        }
+        lock.unlock();
+        if (event.overrun) {
+            OnOverrun();
+        } else {
+            OnEvent(event.data.data());
+        }
+        lock.lock();
     }
 }
 
@@ -178,6 +280,11 @@ int32_t NetlinkListener::StartListener()
         LOGE("Pipe error");
         return E_ERR;
     }
+    {
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        dispatching_ = true;
+    }
+    dispatchThread_ = std::make_unique<std::thread>([this]() { this->DispatchEvents(); });
     socketThread_ = std::make_unique<std::thread>([this]() { this->EventProcess(static_cast<void *>(this)); });
     if (socketThread_ == nullptr) {
         (void)close(socketPipe_[0]);
@@ -198,6 +305,15 @@ int32_t NetlinkListener::StopListener()
     if (socketThread_ != nullptr && socketThread_->joinable()) {
         socketThread_->join();
     }
+    {
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        dispatching_ = false;
+    }
+    eventCond_.notify_one();
+    // the events already received are still handed to the handlers
+    if (dispatchThread_ != nullptr && dispatchThread_->joinable()) {
+        dispatchThread_->join();
+    }
 
     (void)close(socketPipe_[0]);
     (void)close(socketPipe_[1]);
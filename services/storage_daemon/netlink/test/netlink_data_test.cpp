@@ -24,6 +24,9 @@ namespace {
     const char* DEVPATH_TEST = "DEVPATH=/dev/test\0ACTION=add\0";
     const char* SUBSYSTEM_TEST = "SUBSYSTEM=ABCABC\0ACTION=add\0";
     const char* PARAM_TEST = "ParamName=test\0ACTION=add\0";
+    const char* BLOCK_TEST = "add@/devices/virtual/block/sdb/sdb1\0ACTION=add\0DEVPATH=/devices/virtual/block/sdb/sdb1\0"
+        "SUBSYSTEM=block\0MAJOR=8\0MINOR=17\0DEVNAME=sdb1\0DEVTYPE=partition\0PARTN=1\0SEQNUM=2048\0";
+    const char* BAD_NUMBER_TEST = "ACTION=change\0SUBSYSTEM=block\0MAJOR=8a\0MINOR=\0PARTN=-1\0";
 }
 using namespace testing::ext;
 
@@ -153,5 +156,37 @@ HWTEST_F(NetlinkDataTest, NetlinkDataTest_GetParam_002, TestSize.Level1)
 
     GTEST_LOG_(INFO) << "NetlinkDataTest_GetParam_002 end";
 }
+/**
+ * @tc.name: NetlinkDataTest_Decode_005
+ * @tc.desc: Verify that the well-known keys are indexed and the numbers are parsed on decode.
+ * @tc.type: FUNC
+ */
+HWTEST_F(NetlinkDataTest, NetlinkDataTest_Decode_005, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "NetlinkDataTest_Decode_005 start";
+
+    NetlinkData netlinkData;
+    netlinkData.Decode(BLOCK_TEST);
+    EXPECT_EQ(netlinkData.GetAction(), NetlinkData::Actions::ADD);
+    EXPECT_EQ(netlinkData.GetSubsystemView(), "block");
+    EXPECT_EQ(netlinkData.GetSyspath(), "/sys/devices/virtual/block/sdb/sdb1");
+    EXPECT_EQ(netlinkData.GetMajor(), 8);
+    EXPECT_EQ(netlinkData.GetMinor(), 17);
+    EXPECT_EQ(netlinkData.GetPartn(), 1);
+    EXPECT_EQ(netlinkData.GetParam("MAJOR"), "8");
+    EXPECT_EQ(netlinkData.GetParamView("DEVTYPE"), "partition");
+    EXPECT_EQ(netlinkData.GetParamView("DEVNAME"), "sdb1");
+    EXPECT_EQ(netlinkData.GetParamView("SEQNUM"), "2048");
+
+    netlinkData.Decode(BAD_NUMBER_TEST);
+    EXPECT_EQ(netlinkData.GetAction(), NetlinkData::Actions::CHANGE);
+    EXPECT_EQ(netlinkData.GetDevpath(), "");
+    EXPECT_EQ(netlinkData.GetMajor(), -1);
+    EXPECT_EQ(netlinkData.GetMinor(), -1);
+    EXPECT_EQ(netlinkData.GetPartn(), -1);
+    EXPECT_EQ(netlinkData.GetParamView("DEVNAME"), "");
+
+    GTEST_LOG_(INFO) << "NetlinkDataTest_Decode_005 end";
+}
 } // STORAGE_DAEMON
 } // OHOS
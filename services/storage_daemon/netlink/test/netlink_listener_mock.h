@@ -26,6 +26,7 @@ public:
     virtual ~NetlinkListenerMock() {}
 
     MOCK_METHOD1(OnEvent, void(char *));
+    MOCK_METHOD0(OnOverrun, void());
 };
 } // namespace StorageDaemon
 } // namespace OHOS
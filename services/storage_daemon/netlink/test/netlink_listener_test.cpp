@@ -14,9 +14,12 @@
  */
 
 #include <fcntl.h>
+#include <deque>
 #include <memory>
+#include <string>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <vector>
 #include <linux/netlink.h>
 
 #include "gtest/gtest.h"
@@ -86,6 +89,37 @@ HWTEST_F(NetlinkListenerTest, NetlinkListenerTest_StartListener_StopListener_001
     GTEST_LOG_(INFO) << "NetlinkListenerTest_StartListener_StopListener_001 end";
 }
 
+/**
+ * @tc.name: NetlinkListenerTest_DispatchEvents_001
+ * @tc.desc: Verify that queued events are dispatched in order and adjacent overruns trigger one re-scan.
+ * @tc.type: FUNC
+ * @tc.require: SR000GGUOT
+ */
+HWTEST_F(NetlinkListenerTest, NetlinkListenerTest_DispatchEvents_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "NetlinkListenerTest_DispatchEvents_001 start";
+    NetlinkListenerMock mock(-1);
+    std::vector<std::string> handled;
+    EXPECT_CALL(mock, OnEvent(testing::_)).Times(3).WillRepeatedly([&handled](char *msg) {
+        handled.push_back(msg);
+    });
+    EXPECT_CALL(mock, OnOverrun()).Times(1);
+
+    std::deque<NetlinkListener::UeventMsg> batch = {
+        { "ACTION=add", false }, { "", true }, { "", true }, { "ACTION=change", false }, { "ACTION=remove", false }
+    };
+    mock.PushEvents(batch);
+    EXPECT_TRUE(batch.empty());
+    EXPECT_EQ(mock.events_.size(), 5);
+    // not dispatching any more, the queue is drained before returning
+    mock.DispatchEvents();
+    EXPECT_TRUE(mock.events_.empty());
+    ASSERT_EQ(handled.size(), 3);
+    EXPECT_EQ(handled[0], "ACTION=add");
+    EXPECT_EQ(handled[2], "ACTION=remove");
+    GTEST_LOG_(INFO) << "NetlinkListenerTest_DispatchEvents_001 end";
+}
+
 int32_t StartSocket(int32_t& socketFd)
 {
     struct sockaddr_nl addr;
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "quota/bundle_scan_index.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+
+#include "storage_service_log.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+namespace {
+constexpr uint32_t SCAN_INDEX_MAGIC = 0x53494458;
+constexpr uint32_t SCAN_INDEX_VERSION = 1;
+constexpr uint32_t SCAN_INDEX_PATH_MAX_LEN = 4096;
+constexpr uint32_t SCAN_INDEX_NAME_MAX_LEN = 255;
+// a directory changed in the same timestamp tick as the scan may change again without moving its ctime
+constexpr int64_t SCAN_INDEX_RACY_INTERVAL_SEC = 2;
+const std::string SCAN_INDEX_TMP_SUFFIX = ".tmp";
+
+template<typename T>
+bool ReadValue(std::ifstream &in, T &value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+template<typename T>
+void WriteValue(std::ofstream &out, const T &value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+bool ReadString(std::ifstream &in, std::string &str, uint32_t maxLen)
+{
+    uint32_t len = 0;
+    if (!ReadValue(in, len) || len > maxLen) {
+        return false;
+    }
+    str.resize(len);
+    return static_cast<bool>(in.read(&str[0], len));
+}
+
+void WriteString(std::ofstream &out, const std::string &str)
+{
+    uint32_t len = static_cast<uint32_t>(str.size());
+    WriteValue(out, len);
+    out.write(str.data(), len);
+}
+
+bool SyncPath(const std::string &path, int flags)
+{
+    int fd = open(path.c_str(), flags | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("open %{public}s for sync failed, errno:%{public}d", path.c_str(), errno);
+        return false;
+    }
+    int ret = fsync(fd);
+    if (ret != 0) {
+        LOGE("fsync %{public}s failed, errno:%{public}d", path.c_str(), errno);
+    }
+    (void)close(fd);
+    return ret == 0;
+}
+
+bool ReadDir(std::ifstream &in, std::string &path, ScanIndexDir &dir)
+{
+    uint32_t entryNum = 0;
+    if (!ReadString(in, path, SCAN_INDEX_PATH_MAX_LEN) || !ReadValue(in, dir.ino) ||
+        !ReadValue(in, dir.mtimeSec) || !ReadValue(in, dir.mtimeNsec) || !ReadValue(in, dir.ctimeSec) ||
+        !ReadValue(in, dir.ctimeNsec) || !ReadValue(in, entryNum)) {
+        return false;
+    }
+    dir.entries.clear();
+    for (uint32_t i = 0; i < entryNum; i++) {
+        ScanIndexEntry entry;
+        if (!ReadValue(in, entry.type) || !ReadString(in, entry.name, SCAN_INDEX_NAME_MAX_LEN)) {
+            return false;
+        }
+        dir.entries.emplace_back(std::move(entry));
+    }
+    return true;
+}
+} // namespace
+
+BundleScanIndex::BundleScanIndex(const std::string &indexPath)
+    : indexPath_(indexPath), scanStartTime_(static_cast<int64_t>(time(nullptr)))
+{
+}
+
+bool BundleScanIndex::Load()
+{
+    oldDirs_.clear();
+    loaded_ = false;
+    std::ifstream in(indexPath_, std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        LOGI("no scan index for bundle, cold scan");
+        return false;
+    }
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t dirNum = 0;
+    if (!ReadValue(in, magic) || !ReadValue(in, version) || !ReadValue(in, dirNum) ||
+        magic != SCAN_INDEX_MAGIC || version != SCAN_INDEX_VERSION) {
+        LOGE("invalid scan index header, ignore it");
+        return false;
+    }
+    for (uint32_t i = 0; i < dirNum; i++) {
+        std::string path;
+        ScanIndexDir dir;
+        if (!ReadDir(in, path, dir)) {
+            LOGE("scan index is truncated, ignore it");
+            oldDirs_.clear();
+            return false;
+        }
+        oldDirs_.emplace(std::move(path), std::move(dir));
+    }
+    loaded_ = true;
+    return true;
+}
+
+bool BundleScanIndex::IsChanged() const
+{
+    // every loaded listing was hit and none was read from disk, so the index on disk is still exact
+    return !loaded_ || missCount_ != 0 || !oldDirs_.empty();
+}
+
+bool BundleScanIndex::Save()
+{
+    if (!IsChanged()) {
+        LOGI("scan index unchanged, dirs:%{public}zu, skip saving", newDirs_.size());
+        return true;
+    }
+    std::string tmpPath = indexPath_ + SCAN_INDEX_TMP_SUFFIX;
+    std::ofstream out(tmpPath, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!out.is_open()) {
+        LOGE("create scan index failed, errno:%{public}d", errno);
+        return false;
+    }
+    WriteValue(out, SCAN_INDEX_MAGIC);
+    WriteValue(out, SCAN_INDEX_VERSION);
+    WriteValue(out, static_cast<uint32_t>(newDirs_.size()));
+    for (const auto &[path, dir] : newDirs_) {
+        WriteString(out, path);
+        WriteValue(out, dir.ino);
+        WriteValue(out, dir.mtimeSec);
+        WriteValue(out, dir.mtimeNsec);
+        WriteValue(out, dir.ctimeSec);
+        WriteValue(out, dir.ctimeNsec);
+        WriteValue(out, static_cast<uint32_t>(dir.entries.size()));
+        for (const auto &entry : dir.entries) {
+            WriteValue(out, entry.type);
+            WriteString(out, entry.name);
+        }
+    }
+    out.close();
+    // the data must be durable before the rename publishes it, or a crash may leave an empty index behind
+    if (!out || !SyncPath(tmpPath, O_WRONLY)) {
+        LOGE("write scan index failed");
+        (void)remove(tmpPath.c_str());
+        return false;
+    }
+    if (rename(tmpPath.c_str(), indexPath_.c_str()) != 0) {
+        LOGE("rename scan index failed, errno:%{public}d", errno);
+        (void)remove(tmpPath.c_str());
+        return false;
+    }
+    auto pos = indexPath_.rfind('/');
+    if (pos != std::string::npos) {
+        (void)SyncPath(indexPath_.substr(0, pos + 1), O_RDONLY | O_DIRECTORY);
+    }
+    LOGI("scan index saved, dirs:%{public}zu, hit:%{public}u, miss:%{public}u", newDirs_.size(), hitCount_,
+        missCount_);
+    return true;
+}
+
+bool BundleScanIndex::IsSameDir(const ScanIndexDir &dir, const struct stat &dirStat)
+{
+    return dir.ino == static_cast<uint64_t>(dirStat.st_ino) &&
+        dir.mtimeSec == static_cast<int64_t>(dirStat.st_mtim.tv_sec) &&
+        dir.mtimeNsec == static_cast<int64_t>(dirStat.st_mtim.tv_nsec) &&
+        dir.ctimeSec == static_cast<int64_t>(dirStat.st_ctim.tv_sec) &&
+        dir.ctimeNsec == static_cast<int64_t>(dirStat.st_ctim.tv_nsec);
+}
+
+const std::vector<ScanIndexEntry> *BundleScanIndex::FindEntries(const std::string &dirPath,
+    const struct stat &dirStat)
+{
+    auto it = oldDirs_.find(dirPath);
+    if (it == oldDirs_.end() || !IsSameDir(it->second, dirStat)) {
+        missCount_++;
+        return nullptr;
+    }
+    hitCount_++;
+    auto ret = newDirs_.insert_or_assign(dirPath, std::move(it->second));
+    oldDirs_.erase(it);
+    return &ret.first->second.entries;
+}
+
+void BundleScanIndex::UpdateEntries(const std::string &dirPath, const struct stat &dirStat,
+    const std::vector<ScanIndexEntry> &entries)
+{
+    if (static_cast<int64_t>(dirStat.st_ctim.tv_sec) + SCAN_INDEX_RACY_INTERVAL_SEC >= scanStartTime_ ||
+        static_cast<int64_t>(dirStat.st_mtim.tv_sec) + SCAN_INDEX_RACY_INTERVAL_SEC >= scanStartTime_) {
+        return;
+    }
+    ScanIndexDir dir = {
+        .ino = static_cast<uint64_t>(dirStat.st_ino),
+        .mtimeSec = static_cast<int64_t>(dirStat.st_mtim.tv_sec),
+        .mtimeNsec = static_cast<int64_t>(dirStat.st_mtim.tv_nsec),
+        .ctimeSec = static_cast<int64_t>(dirStat.st_ctim.tv_sec),
+        .ctimeNsec = static_cast<int64_t>(dirStat.st_ctim.tv_nsec),
+        .entries = entries,
+    };
+    newDirs_.insert_or_assign(dirPath, std::move(dir));
+}
+} // STORAGE_DAEMON
+} // OHOS
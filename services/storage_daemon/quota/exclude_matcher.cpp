@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "quota/exclude_matcher.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+namespace {
+constexpr char PATH_SEPARATOR = '/';
+}
+
+ExcludeMatcher::Node *ExcludeMatcher::Insert(std::string_view path)
+{
+    Node *node = root_.get();
+    size_t start = 0;
+    while (true) {
+        size_t pos = path.find(PATH_SEPARATOR, start);
+        std::string_view component = path.substr(start, pos == std::string_view::npos ? pos : pos - start);
+        auto it = node->children.find(component);
+        if (it == node->children.end()) {
+            it = node->children.emplace(std::string(component), std::make_unique<Node>()).first;
+        }
+        node = it->second.get();
+        if (pos == std::string_view::npos) {
+            return node;
+        }
+        start = pos + 1;
+    }
+}
+
+void ExcludeMatcher::AddFile(const std::string &path)
+{
+    if (path.empty()) {
+        return;
+    }
+    Insert(path)->isFile = true;
+}
+
+void ExcludeMatcher::AddDir(const std::string &path)
+{
+    if (path.empty()) {
+        return;
+    }
+    std::string_view dirPath = path;
+    if (dirPath.back() == PATH_SEPARATOR) {
+        dirPath.remove_suffix(1);
+    }
+    Insert(dirPath)->isDir = true;
+}
+
+bool ExcludeMatcher::IsExcluded(std::string_view path) const
+{
+    const Node *node = root_.get();
+    size_t start = 0;
+    while (true) {
+        size_t pos = path.find(PATH_SEPARATOR, start);
+        std::string_view component = path.substr(start, pos == std::string_view::npos ? pos : pos - start);
+        auto it = node->children.find(component);
+        if (it == node->children.end()) {
+            return false;
+        }
+        node = it->second.get();
+        if (pos == std::string_view::npos) {
+            return node->isFile;
+        }
+        if (node->isDir) {
+            return true;
+        }
+        start = pos + 1;
+    }
+}
+} // STORAGE_DAEMON
+} // OHOS
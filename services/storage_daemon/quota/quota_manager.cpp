@@ -15,16 +15,22 @@
 
 #include "quota/quota_manager.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <dirent.h>
 #include <fcntl.h>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <linux/dqblk_xfs.h>
 #include <linux/fs.h>
 #include <linux/quota.h>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <poll.h>
 #include <sstream>
 #include <stack>
 #include <sys/ioctl.h>
@@ -32,12 +38,16 @@
 #include <sys/stat.h>
 #include <sys/statvfs.h>
 #include <sys/types.h>
+#include <thread>
 #include <tuple>
 #include <unique_fd.h>
 #include <unistd.h>
 #include <cstdio>
 
 #include "file_uri.h"
+#include "quota/bundle_scan_index.h"
+#include "quota/exclude_matcher.h"
+#include "quota/stat_file_writer.h"
 #include "sandbox_helper.h"
 #include "storage_service_errno.h"
 #include "storage_service_log.h"
@@ -54,8 +64,13 @@ const int32_t DEV_BLOCK_PATH_LEN = DEV_BLOCK_PATH.length();
 const uint64_t ONE_KB = 1;
 const uint64_t ONE_MB = 1024 * ONE_KB;
 const uint64_t PATH_MAX_LEN = 4096;
+const uint32_t MAX_SCAN_THREAD_NUM = 4;
+const uint32_t MAX_QUOTA_BATCH_NUM = 10000;
+const std::string BACKUP_SCAN_INDEX_SYMBOL = "scan_index";
 static std::map<std::string, std::string> mQuotaReverseMounts;
 std::recursive_mutex mMountsLock;
+static UniqueFd mMountsWatchFd;
+static bool mQuotaMountsValid = false;
 
 QuotaManager* QuotaManager::instance_ = nullptr;
 QuotaManager* QuotaManager::GetInstance()
@@ -106,15 +121,70 @@ static std::string GetQuotaSrcMountPath(const std::string &target)
     }
 }
 
+/**
+ * @brief Check whether the mount table changed since the last check
+ *
+ * The kernel reports POLLPRI | POLLERR on an open /proc/mounts fd each time the mount namespace changes.
+ *
+ * @return bool : true if mounts changed or cannot be watched, cached quota mounts must be reloaded
+ */
+static bool IsQuotaMountsChanged()
+{
+    if (mMountsWatchFd < 0) {
+        mMountsWatchFd = UniqueFd(open(PROC_MOUNTS_PATH.c_str(), O_RDONLY | O_CLOEXEC));
+        if (mMountsWatchFd < 0) {
+            LOGE("Failed to watch mounts file, errno : %{public}d", errno);
+        }
+        return true;
+    }
+    struct pollfd pfd = { .fd = mMountsWatchFd.Get(), .events = POLLPRI, .revents = 0 };
+    if (poll(&pfd, 1, 0) < 0) {
+        return true;
+    }
+    return (pfd.revents & (POLLPRI | POLLERR)) != 0;
+}
+
+/**
+ * @brief Get the quota block device of /data, resolved once and reloaded only when mounts change
+ *
+ * @param device          quota block device, empty if /data has no quota enabled
+ *
+ * @return bool : false if quota mounts cannot be resolved
+ */
+static bool GetQuotaDataDevice(std::string &device)
+{
+    std::lock_guard<std::recursive_mutex> lock(mMountsLock);
+    if (IsQuotaMountsChanged() || !mQuotaMountsValid) {
+        mQuotaMountsValid = InitialiseQuotaMounts();
+        if (!mQuotaMountsValid) {
+            return false;
+        }
+    }
+    device = GetQuotaSrcMountPath(QUOTA_DEVICE_DATA_PATH);
+    return true;
+}
+
+static int32_t GetQuotaType(int32_t idType)
+{
+    switch (idType) {
+        case USRID:
+            return USRQUOTA;
+        case GRPID:
+            return GRPQUOTA;
+        case PRJID:
+            return PRJQUOTA;
+        default:
+            return -1;
+    }
+}
+
 static int64_t GetOccupiedSpaceForUid(int32_t uid, int64_t &size)
 {
-    if (InitialiseQuotaMounts() != true) {
+    std::string device = "";
+    if (!GetQuotaDataDevice(device)) {
         LOGE("Failed to initialise quota mounts");
         return E_SYS_ERR;
     }
-
-    std::string device = "";
-    device = GetQuotaSrcMountPath(QUOTA_DEVICE_DATA_PATH);
     if (device.empty()) {
         LOGE("skip when device no quotas present");
         return E_OK;
@@ -132,13 +202,11 @@ static int64_t GetOccupiedSpaceForUid(int32_t uid, int64_t &size)
 
 static int64_t GetOccupiedSpaceForGid(int32_t gid, int64_t &size)
 {
-    if (InitialiseQuotaMounts() != true) {
+    std::string device = "";
+    if (!GetQuotaDataDevice(device)) {
         LOGE("Failed to initialise quota mounts");
         return E_SYS_ERR;
     }
-
-    std::string device = "";
-    device = GetQuotaSrcMountPath(QUOTA_DEVICE_DATA_PATH);
     if (device.empty()) {
         LOGE("skip when device no quotas present");
         return E_OK;
@@ -157,13 +225,11 @@ static int64_t GetOccupiedSpaceForGid(int32_t gid, int64_t &size)
 
 static int64_t GetOccupiedSpaceForPrjId(int32_t prjId, int64_t &size)
 {
-    if (InitialiseQuotaMounts() != true) {
+    std::string device = "";
+    if (!GetQuotaDataDevice(device)) {
         LOGE("Failed to initialise quota mounts");
         return E_SYS_ERR;
     }
-
-    std::string device = "";
-    device = GetQuotaSrcMountPath(QUOTA_DEVICE_DATA_PATH);
     if (device.empty()) {
         LOGE("skip when device no quotas present");
         return E_OK;
@@ -197,6 +263,79 @@ int32_t QuotaManager::GetOccupiedSpace(int32_t idType, int32_t id, int64_t &size
     return E_OK;
 }
 
+/**
+ * @brief Dump the usage of every id that has a quota record with Q_GETNEXTQUOTA
+ *
+ * @param device          quota block device
+ * @param quotaType       USRQUOTA, GRPQUOTA or PRJQUOTA
+ * @param ids             ids found on the device
+ * @param sizes           occupied bytes of each id
+ *
+ * @return int32_t : E_OK if dumped, E_SYS_ERR if Q_GETNEXTQUOTA failed
+ */
+static int32_t GetAllOccupiedSpace(const std::string &device, int32_t quotaType, std::vector<int32_t> &ids,
+    std::vector<int64_t> &sizes)
+{
+    uint32_t nextId = 0;
+    while (ids.size() < MAX_QUOTA_BATCH_NUM) {
+        struct if_nextdqblk nextDq = {};
+        if (quotactl(QCMD(Q_GETNEXTQUOTA, quotaType), device.c_str(), static_cast<int32_t>(nextId),
+            reinterpret_cast<char*>(&nextDq)) != 0) {
+            if (errno == ENOENT) {
+                break;
+            }
+            LOGE("Failed to get next quota, errno : %{public}d", errno);
+            return E_SYS_ERR;
+        }
+        ids.emplace_back(static_cast<int32_t>(nextDq.dqb_id));
+        sizes.emplace_back(static_cast<int64_t>(nextDq.dqb_curspace));
+        if (nextDq.dqb_id == UINT32_MAX) {
+            break;
+        }
+        nextId = nextDq.dqb_id + 1;
+    }
+    return E_OK;
+}
+
+int32_t QuotaManager::GetOccupiedSpaceBatch(int32_t idType, std::vector<int32_t> &ids, std::vector<int64_t> &sizes)
+{
+    int32_t quotaType = GetQuotaType(idType);
+    if (quotaType < 0) {
+        return E_NON_EXIST;
+    }
+    if (ids.size() > MAX_QUOTA_BATCH_NUM) {
+        LOGE("Too many ids in one batch, count : %{public}zu", ids.size());
+        return E_PARAMS_INVAL;
+    }
+    std::string device = "";
+    if (!GetQuotaDataDevice(device)) {
+        LOGE("Failed to initialise quota mounts");
+        return E_SYS_ERR;
+    }
+    sizes.clear();
+    if (ids.empty()) {
+        if (device.empty()) {
+            LOGE("skip when device no quotas present");
+            return E_OK;
+        }
+        return GetAllOccupiedSpace(device, quotaType, ids, sizes);
+    }
+    sizes.resize(ids.size(), 0);
+    if (device.empty()) {
+        LOGE("skip when device no quotas present");
+        return E_OK;
+    }
+    for (size_t i = 0; i < ids.size(); i++) {
+        struct dqblk dq;
+        if (quotactl(QCMD(Q_GETQUOTA, quotaType), device.c_str(), ids[i], reinterpret_cast<char*>(&dq)) != 0) {
+            LOGE("Failed to get quotactl for id %{public}d, errno : %{public}d", ids[i], errno);
+            return E_SYS_ERR;
+        }
+        sizes[i] = static_cast<int64_t>(dq.dqb_curspace);
+    }
+    return E_OK;
+}
+
 int32_t QuotaManager::SetBundleQuota(const std::string &bundleName, int32_t uid,
     const std::string &bundleDataDirPath, int32_t limitSizeMb)
 {
@@ -207,14 +346,15 @@ int32_t QuotaManager::SetBundleQuota(const std::string &bundleName, int32_t uid,
 
     LOGE("SetBundleQuota Start, bundleName is %{public}s, uid is %{public}d, bundleDataDirPath is %{public}s, "
          "limit is %{public}d.", bundleName.c_str(), uid, bundleDataDirPath.c_str(), limitSizeMb);
-    if (InitialiseQuotaMounts() != true) {
+    std::string dataDevice = "";
+    if (!GetQuotaDataDevice(dataDevice)) {
         LOGE("Failed to initialise quota mounts");
         return E_NON_EXIST;
     }
 
     std::string device = "";
     if (bundleDataDirPath.find(QUOTA_DEVICE_DATA_PATH) == 0) {
-        device = GetQuotaSrcMountPath(QUOTA_DEVICE_DATA_PATH);
+        device = dataDevice;
     }
     if (device.empty()) {
         LOGE("skip when device no quotas present");
@@ -472,67 +612,35 @@ static void ConvertSandboxRealPath(const uint32_t userId, const std::string &bun
     }
 }
 
-static void WriteFileList(std::ofstream &statFile, struct FileStat fileStat, BundleStatsParas &paras)
+static void WriteFileList(StatFileWriter &statFile, const struct FileStat &fileStat, BundleStatsParas &paras)
 {
-    if (!statFile.is_open() || fileStat.filePath.empty()) {
+    if (!statFile.IsOpen() || fileStat.filePath.empty()) {
         LOGE("WriteFileList Param failed");
         return;
     }
-    std::string fileLine = "";
-    bool encodeFlag = false;
+    StatFileLine line = {.path = fileStat.filePath, .mode = fileStat.mode, .isDir = fileStat.isDir,
+                         .size = fileStat.fileSize, .mtime = fileStat.lastUpdateTime, .isIncre = fileStat.isIncre,
+                         .encodeFlag = false};
+    std::string encodedPath;
     if (fileStat.filePath.find(LINE_SEP) != std::string::npos) {
-        fileLine += AppFileService::SandboxHelper::Encode(fileStat.filePath) + FILE_CONTENT_SEPARATOR;
-        encodeFlag = true;
-    } else {
-        fileLine += fileStat.filePath + FILE_CONTENT_SEPARATOR;
-    }
-    fileLine += std::to_string(fileStat.mode) + FILE_CONTENT_SEPARATOR;
-    if (fileStat.isDir) {
-        fileLine += std::to_string(1) + FILE_CONTENT_SEPARATOR;
-    } else {
-        fileLine += std::to_string(0) + FILE_CONTENT_SEPARATOR;
+        encodedPath = AppFileService::SandboxHelper::Encode(fileStat.filePath);
+        line.path = encodedPath;
+        line.encodeFlag = true;
     }
-    fileLine += std::to_string(fileStat.fileSize) + FILE_CONTENT_SEPARATOR;
-    fileLine += std::to_string(fileStat.lastUpdateTime) + FILE_CONTENT_SEPARATOR;
-    fileLine += FILE_CONTENT_SEPARATOR;
-    if (fileStat.isIncre) {
-        fileLine += std::to_string(1);
-    } else {
-        fileLine += std::to_string(0);
-    }
-    fileLine += FILE_CONTENT_SEPARATOR;
-    if (encodeFlag) {
-        fileLine += std::to_string(1);
-    } else {
-        fileLine += std::to_string(0);
-    }
-    // te file line
-    statFile << fileLine << std::endl;
+    statFile.WriteFileLine(line);
     if (fileStat.isIncre) {
         paras.incFileSizeSum += fileStat.fileSize;
     }
     paras.fileSizeSum += fileStat.fileSize;
 }
 
-static bool ExcludeFilter(std::map<std::string, bool> &excludesMap, const std::string &path)
+static bool ExcludeFilter(const ExcludeMatcher &excludeMatcher, const std::string &path)
 {
     if (path.empty()) {
         LOGE("ExcludeFilter Param failed");
         return true;
     }
-    std::string formatPath = path;
-    for (auto exclude = excludesMap.begin(); exclude != excludesMap.end(); exclude++) {
-        if (exclude->second != true) {
-            if (formatPath.compare(exclude->first) == 0) {
-                return true;
-            }
-        } else {
-            if (formatPath.compare(0, exclude->first.size(), exclude->first) == 0) {
-                return true;
-            }
-        }
-    }
-    return false;
+    return excludeMatcher.IsExcluded(path);
 }
 
 /**
@@ -542,14 +650,14 @@ static bool ExcludeFilter(std::map<std::string, bool> &excludesMap, const std::s
  * @param paras           start time for last backup and file size sum
  * @param pathMap         map for file sandbox path and physical path
  * @param statFile        target file stream pointer
- * @param excludeMap      map for exclude physical path and isDir
+ * @param excludeMatcher  compiled exclude physical paths
  *
  * @return std::tuple<bool, bool> : is success or not for system call / is directory or not
  */
 static std::tuple<bool, bool> CheckIfDirForIncludes(const std::string &path, BundleStatsParas &paras,
-    std::map<std::string, std::string> &pathMap, std::ofstream &statFile, std::map<std::string, bool> &excludesMap)
+    std::map<std::string, std::string> &pathMap, StatFileWriter &statFile, const ExcludeMatcher &excludeMatcher)
 {
-    if (!statFile.is_open() || path.empty()) {
+    if (!statFile.IsOpen() || path.empty()) {
         LOGE("CheckIfDirForIncludes Param failed");
         return {false, false};
     }
@@ -580,7 +688,7 @@ static std::tuple<bool, bool> CheckIfDirForIncludes(const std::string &path, Bun
         if (paras.lastBackupTime == 0 || lastUpdateTime > paras.lastBackupTime) {
             fileStat.isIncre = true;
         }
-        if (ExcludeFilter(excludesMap, path) == false) {
+        if (ExcludeFilter(excludeMatcher, path) == false) {
             WriteFileList(statFile, fileStat, paras);
         }
         return {true, false};
@@ -596,9 +704,9 @@ static std::string PhysicalToSandboxPath(const std::string &dir, const std::stri
 }
 
 static bool AddOuterDirIntoFileStat(const std::string &dir, BundleStatsParas &paras, const std::string &sandboxDir,
-    std::ofstream &statFile, std::map<std::string, bool> &excludesMap)
+    StatFileWriter &statFile, const ExcludeMatcher &excludeMatcher)
 {
-    if (!statFile.is_open() || dir.empty()) {
+    if (!statFile.IsOpen() || dir.empty()) {
         LOGE("AddOuterDirIntoFileStat Param failed");
         return false;
     }
@@ -620,7 +728,7 @@ static bool AddOuterDirIntoFileStat(const std::string &dir, BundleStatsParas &pa
     if (formatPath.back() != FILE_SEPARATOR_CHAR) {
         formatPath.push_back(FILE_SEPARATOR_CHAR);
     }
-    if (ExcludeFilter(excludesMap, formatPath) == false) {
+    if (ExcludeFilter(excludeMatcher, formatPath) == false) {
         WriteFileList(statFile, fileStat, paras);
     }
     return true;
@@ -637,25 +745,79 @@ uint32_t CheckOverLongPath(const std::string &path)
     return len;
 }
 
-static void InsertStatFile(const std::string &path, struct FileStat fileStat,
-    std::ofstream &statFile, std::map<std::string, bool> &excludesMap, BundleStatsParas &paras)
+struct ScanDirNode {
+    std::shared_ptr<DIR> parent;
+    std::string name;
+    std::string path;
+};
+
+/**
+ * @brief Open the directory of a scan node relative to its parent directory fd
+ *
+ * @param node            directory to open, root node has no parent and is opened by path
+ *
+ * @return std::shared_ptr<DIR> : opened directory stream, nullptr if failed
+ */
+static std::shared_ptr<DIR> OpenScanDir(const ScanDirNode &node)
 {
-    if (!statFile.is_open() || path.empty()) {
-        LOGE("InsertStatFile Param failed");
-        return;
+    DIR *dirPtr = nullptr;
+    if (node.parent == nullptr) {
+        dirPtr = opendir(node.path.c_str());
+    } else {
+        int fd = openat(dirfd(node.parent.get()), node.name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0) {
+            dirPtr = fdopendir(fd);
+            if (dirPtr == nullptr) {
+                int err = errno;
+                (void)close(fd);
+                errno = err;
+            }
+        }
     }
-    std::string formatPath = path;
-    if (fileStat.isDir == true && formatPath.back() != FILE_SEPARATOR_CHAR) {
-        formatPath.push_back(FILE_SEPARATOR_CHAR);
+    if (dirPtr == nullptr) {
+        return nullptr;
     }
-    if (!ExcludeFilter(excludesMap, formatPath)) {
-        WriteFileList(statFile, fileStat, paras);
+    return std::shared_ptr<DIR>(dirPtr, closedir);
+}
+
+/**
+ * @brief List entries of a directory, reuse the listing in scan index if the directory is not changed
+ *
+ * @param dirPtr          opened directory stream
+ * @param dirPath         physical path of the directory
+ * @param scanIndex       persistent directory listing index of the bundle
+ * @param entries         buffer for entries read from the directory
+ *
+ * @return const std::vector<ScanIndexEntry>& : cached listing or entries read from the directory
+ */
+static const std::vector<ScanIndexEntry> &ListScanDir(DIR *dirPtr, const std::string &dirPath,
+    BundleScanIndex &scanIndex, std::vector<ScanIndexEntry> &entries)
+{
+    struct stat dirStat = {0};
+    bool isStatOk = fstat(dirfd(dirPtr), &dirStat) == 0;
+    if (isStatOk) {
+        const std::vector<ScanIndexEntry> *cachedEntries = scanIndex.FindEntries(dirPath, dirStat);
+        if (cachedEntries != nullptr) {
+            return *cachedEntries;
+        }
+    }
+    entries.clear();
+    struct dirent *entry = nullptr;
+    while ((entry = readdir(dirPtr)) != nullptr) {
+        if ((strcmp(entry->d_name, ".") == 0) || (strcmp(entry->d_name, "..") == 0)) {
+            continue;
+        }
+        entries.push_back({entry->d_name, entry->d_type});
     }
+    if (isStatOk) {
+        scanIndex.UpdateEntries(dirPath, dirStat, entries);
+    }
+    return entries;
 }
 
 static bool GetIncludesFileStats(const std::string &dir, BundleStatsParas &paras,
-    std::map<std::string, std::string> &pathMap,
-    std::ofstream &statFile, std::map<std::string, bool> &excludesMap)
+    std::map<std::string, std::string> &pathMap, StatFileWriter &statFile,
+    const ExcludeMatcher &excludeMatcher, BundleScanIndex &scanIndex)
 {
     std::string sandboxDir = dir;
     auto it = pathMap.find(dir);
@@ -663,16 +825,26 @@ static bool GetIncludesFileStats(const std::string &dir, BundleStatsParas &paras
         sandboxDir = it->second;
     }
     // stat current directory info
-    AddOuterDirIntoFileStat(dir, paras, sandboxDir, statFile, excludesMap);
+    AddOuterDirIntoFileStat(dir, paras, sandboxDir, statFile, excludeMatcher);
+    std::string formatDir = dir;
+    if (formatDir.back() != FILE_SEPARATOR_CHAR) {
+        formatDir.push_back(FILE_SEPARATOR_CHAR);
+    }
+    if (ExcludeFilter(excludeMatcher, formatDir)) {
+        return true;
+    }
 
-    std::stack<std::string> folderStack;
-    std::string filePath;
-    folderStack.push(dir);
+    // sub-directories keep their parent stream open so that they can be opened by name with openat
+    std::stack<ScanDirNode> folderStack;
+    folderStack.push({nullptr, "", dir});
+    std::vector<ScanIndexEntry> dirEntries;
     // stat files and sub-directory in current directory info
     while (!folderStack.empty()) {
-        filePath = folderStack.top();
+        ScanDirNode node = std::move(folderStack.top());
         folderStack.pop();
-        DIR *dirPtr = opendir(filePath.c_str());
+        std::shared_ptr<DIR> dirPtr = OpenScanDir(node);
+        node.parent = nullptr;
+        std::string &filePath = node.path;
         if (dirPtr == nullptr) {
             LOGE("GetIncludesFileStats open file dir:%{private}s fail, errno:%{public}d", filePath.c_str(), errno);
             continue;
@@ -681,14 +853,23 @@ static bool GetIncludesFileStats(const std::string &dir, BundleStatsParas &paras
             filePath.push_back(FILE_SEPARATOR_CHAR);
         }
 
-        struct dirent *entry = nullptr;
-        while ((entry = readdir(dirPtr)) != nullptr) {
-            if ((strcmp(entry->d_name, ".") == 0) || (strcmp(entry->d_name, "..") == 0)) {
+        int dirFd = dirfd(dirPtr.get());
+        for (const auto &entry : ListScanDir(dirPtr.get(), filePath, scanIndex, dirEntries)) {
+            std::string path = filePath + entry.name;
+            bool isDir = entry.type == DT_DIR;
+            // excluded directories are pruned before descending, a directory rule is matched with a trailing '/'
+            if (isDir) {
+                path.push_back(FILE_SEPARATOR_CHAR);
+            }
+            bool isExcluded = excludeMatcher.IsExcluded(path);
+            if (isDir) {
+                path.pop_back();
+            }
+            if (isExcluded) {
                 continue;
             }
-            std::string path = filePath + entry->d_name;
             struct stat fileInfo = {0};
-            if (stat(path.c_str(), &fileInfo) != 0) {
+            if (fstatat(dirFd, entry.name.c_str(), &fileInfo, 0) != 0) {
                 LOGE("GetIncludesFileStats call stat error %{private}s, errno:%{public}d", path.c_str(), errno);
                 fileInfo.st_size = 0;
             }
@@ -701,18 +882,17 @@ static bool GetIncludesFileStats(const std::string &dir, BundleStatsParas &paras
             int64_t lastUpdateTime = static_cast<int64_t>(fileInfo.st_mtime);
             fileStat.lastUpdateTime = lastUpdateTime;
             fileStat.isIncre = (paras.lastBackupTime == 0 || lastUpdateTime > paras.lastBackupTime) ? true : false;
-            if (entry->d_type == DT_DIR) {
+            if (isDir) {
                 fileStat.isDir = true;
-                folderStack.push(path);
+                folderStack.push({dirPtr, entry.name, path});
             }
-            InsertStatFile(path, fileStat, statFile, excludesMap, paras);
+            WriteFileList(statFile, fileStat, paras);
         }
-        closedir(dirPtr);
     }
     return true;
 }
 
-static void SetExcludePathMap(std::string &excludePath, std::map<std::string, bool> &excludesMap)
+static void SetExcludePathMap(std::string &excludePath, ExcludeMatcher &excludeMatcher)
 {
     if (excludePath.empty()) {
         LOGE("SetExcludePathMap Param failed");
@@ -727,29 +907,30 @@ static void SetExcludePathMap(std::string &excludePath, std::map<std::string, bo
         if (excludePath.back() != FILE_SEPARATOR_CHAR) {
             excludePath.push_back(FILE_SEPARATOR_CHAR);
         }
-        excludesMap.insert({excludePath, true});
+        excludeMatcher.AddDir(excludePath);
     } else {
-        excludesMap.insert({excludePath, false});
+        excludeMatcher.AddFile(excludePath);
     }
 }
 
 static void ScanExtensionPath(BundleStatsParas &paras,
     const std::vector<std::string> &includes, const std::vector<std::string> &excludes,
-    std::map<std::string, std::string> &pathMap, std::ofstream &statFile)
+    std::map<std::string, std::string> &pathMap, StatFileWriter &statFile, BundleScanIndex &scanIndex)
 {
-    std::map<std::string, bool> excludesMap;
+    // exclude rules are compiled once per bundle and matched in O(path depth) during the walk
+    ExcludeMatcher excludeMatcher;
     for (auto exclude : excludes) {
-        SetExcludePathMap(exclude, excludesMap);
+        SetExcludePathMap(exclude, excludeMatcher);
     }
     // all file with stats in include directory
     for (const auto &includeDir : includes) {
         // Check if includeDir is a file path
-        auto [isSucc, isDir] = CheckIfDirForIncludes(includeDir, paras, pathMap, statFile, excludesMap);
+        auto [isSucc, isDir] = CheckIfDirForIncludes(includeDir, paras, pathMap, statFile, excludeMatcher);
         if (!isSucc) {
             continue;
         }
         // recognize all file in include directory
-        if (isDir && !GetIncludesFileStats(includeDir, paras, pathMap, statFile, excludesMap)) {
+        if (isDir && !GetIncludesFileStats(includeDir, paras, pathMap, statFile, excludeMatcher, scanIndex)) {
             LOGE("Faied to get include files for includeDir");
         }
     }
@@ -795,17 +976,17 @@ static void DeduplicationPath(std::vector<std::string> &configPaths)
 }
 
 static void GetBundleStatsForIncreaseEach(uint32_t userId, std::string &bundleName, int64_t lastBackupTime,
-    std::vector<int64_t> &pkgFileSizes, std::vector<int64_t> &incPkgFileSizes)
+    int64_t &pkgFileSize, int64_t &incPkgFileSize)
 {
     // input parameters
     BundleStatsParas paras = {.userId = userId, .bundleName = bundleName,
                               .lastBackupTime = lastBackupTime, .fileSizeSum = 0, .incFileSizeSum = 0};
+    pkgFileSize = 0;
+    incPkgFileSize = 0;
 
     // obtain includes, excludes in backup extension config
     auto [includes, excludes] = ReadIncludesExcludesPath(bundleName, lastBackupTime, userId);
     if (includes.empty()) {
-        pkgFileSizes.emplace_back(0);
-        incPkgFileSizes.emplace_back(0);
         return;
     }
     // physical paths
@@ -817,8 +998,6 @@ static void GetBundleStatsForIncreaseEach(uint32_t userId, std::string &bundleNa
     DealWithIncludeFiles(paras, includes, phyIncludes, pathMap);
     if (phyIncludes.empty()) {
         LOGE("Incorrect convert for include sandbox path for %{private}s", bundleName.c_str());
-        pkgFileSizes.emplace_back(0);
-        incPkgFileSizes.emplace_back(0);
         return;
     }
 
@@ -835,24 +1014,63 @@ static void GetBundleStatsForIncreaseEach(uint32_t userId, std::string &bundleNa
 
     std::string filePath = BACKUP_PATH_PREFIX + std::to_string(userId) + BACKUP_PATH_SURFFIX +
         bundleName + FILE_SEPARATOR_CHAR + BACKUP_STAT_SYMBOL + std::to_string(lastBackupTime);
-    std::ofstream statFile;
-    statFile.open(filePath.data(), std::ios::out | std::ios::trunc);
-    if (!statFile.is_open()) {
+    StatFileWriter statFile(filePath);
+    if (!statFile.Open()) {
         LOGE("creat file fail, errno:%{public}d.", errno);
-        pkgFileSizes.emplace_back(0);
-        incPkgFileSizes.emplace_back(0);
         return;
     }
-    statFile << VER_10_LINE1 << std::endl;
-    statFile << VER_10_LINE2 << std::endl;
+    statFile.WriteLine(VER_10_LINE1);
+    statFile.WriteLine(VER_10_LINE2);
+
+    // directory listings unchanged since the last scan are taken from the bundle scan index
+    BundleScanIndex scanIndex(BACKUP_PATH_PREFIX + std::to_string(userId) + BACKUP_PATH_SURFFIX +
+        bundleName + FILE_SEPARATOR_CHAR + BACKUP_SCAN_INDEX_SYMBOL);
+    scanIndex.Load();
 
     DeduplicationPath(phyIncludes);
-    ScanExtensionPath(paras, phyIncludes, phyExcludes, pathMap, statFile);
+    ScanExtensionPath(paras, phyIncludes, phyExcludes, pathMap, statFile, scanIndex);
     // calculate summary file sizes
-    pkgFileSizes.emplace_back(paras.fileSizeSum);
-    incPkgFileSizes.emplace_back(paras.incFileSizeSum);
+    pkgFileSize = paras.fileSizeSum;
+    incPkgFileSize = paras.incFileSizeSum;
     LOGI("bundleName: %{public}s, size: %{public}lld", bundleName.c_str(), static_cast<long long>(paras.fileSizeSum));
-    statFile.close();
+    // nothing was published by this scan, keep the index of the last committed one
+    if (!statFile.Commit()) {
+        LOGE("commit stat file failed for %{public}s", bundleName.c_str());
+        return;
+    }
+    scanIndex.Save();
+}
+
+/**
+ * @brief Run tasks on a bounded set of worker threads, each worker takes the next pending task when idle
+ *
+ * @param taskNum         number of tasks, task index is passed to the task function
+ * @param task            task function, must be safe to run concurrently for different indexes
+ */
+static void RunBundleScanTasks(size_t taskNum, const std::function<void(size_t)> &task)
+{
+    size_t threadNum = std::min({taskNum, static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1U)),
+        static_cast<size_t>(MAX_SCAN_THREAD_NUM)});
+    if (threadNum <= 1) {
+        for (size_t i = 0; i < taskNum; i++) {
+            task(i);
+        }
+        return;
+    }
+    std::atomic<size_t> nextTask(0);
+    auto worker = [&nextTask, taskNum, &task]() {
+        for (size_t i = nextTask.fetch_add(1); i < taskNum; i = nextTask.fetch_add(1)) {
+            task(i);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threadNum; i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : workers) {
+        thread.join();
+    }
 }
 
 int32_t QuotaManager::GetBundleStatsForIncrease(uint32_t userId, const std::vector<std::string> &bundleNames,
@@ -865,11 +1083,29 @@ int32_t QuotaManager::GetBundleStatsForIncrease(uint32_t userId, const std::vect
         return E_SYS_ERR;
     }
 
+    // every bundle writes its own stat file, so bundles are scanned concurrently and sizes are kept in input order,
+    // the entries of a repeated bundle share its temp files and run one after another in a single task
+    std::vector<std::vector<size_t>> bundleTasks;
+    std::map<std::string, size_t> bundleTaskIndex;
     for (size_t i = 0; i < bundleNames.size(); i++) {
-        std::string bundleName = bundleNames[i];
-        int64_t lastBackupTime = incrementalBackTimes[i];
-        GetBundleStatsForIncreaseEach(userId, bundleName, lastBackupTime, pkgFileSizes, incPkgFileSizes);
-    }
+        auto [iter, inserted] = bundleTaskIndex.emplace(bundleNames[i], bundleTasks.size());
+        if (inserted) {
+            bundleTasks.emplace_back();
+        }
+        bundleTasks[iter->second].emplace_back(i);
+    }
+    size_t pkgBase = pkgFileSizes.size();
+    size_t incBase = incPkgFileSizes.size();
+    pkgFileSizes.resize(pkgBase + bundleNames.size(), 0);
+    incPkgFileSizes.resize(incBase + bundleNames.size(), 0);
+    RunBundleScanTasks(bundleTasks.size(), [&](size_t task) {
+        for (size_t i : bundleTasks[task]) {
+            std::string bundleName = bundleNames[i];
+            int64_t lastBackupTime = incrementalBackTimes[i];
+            GetBundleStatsForIncreaseEach(userId, bundleName, lastBackupTime, pkgFileSizes[pkgBase + i],
+                incPkgFileSizes[incBase + i]);
+        }
+    });
     return E_OK;
 }
 } // namespace STORAGE_DAEMON
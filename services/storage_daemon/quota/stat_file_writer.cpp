@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "quota/stat_file_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "storage_service_constant.h"
+#include "storage_service_log.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+namespace {
+constexpr size_t STAT_FILE_BUFFER_SIZE = 256 * 1024;
+constexpr size_t INT64_MAX_CHARS = 20;
+constexpr char STAT_FILE_LINE_END = '\n';
+const std::string STAT_FILE_TMP_SUFFIX = ".tmp";
+} // namespace
+
+StatFileWriter::StatFileWriter(const std::string &path)
+    : path_(path), tmpPath_(path + STAT_FILE_TMP_SUFFIX), buffer_(STAT_FILE_BUFFER_SIZE)
+{
+}
+
+StatFileWriter::~StatFileWriter()
+{
+    Discard();
+}
+
+bool StatFileWriter::Open()
+{
+    // same mode as the ofstream this writer replaced, left to the umask
+    fd_ = open(tmpPath_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    if (fd_ < 0) {
+        LOGE("open stat file failed, errno:%{public}d", errno);
+        return false;
+    }
+    isFailed_ = false;
+    used_ = 0;
+    return true;
+}
+
+void StatFileWriter::Append(std::string_view data)
+{
+    while (!data.empty()) {
+        if (used_ == buffer_.size() && !Flush()) {
+            return;
+        }
+        size_t len = std::min(data.size(), buffer_.size() - used_);
+        (void)memcpy(buffer_.data() + used_, data.data(), len);
+        used_ += len;
+        data.remove_prefix(len);
+    }
+}
+
+void StatFileWriter::AppendInt(int64_t value)
+{
+    if (buffer_.size() - used_ < INT64_MAX_CHARS + 1 && !Flush()) {
+        return;
+    }
+    auto [end, ec] = std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), value);
+    if (ec == std::errc()) {
+        used_ = static_cast<size_t>(end - buffer_.data());
+    }
+}
+
+void StatFileWriter::WriteLine(std::string_view line)
+{
+    Append(line);
+    Append(std::string_view(&STAT_FILE_LINE_END, 1));
+}
+
+void StatFileWriter::WriteFileLine(const StatFileLine &line)
+{
+    // path;mode;dir;size;mtime;hash;isIncremental;encodeFlag
+    Append(line.path);
+    Append(FILE_CONTENT_SEPARATOR);
+    AppendInt(line.mode);
+    Append(FILE_CONTENT_SEPARATOR);
+    Append(line.isDir ? "1" : "0");
+    Append(FILE_CONTENT_SEPARATOR);
+    AppendInt(line.size);
+    Append(FILE_CONTENT_SEPARATOR);
+    AppendInt(line.mtime);
+    Append(FILE_CONTENT_SEPARATOR);
+    Append(FILE_CONTENT_SEPARATOR);
+    Append(line.isIncre ? "1" : "0");
+    Append(FILE_CONTENT_SEPARATOR);
+    Append(line.encodeFlag ? "1" : "0");
+    Append(std::string_view(&STAT_FILE_LINE_END, 1));
+}
+
+bool StatFileWriter::Flush()
+{
+    if (fd_ < 0 || isFailed_) {
+        return false;
+    }
+    size_t written = 0;
+    while (written < used_) {
+        ssize_t ret = write(fd_, buffer_.data() + written, used_ - written);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            LOGE("write stat file failed, errno:%{public}d", errno);
+            isFailed_ = true;
+            return false;
+        }
+        written += static_cast<size_t>(ret);
+    }
+    used_ = 0;
+    return true;
+}
+
+bool StatFileWriter::Commit()
+{
+    if (!Flush()) {
+        Discard();
+        return false;
+    }
+    if (fsync(fd_) != 0) {
+        LOGE("fsync stat file failed, errno:%{public}d", errno);
+        Discard();
+        return false;
+    }
+    (void)close(fd_);
+    fd_ = -1;
+    if (rename(tmpPath_.c_str(), path_.c_str()) != 0) {
+        LOGE("rename stat file failed, errno:%{public}d", errno);
+        (void)unlink(tmpPath_.c_str());
+        return false;
+    }
+    SyncParentDir();
+    return true;
+}
+
+void StatFileWriter::SyncParentDir()
+{
+    // the rename is only durable once the directory entry is on disk
+    auto pos = path_.rfind('/');
+    std::string dirPath = pos == std::string::npos ? "." : path_.substr(0, pos + 1);
+    int dirFd = open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0) {
+        LOGE("open stat file dir failed, errno:%{public}d", errno);
+        return;
+    }
+    if (fsync(dirFd) != 0) {
+        LOGE("fsync stat file dir failed, errno:%{public}d", errno);
+    }
+    (void)close(dirFd);
+}
+
+void StatFileWriter::Discard()
+{
+    if (fd_ < 0) {
+        return;
+    }
+    (void)close(fd_);
+    fd_ = -1;
+    (void)unlink(tmpPath_.c_str());
+}
+} // STORAGE_DAEMON
+} // OHOS
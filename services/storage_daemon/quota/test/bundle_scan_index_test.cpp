@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <ctime>
+#include <dirent.h>
+#include <gtest/gtest.h>
+
+#include "quota/bundle_scan_index.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+using namespace testing::ext;
+
+const std::string SCAN_INDEX_PATH = "/data/local/tmp/bundle_scan_index_test";
+const std::string SCAN_DIR_PATH = "/data/app/el2/100/base/com.ohos.bundleName-0-1/";
+constexpr time_t OLD_DIR_TIME = 1000;
+
+class BundleScanIndexTest : public testing::Test {
+public:
+    static void SetUpTestCase(void) {};
+    static void TearDownTestCase(void) {};
+    void SetUp() {};
+    void TearDown()
+    {
+        (void)remove(SCAN_INDEX_PATH.c_str());
+    };
+};
+
+static struct stat MakeDirStat(time_t dirTime)
+{
+    struct stat dirStat = {0};
+    dirStat.st_ino = 1;
+    dirStat.st_mtim.tv_sec = dirTime;
+    dirStat.st_ctim.tv_sec = dirTime;
+    return dirStat;
+}
+
+/**
+ * @tc.name: Storage_Service_BundleScanIndexTest_FindEntries_001
+ * @tc.desc: Verify that an unchanged directory listing is reused after save and load.
+ * @tc.type: FUNC
+ * @tc.require: AR000HSKSO
+ */
+HWTEST_F(BundleScanIndexTest, Storage_Service_BundleScanIndexTest_FindEntries_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "Storage_Service_BundleScanIndexTest_FindEntries_001 start";
+
+    struct stat dirStat = MakeDirStat(OLD_DIR_TIME);
+    std::vector<ScanIndexEntry> entries = { {"a.txt", DT_REG}, {"sub", DT_DIR} };
+    BundleScanIndex index(SCAN_INDEX_PATH);
+    EXPECT_FALSE(index.Load());
+    EXPECT_EQ(index.FindEntries(SCAN_DIR_PATH, dirStat), nullptr);
+    index.UpdateEntries(SCAN_DIR_PATH, dirStat, entries);
+    EXPECT_TRUE(index.Save());
+
+    BundleScanIndex warmIndex(SCAN_INDEX_PATH);
+    EXPECT_TRUE(warmIndex.Load());
+    const std::vector<ScanIndexEntry> *cachedEntries = warmIndex.FindEntries(SCAN_DIR_PATH, dirStat);
+    ASSERT_NE(cachedEntries, nullptr);
+    ASSERT_EQ(cachedEntries->size(), entries.size());
+    EXPECT_EQ((*cachedEntries)[0].name, "a.txt");
+    EXPECT_EQ((*cachedEntries)[1].type, DT_DIR);
+    EXPECT_EQ(warmIndex.GetHitCount(), 1);
+
+    GTEST_LOG_(INFO) << "Storage_Service_BundleScanIndexTest_FindEntries_001 end";
+}
+
+/**
+ * @tc.name: Storage_Service_BundleScanIndexTest_FindEntries_002
+ * @tc.desc: Verify that a changed or recently modified directory is not taken from the index.
+ * @tc.type: FUNC
+ * @tc.require: AR000HSKSO
+ */
+HWTEST_F(BundleScanIndexTest, Storage_Service_BundleScanIndexTest_FindEntries_002, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "Storage_Service_BundleScanIndexTest_FindEntries_002 start";
+
+    struct stat dirStat = MakeDirStat(OLD_DIR_TIME);
+    struct stat recentDirStat = MakeDirStat(time(nullptr));
+    std::vector<ScanIndexEntry> entries = { {"a.txt", DT_REG} };
+    BundleScanIndex index(SCAN_INDEX_PATH);
+    index.UpdateEntries(SCAN_DIR_PATH, dirStat, entries);
+    index.UpdateEntries(SCAN_DIR_PATH + "recent/", recentDirStat, entries);
+    EXPECT_TRUE(index.Save());
+
+    BundleScanIndex warmIndex(SCAN_INDEX_PATH);
+    EXPECT_TRUE(warmIndex.Load());
+    struct stat changedDirStat = dirStat;
+    changedDirStat.st_ctim.tv_nsec = 1;
+    EXPECT_EQ(warmIndex.FindEntries(SCAN_DIR_PATH, changedDirStat), nullptr);
+    EXPECT_EQ(warmIndex.FindEntries(SCAN_DIR_PATH + "recent/", recentDirStat), nullptr);
+    EXPECT_EQ(warmIndex.GetMissCount(), 2);
+
+    GTEST_LOG_(INFO) << "Storage_Service_BundleScanIndexTest_FindEntries_002 end";
+}
+/**
+ * @tc.name: Storage_Service_BundleScanIndexTest_Save_001
+ * @tc.desc: Verify that the index is rewritten only when the scan did not match the loaded index exactly.
+ * @tc.type: FUNC
+ * @tc.require: AR000HSKSO
+ */
+HWTEST_F(BundleScanIndexTest, Storage_Service_BundleScanIndexTest_Save_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "Storage_Service_BundleScanIndexTest_Save_001 start";
+
+    struct stat dirStat = MakeDirStat(OLD_DIR_TIME);
+    std::vector<ScanIndexEntry> entries = { {"a.txt", DT_REG} };
+    BundleScanIndex index(SCAN_INDEX_PATH);
+    EXPECT_TRUE(index.IsChanged());
+    index.UpdateEntries(SCAN_DIR_PATH, dirStat, entries);
+    index.UpdateEntries(SCAN_DIR_PATH + "sub/", dirStat, entries);
+    EXPECT_TRUE(index.Save());
+    struct stat savedStat = {0};
+    ASSERT_EQ(stat(SCAN_INDEX_PATH.c_str(), &savedStat), 0);
+
+    // every listing hit, the rename of a new index would give the file another inode
+    BundleScanIndex warmIndex(SCAN_INDEX_PATH);
+    EXPECT_TRUE(warmIndex.Load());
+    EXPECT_NE(warmIndex.FindEntries(SCAN_DIR_PATH, dirStat), nullptr);
+    EXPECT_NE(warmIndex.FindEntries(SCAN_DIR_PATH + "sub/", dirStat), nullptr);
+    EXPECT_FALSE(warmIndex.IsChanged());
+    EXPECT_TRUE(warmIndex.Save());
+    struct stat unchangedStat = {0};
+    ASSERT_EQ(stat(SCAN_INDEX_PATH.c_str(), &unchangedStat), 0);
+    EXPECT_EQ(unchangedStat.st_ino, savedStat.st_ino);
+
+    // a listing that is no longer visited has to be dropped from the index
+    BundleScanIndex shrunkIndex(SCAN_INDEX_PATH);
+    EXPECT_TRUE(shrunkIndex.Load());
+    EXPECT_NE(shrunkIndex.FindEntries(SCAN_DIR_PATH, dirStat), nullptr);
+    EXPECT_TRUE(shrunkIndex.IsChanged());
+
+    GTEST_LOG_(INFO) << "Storage_Service_BundleScanIndexTest_Save_001 end";
+}
+} // STORAGE_DAEMON
+} // OHOS
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "quota/exclude_matcher.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+using namespace testing::ext;
+
+class ExcludeMatcherTest : public testing::Test {
+public:
+    static void SetUpTestCase(void) {};
+    static void TearDownTestCase(void) {};
+    void SetUp() {};
+    void TearDown() {};
+};
+
+/**
+ * @tc.name: Storage_Service_ExcludeMatcherTest_IsExcluded_001
+ * @tc.desc: Verify that a file rule only matches the exact path.
+ * @tc.type: FUNC
+ * @tc.require: AR000HSKSO
+ */
+HWTEST_F(ExcludeMatcherTest, Storage_Service_ExcludeMatcherTest_IsExcluded_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "Storage_Service_ExcludeMatcherTest_IsExcluded_001 start";
+
+    ExcludeMatcher matcher;
+    EXPECT_TRUE(matcher.Empty());
+    EXPECT_FALSE(matcher.IsExcluded("/data/a.txt"));
+    matcher.AddFile("/data/a.txt");
+    EXPECT_FALSE(matcher.Empty());
+    EXPECT_TRUE(matcher.IsExcluded("/data/a.txt"));
+    EXPECT_FALSE(matcher.IsExcluded("/data/a.txt/"));
+    EXPECT_FALSE(matcher.IsExcluded("/data/a.txt2"));
+    EXPECT_FALSE(matcher.IsExcluded("/data/a.txt/b"));
+    EXPECT_FALSE(matcher.IsExcluded("/data/"));
+
+    GTEST_LOG_(INFO) << "Storage_Service_ExcludeMatcherTest_IsExcluded_001 end";
+}
+
+/**
+ * @tc.name: Storage_Service_ExcludeMatcherTest_IsExcluded_002
+ * @tc.desc: Verify that a directory rule matches the directory and every path below it.
+ * @tc.type: FUNC
+ * @tc.require: AR000HSKSO
+ */
+HWTEST_F(ExcludeMatcherTest, Storage_Service_ExcludeMatcherTest_IsExcluded_002, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "Storage_Service_ExcludeMatcherTest_IsExcluded_002 start";
+
+    ExcludeMatcher matcher;
+    matcher.AddDir("/data/cache/");
+    EXPECT_TRUE(matcher.IsExcluded("/data/cache/"));
+    EXPECT_TRUE(matcher.IsExcluded("/data/cache/a.txt"));
+    EXPECT_TRUE(matcher.IsExcluded("/data/cache/sub/"));
+    EXPECT_FALSE(matcher.IsExcluded("/data/cache"));
+    EXPECT_FALSE(matcher.IsExcluded("/data/cache2/"));
+    EXPECT_FALSE(matcher.IsExcluded("/data/"));
+
+    GTEST_LOG_(INFO) << "Storage_Service_ExcludeMatcherTest_IsExcluded_002 end";
+}
+} // STORAGE_DAEMON
+} // OHOS
@@ -13,8 +13,12 @@
  * limitations under the License.
  */
 
+#include <dirent.h>
+#include <filesystem>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <stack>
+#include <sys/stat.h>
 
 #include "quota/quota_manager.h"
 #include "storage_service_errno.h"
@@ -33,6 +37,71 @@ const int32_t UID = 20000000;
 const int32_t LIMITSIZE = 1000;
 const std::string EMPTY_STRING = "";
 
+// the directory walk used before the fd-relative scan, it writes the same lines as the old WriteFileList
+static std::string LegacyStatLine(const std::string &path, const struct stat &st, bool isDir, int64_t &size)
+{
+    size += st.st_size;
+    return path + FILE_CONTENT_SEPARATOR + std::to_string(static_cast<int32_t>(st.st_mode)) +
+        FILE_CONTENT_SEPARATOR + (isDir ? "1" : "0") + FILE_CONTENT_SEPARATOR + std::to_string(st.st_size) +
+        FILE_CONTENT_SEPARATOR + std::to_string(static_cast<int64_t>(st.st_mtime)) + FILE_CONTENT_SEPARATOR +
+        FILE_CONTENT_SEPARATOR + "1" + FILE_CONTENT_SEPARATOR + "0";
+}
+
+static std::vector<std::string> LegacyScan(const std::string &dir, const std::string &sandboxDir, int64_t &size)
+{
+    std::vector<std::string> lines;
+    struct stat st = {0};
+    if (stat(dir.c_str(), &st) != 0) {
+        return lines;
+    }
+    lines.push_back(LegacyStatLine(sandboxDir, st, true, size));
+    std::stack<std::string> folderStack;
+    folderStack.push(dir);
+    while (!folderStack.empty()) {
+        std::string filePath = folderStack.top();
+        folderStack.pop();
+        DIR *dirPtr = opendir(filePath.c_str());
+        if (dirPtr == nullptr) {
+            continue;
+        }
+        if (filePath.back() != FILE_SEPARATOR_CHAR) {
+            filePath.push_back(FILE_SEPARATOR_CHAR);
+        }
+        struct dirent *entry = nullptr;
+        while ((entry = readdir(dirPtr)) != nullptr) {
+            if ((strcmp(entry->d_name, ".") == 0) || (strcmp(entry->d_name, "..") == 0)) {
+                continue;
+            }
+            std::string path = filePath + entry->d_name;
+            st = {0};
+            stat(path.c_str(), &st);
+            bool isDir = entry->d_type == DT_DIR;
+            if (isDir) {
+                folderStack.push(path);
+            }
+            lines.push_back(LegacyStatLine(sandboxDir + path.substr(dir.size()), st, isDir, size));
+        }
+        closedir(dirPtr);
+    }
+    return lines;
+}
+
+static void PopulateScanTree(const std::string &root, int depth)
+{
+    const int entriesPerDir = 4;
+    std::filesystem::create_directories(root);
+    for (int i = 0; i < entriesPerDir; i++) {
+        std::ofstream file(root + "/file_" + std::to_string(i) + ".txt", std::ios::out | std::ios::trunc);
+        file << std::string(static_cast<size_t>(depth * entriesPerDir + i), 'x');
+    }
+    if (depth == 0) {
+        return;
+    }
+    for (int i = 0; i < entriesPerDir; i++) {
+        PopulateScanTree(root + "/dir_" + std::to_string(i), depth - 1);
+    }
+}
+
 class QuotaManagerTest : public testing::Test {
 public:
     static void SetUpTestCase(void) {};
@@ -255,6 +324,41 @@ HWTEST_F(QuotaManagerTest, Storage_Service_QuotaManagerTest_GetOccupiedSpace_001
     GTEST_LOG_(INFO) << "Storage_Service_QuotaManagerTest_GetOccupiedSpace_001 end";
 }
 
+/**
+ * @tc.name: Storage_Service_QuotaManagerTest_GetOccupiedSpaceBatch_001
+ * @tc.desc: Test whether GetOccupiedSpaceBatch matches GetOccupiedSpace for every id.
+ * @tc.type: FUNC
+ * @tc.require: AR000HSKSO
+ */
+HWTEST_F(QuotaManagerTest, Storage_Service_QuotaManagerTest_GetOccupiedSpaceBatch_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "Storage_Service_QuotaManagerTest_GetOccupiedSpaceBatch_001 start";
+
+    QuotaManager *quotaManager = QuotaManager::GetInstance();
+    ASSERT_TRUE(quotaManager != nullptr);
+
+    std::vector<int32_t> ids = { 0, 1006, UID };
+    std::vector<int64_t> sizes;
+    int32_t result = quotaManager->GetOccupiedSpaceBatch(USRID, ids, sizes);
+    EXPECT_EQ(result, E_OK);
+    ASSERT_EQ(sizes.size(), ids.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        int64_t size = 0;
+        EXPECT_EQ(quotaManager->GetOccupiedSpace(USRID, ids[i], size), E_OK);
+        EXPECT_EQ(sizes[i], size);
+    }
+
+    ids.clear();
+    result = quotaManager->GetOccupiedSpaceBatch(USRID, ids, sizes);
+    EXPECT_EQ(result, E_OK);
+    EXPECT_EQ(ids.size(), sizes.size());
+
+    result = quotaManager->GetOccupiedSpaceBatch(-1, ids, sizes);
+    EXPECT_EQ(result, E_NON_EXIST);
+
+    GTEST_LOG_(INFO) << "Storage_Service_QuotaManagerTest_GetOccupiedSpaceBatch_001 end";
+}
+
 /**
  * @tc.name: Storage_Service_QuotaManagerTest_GetBundleStatsForIncrease_001
  * @tc.desc: Test whether GetBundleStatsForIncrease is called normally.
@@ -323,5 +427,109 @@ HWTEST_F(QuotaManagerTest, Storage_Service_QuotaManagerTest_GetBundleStatsForInc
 
     GTEST_LOG_(INFO) << "Storage_Service_QuotaManagerTest_GetBundleStatsForIncrease_001 end";
 }
+
+/**
+ * @tc.name: Storage_Service_QuotaManagerTest_GetBundleStatsForIncrease_002
+ * @tc.desc: Verify that GetBundleStatsForIncrease keeps sizes in bundle order when scanning bundles concurrently.
+ * @tc.type: FUNC
+ * @tc.require: AR000HSKSO
+ */
+HWTEST_F(QuotaManagerTest, Storage_Service_QuotaManagerTest_GetBundleStatsForIncrease_002, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "Storage_Service_QuotaManagerTest_GetBundleStatsForIncrease_002 start";
+
+    QuotaManager *quotaManager = QuotaManager::GetInstance();
+    ASSERT_TRUE(quotaManager != nullptr);
+
+    uint32_t userId = 100;
+    std::vector<std::string> bundleNames = { "com.ohos.bundleName-0-1", "com.ohos.bundleName-0-2",
+        "com.ohos.bundleName-0-3", "com.ohos.bundleName-0-4", "com.ohos.bundleName-0-5" };
+    std::vector<int64_t> incrementalBackTimes(bundleNames.size(), 0);
+    std::vector<int64_t> pkgFileSizes;
+    std::vector<int64_t> incPkgFileSizes;
+    auto ret = quotaManager->GetBundleStatsForIncrease(userId, bundleNames, incrementalBackTimes, pkgFileSizes,
+        incPkgFileSizes);
+    EXPECT_EQ(ret, E_OK);
+    ASSERT_EQ(pkgFileSizes.size(), bundleNames.size());
+    ASSERT_EQ(incPkgFileSizes.size(), bundleNames.size());
+    for (size_t i = 0; i < bundleNames.size(); i++) {
+        EXPECT_EQ(pkgFileSizes[i], 0);
+        EXPECT_EQ(incPkgFileSizes[i], 0);
+    }
+
+    incrementalBackTimes.pop_back();
+    ret = quotaManager->GetBundleStatsForIncrease(userId, bundleNames, incrementalBackTimes, pkgFileSizes,
+        incPkgFileSizes);
+    EXPECT_EQ(ret, E_SYS_ERR);
+
+    GTEST_LOG_(INFO) << "Storage_Service_QuotaManagerTest_GetBundleStatsForIncrease_002 end";
+}
+
+/**
+ * @tc.name: Storage_Service_QuotaManagerTest_GetBundleStatsForIncrease_003
+ * @tc.desc: Verify that the concurrent fd-relative scan writes the same stat lines as the old path based walk.
+ * @tc.type: FUNC
+ * @tc.require: AR000HSKSO
+ */
+HWTEST_F(QuotaManagerTest, Storage_Service_QuotaManagerTest_GetBundleStatsForIncrease_003, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "Storage_Service_QuotaManagerTest_GetBundleStatsForIncrease_003 start";
+    QuotaManager *quotaManager = QuotaManager::GetInstance();
+    ASSERT_TRUE(quotaManager != nullptr);
+
+    uint32_t userId = 100;
+    const int treeDepth = 3;
+    std::string sandboxDir = MEDIA_SAND_PREFIX + "/local/files/quota_manager_scan_test/";
+    std::string physicalDir = MEDIA_SAND_PREFIX + FILE_SEPARATOR_CHAR + std::to_string(userId) +
+        "/local/files/quota_manager_scan_test/";
+    PopulateScanTree(physicalDir, treeDepth);
+    int64_t expectSize = 0;
+    std::vector<std::string> expectLines = LegacyScan(physicalDir, sandboxDir, expectSize);
+    ASSERT_GT(expectLines.size(), 1);
+
+    // more bundles than scan threads, every one of them includes the same tree
+    std::vector<std::string> bundleNames;
+    for (int i = 0; i < 6; i++) {
+        std::string bundleName = "com.ohos.quotaScanTest" + std::to_string(i);
+        std::string backupSaBundleDir = BACKUP_PATH_PREFIX + std::to_string(userId) + BACKUP_PATH_SURFFIX +
+            bundleName + FILE_SEPARATOR_CHAR;
+        std::filesystem::create_directories(backupSaBundleDir);
+        std::ofstream incExcFile(backupSaBundleDir + BACKUP_INCEXC_SYMBOL + "0", std::ios::out | std::ios::trunc);
+        incExcFile << BACKUP_INCLUDE << std::endl << sandboxDir << std::endl;
+        incExcFile.close();
+        bundleNames.push_back(bundleName);
+    }
+    // a repeated bundle must not race with its first entry on the temp files of the bundle
+    bundleNames.push_back(bundleNames[0]);
+    std::vector<int64_t> incrementalBackTimes(bundleNames.size(), 0);
+    std::vector<int64_t> pkgFileSizes;
+    std::vector<int64_t> incPkgFileSizes;
+    auto ret = quotaManager->GetBundleStatsForIncrease(userId, bundleNames, incrementalBackTimes, pkgFileSizes,
+        incPkgFileSizes);
+    EXPECT_EQ(ret, E_OK);
+    ASSERT_EQ(pkgFileSizes.size(), bundleNames.size());
+    EXPECT_EQ(pkgFileSizes.back(), expectSize);
+    EXPECT_EQ(incPkgFileSizes.back(), expectSize);
+    bundleNames.pop_back();
+
+    for (size_t i = 0; i < bundleNames.size(); i++) {
+        std::string backupSaBundleDir = BACKUP_PATH_PREFIX + std::to_string(userId) + BACKUP_PATH_SURFFIX +
+            bundleNames[i] + FILE_SEPARATOR_CHAR;
+        std::ifstream statFile(backupSaBundleDir + BACKUP_STAT_SYMBOL + "0");
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(statFile, line);) {
+            lines.push_back(line);
+        }
+        ASSERT_EQ(lines.size(), expectLines.size() + 2);
+        EXPECT_EQ(lines[0], VER_10_LINE1);
+        EXPECT_EQ(lines[1], VER_10_LINE2);
+        EXPECT_TRUE(std::equal(expectLines.begin(), expectLines.end(), lines.begin() + 2));
+        EXPECT_EQ(pkgFileSizes[i], expectSize);
+        EXPECT_EQ(incPkgFileSizes[i], expectSize);
+        StorageTest::StorageTestUtils::RmDirRecurse(backupSaBundleDir);
+    }
+    StorageTest::StorageTestUtils::RmDirRecurse(physicalDir);
+    GTEST_LOG_(INFO) << "Storage_Service_QuotaManagerTest_GetBundleStatsForIncrease_003 end";
+}
 } // STORAGE_DAEMON
-} // OHOS
\ No newline at end of file
+} // OHOS
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "quota/stat_file_writer.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+using namespace testing::ext;
+
+const std::string STAT_FILE_PATH = "/data/local/tmp/stat_file_writer_test";
+
+class StatFileWriterTest : public testing::Test {
+public:
+    static void SetUpTestCase(void) {};
+    static void TearDownTestCase(void) {};
+    void SetUp() {};
+    void TearDown()
+    {
+        (void)remove(STAT_FILE_PATH.c_str());
+    };
+};
+
+static std::string ReadStatFile()
+{
+    std::ifstream in(STAT_FILE_PATH);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+/**
+ * @tc.name: Storage_Service_StatFileWriterTest_Commit_001
+ * @tc.desc: Verify that committed lines keep the stat file format.
+ * @tc.type: FUNC
+ * @tc.require: AR000HSKSO
+ */
+HWTEST_F(StatFileWriterTest, Storage_Service_StatFileWriterTest_Commit_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "Storage_Service_StatFileWriterTest_Commit_001 start";
+
+    StatFileWriter writer(STAT_FILE_PATH);
+    ASSERT_TRUE(writer.Open());
+    writer.WriteLine("version=1.0&attrNum=8");
+    writer.WriteFileLine({.path = "/a/b", .mode = 16877, .isDir = true, .size = 4096, .mtime = 1700000000,
+                          .isIncre = true, .encodeFlag = false});
+    writer.WriteFileLine({.path = "/a/%0Ac", .mode = 33188, .isDir = false, .size = -1, .mtime = 0,
+                          .isIncre = false, .encodeFlag = true});
+    EXPECT_EQ(access(STAT_FILE_PATH.c_str(), F_OK), -1);
+    EXPECT_TRUE(writer.Commit());
+    EXPECT_EQ(ReadStatFile(), "version=1.0&attrNum=8\n"
+                              "/a/b;16877;1;4096;1700000000;;1;0\n"
+                              "/a/%0Ac;33188;0;-1;0;;0;1\n");
+    // the file mode is left to the umask, as it was with the ofstream
+    mode_t mask = umask(0);
+    (void)umask(mask);
+    struct stat fileStat = {0};
+    ASSERT_EQ(stat(STAT_FILE_PATH.c_str(), &fileStat), 0);
+    EXPECT_EQ(fileStat.st_mode & ACCESSPERMS, (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH) & ~mask);
+
+    GTEST_LOG_(INFO) << "Storage_Service_StatFileWriterTest_Commit_001 end";
+}
+
+/**
+ * @tc.name: Storage_Service_StatFileWriterTest_Commit_002
+ * @tc.desc: Verify that lines larger than the buffer in total are all written and an uncommitted file is dropped.
+ * @tc.type: FUNC
+ * @tc.require: AR000HSKSO
+ */
+HWTEST_F(StatFileWriterTest, Storage_Service_StatFileWriterTest_Commit_002, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "Storage_Service_StatFileWriterTest_Commit_002 start";
+
+    const int32_t lineNum = 100000;
+    {
+        StatFileWriter writer(STAT_FILE_PATH);
+        ASSERT_TRUE(writer.Open());
+        writer.WriteLine("discarded");
+    }
+    EXPECT_EQ(access(STAT_FILE_PATH.c_str(), F_OK), -1);
+
+    StatFileWriter writer(STAT_FILE_PATH);
+    ASSERT_TRUE(writer.Open());
+    for (int32_t i = 0; i < lineNum; i++) {
+        writer.WriteFileLine({.path = "/data/file", .mode = 33188, .isDir = false, .size = i, .mtime = i,
+                              .isIncre = true, .encodeFlag = false});
+    }
+    EXPECT_TRUE(writer.Commit());
+    std::ifstream in(STAT_FILE_PATH);
+    std::string line;
+    std::string lastLine;
+    int32_t count = 0;
+    while (std::getline(in, line)) {
+        lastLine = line;
+        count++;
+    }
+    EXPECT_EQ(count, lineNum);
+    EXPECT_EQ(lastLine, "/data/file;33188;0;99999;99999;;1;0");
+
+    GTEST_LOG_(INFO) << "Storage_Service_StatFileWriterTest_Commit_002 end";
+}
+} // STORAGE_DAEMON
+} // OHOS
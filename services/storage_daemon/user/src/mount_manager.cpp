@@ -35,9 +35,11 @@
 #include "storage_service_constant.h"
 #include "storage_service_errno.h"
 #include "storage_service_log.h"
+#include "utils/dir_provisioner.h"
 #include "utils/file_utils.h"
 #include "utils/mount_argument_utils.h"
 #include "utils/string_utils.h"
+#include "utils/umount_planner.h"
 #include "system_ability_definition.h"
 #ifdef DFS_SERVICE
 #include "cloud_daemon_manager.h"
@@ -54,7 +56,6 @@ using namespace OHOS::FileManagement::CloudFile;
 #endif
 using namespace OHOS::StorageService;
 constexpr int32_t UMOUNT_RETRY_TIMES = 3;
-constexpr int32_t ONE_KB = 1024;
 std::shared_ptr<MountManager> MountManager::instance_ = nullptr;
 
 const string SANDBOX_ROOT_PATH = "/mnt/sandbox/";
@@ -63,7 +64,6 @@ const string PACKAGE_NAME_FLAG = "<bundleName>";
 const string SCENE_BOARD_BUNDLE_NAME = "com.ohos.sceneboard";
 const string PUBLIC_DIR_SANDBOX_PATH = "/storage/Users/currentUser";
 const string PUBLIC_DIR_SRC_PATH = "/storage/media/<currentUserId>/local/files/Docs";
-const string MOUNT_POINT_INFO = "/proc/mounts";
 const string MOUNT_POINT_TYPE_HMDFS = "hmdfs";
 const string MOUNT_POINT_TYPE_HMFS = "hmfs";
 const string MOUNT_POINT_TYPE_SHAREFS = "sharefs";
@@ -282,37 +282,16 @@ int32_t MountManager::FindAndKillProcess(int32_t userId, std::list<std::string>
         return E_OK;
     }
     LOGI("FindAndKillProcess start, userId is %{public}d", userId);
-    auto procDir = std::unique_ptr<DIR, int (*)(DIR*)>(opendir("/proc"), closedir);
-    if (!procDir) {
-        LOGE("failed to open dir proc, err %{public}d", errno);
-        return -errno;
-    }
+    Utils::MountArgument argument(Utils::MountArgumentDescriptors::Alpha(userId, ""));
+    std::vector<std::string> prefixes(mountFailList.begin(), mountFailList.end());
+    prefixes.push_back(argument.GetMountPointPrefix());
+    PathPrefixMatcher matcher(prefixes, false);
+    ProcessScanner scanner(matcher, true);
     std::vector<ProcessInfo> processInfos;
-    struct dirent *entry;
-    while ((entry = readdir(procDir.get())) != nullptr) {
-        if (entry->d_type != DT_DIR) {
-            continue;
-        }
-        std::string name = entry->d_name;
-        if (!StringIsNumber(name)) {
-            continue;
-        }
-        ProcessInfo info;
-        std::string filename = "/proc/" + name + "/stat";
-        if (!GetProcessInfo(filename, info)) {
-            LOGE("failed to get process info, pid is %{public}s.", name.c_str());
-            continue;
-        }
-        if (info.name == "(storage_daemon)") {
-            continue;
-        }
-        Utils::MountArgument argument(Utils::MountArgumentDescriptors::Alpha(userId, ""));
-        const string &prefix = argument.GetMountPointPrefix();
-        std::string pidPath = "/proc/" + name;
-        if (PidUsingFlag(pidPath, prefix, mountFailList)) {
-            LOGE("find a link pid is %{public}d, processName is %{public}s.", info.pid, info.name.c_str());
-            processInfos.push_back(info);
-        }
+    int32_t ret = scanner.Scan(processInfos);
+    if (ret != E_OK) {
+        LOGE("failed to scan processes, ret %{public}d", ret);
+        return ret;
     }
     LOGI("FindAndKillProcess end, total find %{public}d", static_cast<int>(processInfos.size()));
     KillProcess(processInfos);
@@ -336,30 +315,6 @@ void MountManager::UmountFailRadar(std::vector<ProcessInfo> &processInfos)
     }
 }
 
-bool MountManager::PidUsingFlag(std::string &pidPath, const std::string &prefix, std::list<std::string> &mountFailList)
-{
-    bool found = false;
-    found |= CheckMaps(pidPath + "/maps", prefix, mountFailList);
-    found |= CheckSymlink(pidPath + "/cwd", prefix, mountFailList);
-    found |= CheckSymlink(pidPath + "/root", prefix, mountFailList);
-    found |= CheckSymlink(pidPath + "/exe", prefix, mountFailList);
-
-    std::string fdPath = pidPath + "/fd";
-    auto fdDir = std::unique_ptr<DIR, int (*)(DIR*)>(opendir(fdPath.c_str()), closedir);
-    if (!fdDir) {
-        LOGE("unable to open %{public}s, err %{public}d", fdPath.c_str(), errno);
-    } else {
-        struct dirent* fdDirent;
-        while ((fdDirent = readdir(fdDir.get())) != nullptr) {
-            if (fdDirent->d_type != DT_LNK) {
-                continue;
-            }
-            found |= CheckSymlink(fdPath + "/" +fdDirent->d_name, prefix, mountFailList);
-        }
-    }
-    return found;
-}
-
 void MountManager::KillProcess(std::vector<ProcessInfo> &processInfo)
 {
     if (processInfo.empty()) {
@@ -371,97 +326,6 @@ void MountManager::KillProcess(std::vector<ProcessInfo> &processInfo)
     }
 }
 
-bool MountManager::GetProcessInfo(const std::string &filename, ProcessInfo &info)
-{
-    if (filename.empty()) {
-        return false;
-    }
-    LOGE("GetProcessInfo path is %{public}s", filename.c_str());
-    std::ifstream inputStream(filename.c_str(), std::ios::in);
-    if (!inputStream.is_open()) {
-        LOGE("unable to open %{public}s, err %{public}d", filename.c_str(), errno);
-        return false;
-    }
-    std::string line;
-    std::getline(inputStream, line);
-    if (line.empty()) {
-        LOGE("line is empty");
-        inputStream.close();
-        return false;
-    }
-    std::stringstream ss(line);
-    std::string pid;
-    ss >> pid;
-    std::string processName;
-    ss >> processName;
-    info.pid = std::stoi(pid);
-    info.name = processName;
-    LOGE("GetProcessInfo pid is %{public}s and name is %{public}s", pid.c_str(), processName.c_str());
-    inputStream.close();
-    return true;
-}
-
-bool MountManager::CheckMaps(const std::string &path, const std::string &prefix, std::list<std::string> &mountFailList)
-{
-    if (path.empty()) {
-        return false;
-    }
-    std::ifstream inputStream(path.c_str(), std::ios::in);
-    if (!inputStream.is_open()) {
-        LOGE("unable to open %{public}s, err %{public}d", path.c_str(), errno);
-        return false;
-    }
-    LOGE("CheckMaps path is %{public}s", path.c_str());
-    std::string tmpLine;
-    while (std::getline(inputStream, tmpLine)) {
-        std::string::size_type pos = tmpLine.find("/");
-        if (pos == std::string::npos) {
-            continue;
-        }
-        tmpLine = tmpLine.substr(pos);
-        if (tmpLine.find(prefix) == 0) {
-            LOGE("find a fd %{public}s", tmpLine.c_str());
-            inputStream.close();
-            return true;
-        }
-        for (const auto &item: mountFailList) {
-            if (tmpLine.find(item) == 0) {
-                LOGE("find a fd %{public}s", tmpLine.c_str());
-                inputStream.close();
-                return true;
-            }
-        }
-    }
-    inputStream.close();
-    return false;
-}
-
-bool MountManager::CheckSymlink(const std::string &path,
-                                const std::string &prefix, std::list<std::string> &mountFailList)
-{
-    if (path.empty()) {
-        return false;
-    }
-    char realPath[ONE_KB];
-    int res = readlink(path.c_str(), realPath, sizeof(realPath) - 1);
-    if (res < 0 || res >= ONE_KB) {
-        return false;
-    }
-    realPath[res] = '\0';
-    std::string realPathStr(realPath);
-    if (realPathStr.find(prefix) == 0) {
-        LOGE("find a fd %{public}s", realPathStr.c_str());
-        return true;
-    }
-    for (const auto &item: mountFailList) {
-        if (realPathStr.find(item) == 0) {
-            LOGE("find a fd %{public}s", realPathStr.c_str());
-            return true;
-        }
-    }
-    return false;
-}
-
 int32_t MountManager::CloudMount(int32_t userId, const string& path)
 {
     LOGI("cloud mount start");
@@ -686,135 +550,56 @@ void MountManager::MountSandboxPath(const std::vector<std::string> &srcPaths, co
     }
 }
 
-void MountManager::MountPointToList(std::list<std::string> &hmdfsList, std::list<std::string> &hmfsList,
-    std::list<std::string> &sharefsList, std::string &line, int32_t userId)
-{
-    if (line.empty()) {
-        return;
-    }
-    Utils::MountArgument hmdfsMntArgs(Utils::MountArgumentDescriptors::Alpha(userId, ""));
-    const string &hmdfsPrefix = hmdfsMntArgs.GetMountPointPrefix();
-    const string &hmfsPrefix = hmdfsMntArgs.GetSandboxPath();
-    const string &sharefsPrefix = hmdfsMntArgs.GetShareSrc();
-    const string &cloudPrefix = hmdfsMntArgs.GetFullCloud();
-    std::stringstream ss(line);
-    std::string src;
-    ss >> src;
-    std::string dst;
-    ss >> dst;
-    std::string type;
-    ss >> type;
-    if (type == MOUNT_POINT_TYPE_HMDFS) {
-        if (src.length() >= hmdfsPrefix.length() && src.substr(0, hmdfsPrefix.length()) == hmdfsPrefix) {
-            hmdfsList.push_front(dst);
-        }
-        if (src.length() >= cloudPrefix.length() && src.substr(0, cloudPrefix.length()) == cloudPrefix) {
-            hmdfsList.push_front(dst);
-        }
-        return;
-    }
-    if (type == MOUNT_POINT_TYPE_HMFS) {
-        if (dst.length() >= hmfsPrefix.length() && dst.substr(0, hmfsPrefix.length()) == hmfsPrefix) {
-            hmfsList.push_front(dst);
-        }
-        return;
-    }
-    if (type == MOUNT_POINT_TYPE_SHAREFS) {
-        if (src.length() >= sharefsPrefix.length() &&
-            src.substr(0, sharefsPrefix.length()) == sharefsPrefix) {
-            sharefsList.push_front(dst);
-        }
-        return;
-    }
-}
-
-int32_t MountManager::FindMountPointsToMap(std::map<std::string, std::list<std::string>> &mountMap, int32_t userId)
+static bool StartsWith(const std::string &str, const std::string &prefix)
 {
-    std::ifstream inputStream(MOUNT_POINT_INFO.c_str(), std::ios::in);
-    if (!inputStream.is_open()) {
-        LOGE("unable to open /proc/mounts, errno is %{public}d", errno);
-        return -errno;
-    }
-    std::list<std::string> hmdfsList;
-    std::list<std::string> hmfsList;
-    std::list<std::string> sharefsList;
-    std::string tmpLine;
-    while (std::getline(inputStream, tmpLine)) {
-        MountPointToList(hmdfsList, hmfsList, sharefsList, tmpLine, userId);
-    }
-    inputStream.close();
-    mountMap[MOUNT_POINT_TYPE_HMDFS] = hmdfsList;
-    mountMap[MOUNT_POINT_TYPE_HMFS] = hmfsList;
-    mountMap[MOUNT_POINT_TYPE_SHAREFS] = sharefsList;
-    hmdfsList.clear();
-    hmfsList.clear();
-    sharefsList.clear();
-    return E_OK;
+    return str.compare(0, prefix.size(), prefix) == 0;
 }
 
 int32_t MountManager::UMountAllPath(int32_t userId, std::list<std::string> &mountFailList)
 {
-    std::map<std::string, std::list<std::string>> mountMap;
-    int32_t res = FindMountPointsToMap(mountMap, userId);
+    UmountPlanner planner("user " + std::to_string(userId));
+    int32_t res = planner.Load();
     if (res != E_OK) {
         return res;
     }
-    int32_t result = 0;
-    std::list<std::string> list = mountMap[MOUNT_POINT_TYPE_SHAREFS];
-    int total = static_cast<int>(list.size());
-    LOGI("unmount sharefs path start, total %{public}d.", total);
-    res = UMountByList(list, mountFailList);
+    Utils::MountArgument hmdfsMntArgs(Utils::MountArgumentDescriptors::Alpha(userId, ""));
+    const string hmdfsPrefix = hmdfsMntArgs.GetMountPointPrefix();
+    const string hmfsPrefix = hmdfsMntArgs.GetSandboxPath();
+    const string sharefsPrefix = hmdfsMntArgs.GetShareSrc();
+    const string cloudPrefix = hmdfsMntArgs.GetFullCloud();
+
+    // sharefs is stacked on hmdfs and keeps it busy, so the phases still run one after the other
+    int32_t result = E_OK;
+    res = planner.RunPhase(MOUNT_POINT_TYPE_SHAREFS, [&sharefsPrefix](const MountInfoEntry &entry) {
+        return entry.fsType == MOUNT_POINT_TYPE_SHAREFS && StartsWith(entry.source, sharefsPrefix);
+    }, mountFailList);
     if (res != E_OK) {
         result = res;
     }
-
-    list = mountMap[MOUNT_POINT_TYPE_HMDFS];
-    total = static_cast<int>(list.size());
-    LOGI("unmount hmdfs path start, total %{public}d.", total);
-    res = UMountByList(list, mountFailList);
+    res = planner.RunPhase(MOUNT_POINT_TYPE_HMDFS, [&hmdfsPrefix, &cloudPrefix](const MountInfoEntry &entry) {
+        return entry.fsType == MOUNT_POINT_TYPE_HMDFS &&
+            (StartsWith(entry.source, hmdfsPrefix) || StartsWith(entry.source, cloudPrefix));
+    }, mountFailList);
     if (res != E_OK) {
         result = res;
     }
-    LOGI("result is %{public}d.", result);
-    list = mountMap[MOUNT_POINT_TYPE_HMFS];
-    total = static_cast<int>(list.size());
-    LOGI("unmount hmfs path start, total %{public}d.", total);
-    res = UMountByList(list, mountFailList);
+    res = planner.RunPhase(MOUNT_POINT_TYPE_HMFS, [&hmfsPrefix](const MountInfoEntry &entry) {
+        return entry.fsType == MOUNT_POINT_TYPE_HMFS && StartsWith(entry.mountPoint, hmfsPrefix);
+    }, mountFailList);
     if (res != E_OK) {
         result = res;
     }
     if (result != E_OK) {
-        for (const auto &item: mountFailList) {
-            res = UMount2(item.c_str(), MNT_DETACH);
-            if (res != E_OK) {
-                LOGE("failed to unmount with detach, path %{public}s, errno %{public}d.", item.c_str(), errno);
-            }
-        }
+        planner.Detach(mountFailList);
+    }
+    planner.ReportTimeline();
+    if (result != E_OK) {
         return result;
     }
     LOGI("UMountAllPath success");
     return E_OK;
 }
 
-int32_t MountManager::UMountByList(std::list<std::string> &list, std::list<std::string> &mountFailList)
-{
-    if (list.empty()) {
-        return E_OK;
-    }
-    int32_t result = E_OK;
-    for (const std::string &path: list) {
-        LOGD("umount path %{public}s.", path.c_str());
-        int32_t res = UMount(path);
-        if (res != E_OK) {
-            LOGE("failed to unmount path %{public}s, errno %{public}d.", path.c_str(), errno);
-            result = errno;
-            mountFailList.push_back(path);
-        }
-    }
-    LOGI("UMountByList result is %{public}d.", result);
-    return result;
-}
-
 void MountManager::MountCloudForUsers(void)
 {
     for (auto it = fuseToMountUsers_.begin(); it != fuseToMountUsers_.end();) {
@@ -1079,12 +864,11 @@ int32_t MountManager::UmountByUser(int32_t userId)
 
 int32_t MountManager::PrepareHmdfsDirs(int32_t userId)
 {
+    DirProvisioner provisioner("hmdfs dirs of user " + std::to_string(userId));
     for (const DirInfo &dir : hmdfsDirVec_) {
-        if (!PrepareDir(StringPrintf(dir.path.c_str(), userId), dir.mode, dir.uid, dir.gid)) {
-            return E_PREPARE_DIR;
-        }
+        provisioner.Add(StringPrintf(dir.path.c_str(), userId), dir.mode, dir.uid, dir.gid);
     }
-    return E_OK;
+    return provisioner.Run();
 }
 
 int32_t MountManager::PrepareFileManagerDirs(int32_t userId)
@@ -1184,15 +968,12 @@ int32_t MountManager::RestoreconSystemServiceDirs(int32_t userId)
 
 int32_t MountManager::CreateSystemServiceDirs(int32_t userId)
 {
-    int32_t err = E_OK;
+    // a failed dir only stops the dirs below it
+    DirProvisioner provisioner("system service dirs of user " + std::to_string(userId));
     for (const DirInfo &dir : systemServiceDir_) {
-        std::string path = StringPrintf(dir.path.c_str(), userId);
-        if (!PrepareDir(path, dir.mode, dir.uid, dir.gid)) {
-            LOGE("failed to prepareDir %{public}s ", path.c_str());
-            err = E_PREPARE_DIR;
-        }
+        provisioner.Add(StringPrintf(dir.path.c_str(), userId), dir.mode, dir.uid, dir.gid);
     }
-    return err;
+    return provisioner.Run();
 }
 
 int32_t MountManager::DestroySystemServiceDirs(int32_t userId)
@@ -24,6 +24,7 @@
 #include "storage_service_constant.h"
 #include "storage_service_errno.h"
 #include "storage_service_log.h"
+#include "utils/dir_provisioner.h"
 #include "utils/string_utils.h"
 
 using namespace std;
@@ -160,15 +161,12 @@ int32_t UserManager::DestroyUserDirs(int32_t userId, uint32_t flags)
     return ret;
 }
 
-inline bool PrepareDirsFromVec(int32_t userId, const std::string &level, const std::vector<DirInfo> &vec)
+inline void AddDirsFromVec(DirProvisioner &provisioner, int32_t userId, const std::string &level,
+    const std::vector<DirInfo> &vec, uint32_t flags)
 {
     for (const DirInfo &dir : vec) {
-        if (!PrepareDir(StringPrintf(dir.path.c_str(), level.c_str(), userId), dir.mode, dir.uid, dir.gid)) {
-            return false;
-        }
+        provisioner.Add(StringPrintf(dir.path.c_str(), level.c_str(), userId), dir.mode, dir.uid, dir.gid, flags);
     }
-
-    return true;
 }
 
 inline bool DestroyDirsFromVec(int32_t userId, const std::string &level, const std::vector<DirInfo> &vec)
@@ -186,45 +184,31 @@ inline bool DestroyDirsFromVec(int32_t userId, const std::string &level, const s
 
 int32_t UserManager::PrepareDirsFromIdAndLevel(int32_t userId, const std::string &level)
 {
-    std::vector<FileList> list;
+    DirProvisioner provisioner(level + " dirs of user " + std::to_string(userId));
+    // set policy on the root dirs before the sub dirs are created in them
     if (level != EL3 && level != EL4 && level != EL5) {
-        if (!PrepareDirsFromVec(userId, level, rootDirVec_)) {
-            LOGE("failed to prepare %{public}s root dirs for userid %{public}d", level.c_str(), userId);
-            if (level != EL1) {
-                return E_PREPARE_DIR;
-            }
-        }
-        // set policy here
-        for (auto item : rootDirVec_) {
-            FileList temp;
-            temp.userId = static_cast<uint32_t>(userId);
-            temp.path = StringPrintf(item.path.c_str(), level.c_str(), userId);
-            list.push_back(temp);
+        uint32_t flags = DirProvisioner::DIR_FLAG_SET_POLICY;
+        if (level == EL1) {
+            flags |= DirProvisioner::DIR_FLAG_OPTIONAL;
         }
+        AddDirsFromVec(provisioner, userId, level, rootDirVec_, flags);
     } else {
-        if (!PrepareDirsFromVec(userId, level, el3DirEl4DirEl5DirVec_)) {
-            LOGE("failed to prepare %{public}s root dirs for userid %{public}d", level.c_str(), userId);
-            return E_PREPARE_DIR;
-        }
-        // set policy here
-        for (auto item : el3DirEl4DirEl5DirVec_) {
-            FileList temp;
-            temp.userId = static_cast<uint32_t>(userId);
-            temp.path = StringPrintf(item.path.c_str(), level.c_str(), userId);
-            list.push_back(temp);
-        }
+        AddDirsFromVec(provisioner, userId, level, el3DirEl4DirEl5DirVec_, DirProvisioner::DIR_FLAG_SET_POLICY);
     }
-    int ret = SetElDirFscryptPolicy(userId, level, list);
+    AddDirsFromVec(provisioner, userId, level, subDirVec_, DirProvisioner::DIR_FLAG_NONE);
+    provisioner.SetPolicyFunc([this, userId, &level](const std::string &path) {
+        FileList temp;
+        temp.userId = static_cast<uint32_t>(userId);
+        temp.path = path;
+        return SetElDirFscryptPolicy(userId, level, { temp });
+    });
+
+    int32_t ret = provisioner.Run();
     if (ret != E_OK) {
-        LOGE("Set el poilcy failed");
+        LOGE("failed to prepare %{public}s dirs for userid %{public}d, ret %{public}d", level.c_str(), userId, ret);
         return ret;
     }
 
-    if (!PrepareDirsFromVec(userId, level, subDirVec_)) {
-        LOGE("failed to prepare %{public}s sub dirs for userid %{public}d", level.c_str(), userId);
-        return E_PREPARE_DIR;
-    }
-
     return E_OK;
 }
 
@@ -380,49 +380,6 @@ HWTEST_F(UserManagerTest, Storage_Manager_UserManagerTest_CheckUserIdRange_001,
     GTEST_LOG_(INFO) << "Storage_Manager_UserManagerTest_CheckUserIdRange_001 end";
 }
 
-/**
- * @tc.name: Storage_Manager_MountManagerTest_Instance_001
- * @tc.desc: Verify the MountManager function.
- * @tc.type: FUNC
- * @tc.require: AR000GK4HB
- */
-HWTEST_F(UserManagerTest, Storage_Manager_MountManagerTest_GetProcessInfo_001, TestSize.Level1)
-{
-    GTEST_LOG_(INFO) << "Storage_Manager_UserManagerTest_GetProcessInfo_001 start";
-
-    std::shared_ptr<MountManager> mountManager = MountManager::GetInstance();
-    ASSERT_TRUE(mountManager != nullptr);
-
-    ProcessInfo info;
-    std::string filename = "";
-
-    bool ret = mountManager->GetProcessInfo(filename, info);
-    EXPECT_EQ(ret, false);
-
-    GTEST_LOG_(INFO) << "Storage_Manager_MountManagerTest_GetProcessInfo_001 end";
-}
-
-/**
- * @tc.name: Storage_Manager_MountManagerTest_GetProcessInfo_002
- * @tc.desc: Verify the MountManager function.
- * @tc.type: FUNC
- * @tc.require: AR000GK4HB
- */
-HWTEST_F(UserManagerTest, Storage_Manager_MountManagerTest_GetProcessInfo_002, TestSize.Level1)
-{
-    GTEST_LOG_(INFO) << "Storage_Manager_MountManagerTest_GetProcessInfo_002 start";
-
-    std::shared_ptr<MountManager> mountManager = MountManager::GetInstance();
-    ASSERT_TRUE(mountManager != nullptr);
-    ProcessInfo info;
-    std::string filename = "/data";
-
-    bool ret = mountManager->GetProcessInfo(filename, info);
-    EXPECT_EQ(ret, false);
-
-    GTEST_LOG_(INFO) << "Storage_Manager_MountManagerTest_GetProcessInfo_002 end";
-}
-
 /**
  * @tc.name: Storage_Manager_MountManagerTest_MountCryptoPathAgain_001
  * @tc.desc: Verify the MountManager function.
@@ -578,31 +535,5 @@ HWTEST_F(UserManagerTest, Storage_Manager_MountManagerTest_UmountFailRadar_000,
     mountManager->KillProcess(processInfos1);
     GTEST_LOG_(INFO) << "Storage_Manager_MountManagerTest_UmountFailRadar_000 end";
 }
-
-/**
- * @tc.name: Storage_Manager_MountManagerTest_CheckMaps_001
- * @tc.desc: Verify the CheckMaps function.
- * @tc.type: FUNC
- * @tc.require: AR000GK4HB
- */
-HWTEST_F(UserManagerTest, Storage_Manager_MountManagerTest_CheckMaps_000, TestSize.Level1)
-{
-    GTEST_LOG_(INFO) << "Storage_Manager_MountManagerTest_UmountFailRadar_000 start";
-
-    std::shared_ptr<MountManager> mountManager = MountManager::GetInstance();
-    ASSERT_TRUE(mountManager != nullptr);
-
-    std::string path = "";
-    std::string prefix = "";
-    std::list<std::string> mountFailList;
-    mountFailList.push_back("test1");
-    mountManager->CheckMaps(path, prefix, mountFailList);
-    mountManager->CheckSymlink(path, prefix, mountFailList);
-
-    path = "file://data/file";
-    mountManager->CheckMaps(path, prefix, mountFailList);
-    mountManager->CheckSymlink(path, prefix, mountFailList);
-    GTEST_LOG_(INFO) << "Storage_Manager_MountManagerTest_UmountFailRadar_000 end";
-}
 } // STORAGE_DAEMON
 } // OHOS
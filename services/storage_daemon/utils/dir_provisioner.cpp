@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/dir_provisioner.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "storage_service_errno.h"
+#include "storage_service_log.h"
+#ifdef USE_LIBRESTORECON
+#include "policycoreutils.h"
+#endif
+
+namespace OHOS {
+namespace StorageDaemon {
+namespace {
+constexpr uint32_t ALL_PERMS = (S_ISUID | S_ISGID | S_ISVTX | S_IRWXU | S_IRWXG | S_IRWXO);
+// a thread is only worth starting for this many dirs
+constexpr size_t DIRS_PER_THREAD = 8;
+constexpr size_t MAX_PROVISION_THREADS = 4;
+
+int64_t SteadyNowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+} // namespace
+
+DirProvisioner::DirProvisioner(const std::string &tag) : tag_(tag)
+{
+}
+
+void DirProvisioner::Add(const std::string &path, mode_t mode, uid_t uid, gid_t gid, uint32_t flags)
+{
+    std::string key = path;
+    while (key.size() > 1 && key.back() == '/') {
+        key.pop_back();
+    }
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        Node &node = nodes_[it->second];
+        node.mode = mode;
+        node.uid = uid;
+        node.gid = gid;
+        node.flags = flags;
+        return;
+    }
+    index_[key] = nodes_.size();
+    Node node;
+    node.path = std::move(key);
+    node.mode = mode;
+    node.uid = uid;
+    node.gid = gid;
+    node.flags = flags;
+    nodes_.push_back(std::move(node));
+}
+
+void DirProvisioner::BuildTree()
+{
+    for (auto &node : nodes_) {
+        node.parent = -1;
+        node.children.clear();
+    }
+    for (size_t k = 0; k < nodes_.size(); k++) {
+        const std::string &path = nodes_[k].path;
+        // the parent is the nearest added dir above, whatever lies in between has to exist already
+        size_t pos = path.rfind('/');
+        while (pos != std::string::npos && pos > 0) {
+            auto it = index_.find(path.substr(0, pos));
+            if (it != index_.end()) {
+                nodes_[k].parent = static_cast<int64_t>(it->second);
+                nodes_[it->second].children.push_back(k);
+                break;
+            }
+            pos = path.rfind('/', pos - 1);
+        }
+    }
+}
+
+int32_t DirProvisioner::Run()
+{
+    int64_t start = SteadyNowMs();
+    BuildTree();
+    std::deque<size_t> ready;
+    for (size_t k = 0; k < nodes_.size(); k++) {
+        if (nodes_[k].parent < 0) {
+            ready.push_back(k);
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    size_t done = 0;
+    size_t failed = 0;
+    int32_t result = E_OK;
+    auto closeIfDone = [](Node &node) {
+        if (node.pending == 0 && node.fd >= 0) {
+            close(node.fd);
+            node.fd = -1;
+        }
+    };
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            cond.wait(lock, [&] { return !ready.empty() || done == nodes_.size(); });
+            if (ready.empty()) {
+                return;
+            }
+            size_t k = ready.front();
+            ready.pop_front();
+            lock.unlock();
+            int32_t ret = PrepareNode(nodes_[k]);
+            lock.lock();
+            Node &node = nodes_[k];
+            done++;
+            if (ret != E_OK && ((node.flags & DIR_FLAG_OPTIONAL) == 0 || ret != E_PREPARE_DIR)) {
+                failed++;
+                // a policy error tells more than a dir that could not be prepared
+                if (result == E_OK || result == E_PREPARE_DIR) {
+                    result = ret;
+                }
+            }
+            // the children are prepared relative to the fd of this dir, it is closed after the last of them
+            node.pending = node.children.size();
+            ready.insert(ready.end(), node.children.begin(), node.children.end());
+            if (node.parent >= 0) {
+                Node &parent = nodes_[node.parent];
+                parent.pending--;
+                closeIfDone(parent);
+            }
+            closeIfDone(node);
+            cond.notify_all();
+        }
+    };
+    size_t threadCnt = std::min(MAX_PROVISION_THREADS, nodes_.size() / DIRS_PER_THREAD + 1);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCnt; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    LOGI("%{public}s prepare %{public}zu dirs with %{public}zu threads, failed %{public}zu, took %{public}lld ms",
+        tag_.c_str(), nodes_.size(), threadCnt, failed, static_cast<long long>(SteadyNowMs() - start));
+    return result;
+}
+
+int32_t DirProvisioner::PrepareNode(Node &node)
+{
+    size_t pos = node.path.rfind('/');
+    if (pos == std::string::npos || pos + 1 == node.path.size()) {
+        LOGE("invalid dir %{public}s", node.path.c_str());
+        return E_PREPARE_DIR;
+    }
+    int parentFd = -1;
+    if (node.parent >= 0) {
+        const Node &parent = nodes_[node.parent];
+        if (parent.fd < 0 && (parent.flags & DIR_FLAG_OPTIONAL) == 0) {
+            LOGE("skip %{public}s, its parent is not prepared", node.path.c_str());
+            return E_PREPARE_DIR;
+        }
+        parentFd = parent.fd;
+    }
+    if (parentFd >= 0) {
+        node.fd = CreateDir(parentFd, node);
+    } else {
+        // a root dir, or the child of an optional dir that failed, which is prepared by its path
+        std::string parentPath = (pos == 0) ? "/" : node.path.substr(0, pos);
+        parentFd = open(parentPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (parentFd < 0) {
+            LOGE("failed to open %{public}s, errno %{public}d", parentPath.c_str(), errno);
+            return SetPolicyIfOptional(node, E_PREPARE_DIR);
+        }
+        node.fd = CreateDir(parentFd, node);
+        close(parentFd);
+    }
+    if (node.fd < 0) {
+        return SetPolicyIfOptional(node, E_PREPARE_DIR);
+    }
+
+    int32_t ret = SetPolicy(node);
+    if (ret != E_OK) {
+        close(node.fd);
+        node.fd = -1;
+    }
+    return ret;
+}
+
+int32_t DirProvisioner::SetPolicy(const Node &node)
+{
+    if ((node.flags & DIR_FLAG_SET_POLICY) == 0 || policy_ == nullptr) {
+        return E_OK;
+    }
+    int32_t ret = policy_(node.path);
+    if (ret != E_OK) {
+        LOGE("failed to set policy of %{public}s, ret %{public}d", node.path.c_str(), ret);
+    }
+    return ret;
+}
+
+// The policy is still set on an optional dir that could not be prepared, its error is not optional.
+int32_t DirProvisioner::SetPolicyIfOptional(const Node &node, int32_t err)
+{
+    if ((node.flags & DIR_FLAG_OPTIONAL) == 0) {
+        return err;
+    }
+    int32_t ret = SetPolicy(node);
+    return ret != E_OK ? ret : err;
+}
+
+// On success, the fd of the dir is returned. On error, -1 is returned.
+int DirProvisioner::CreateDir(int parentFd, const Node &node)
+{
+    LOGD("prepare for %{public}s", node.path.c_str());
+    const char *name = node.path.c_str() + node.path.rfind('/') + 1;
+    bool created = true;
+    // the umask is process wide, it is not touched here as the mode is fixed up on the fd below
+    if (TEMP_FAILURE_RETRY(mkdirat(parentFd, name, node.mode)) != 0) {
+        if (errno != EEXIST) {
+            LOGE("failed to mkdir %{public}s, errno %{public}d", node.path.c_str(), errno);
+            return -1;
+        }
+        created = false;
+    }
+    int fd = TEMP_FAILURE_RETRY(openat(parentFd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    if (fd < 0) {
+        if (errno == ENOTDIR || errno == ELOOP) {
+            LOGE("%{public}s exists and is not a directory", node.path.c_str());
+        } else {
+            LOGE("failed to open %{public}s, errno %{public}d", node.path.c_str(), errno);
+        }
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        LOGE("failed to stat %{public}s, errno %{public}d", node.path.c_str(), errno);
+        close(fd);
+        return -1;
+    }
+    if ((st.st_mode & ALL_PERMS) != node.mode && fchmod(fd, node.mode) != 0) {
+        LOGE("failed to chmod %{public}s, errno %{public}d", node.path.c_str(), errno);
+        close(fd);
+        return -1;
+    }
+    if ((st.st_uid != node.uid || st.st_gid != node.gid) && fchown(fd, node.uid, node.gid) != 0) {
+        LOGE("failed to chown %{public}s, errno %{public}d", node.path.c_str(), errno);
+        close(fd);
+        return -1;
+    }
+
+#ifdef USE_LIBRESTORECON
+    if (created) {
+        int err = Restorecon(node.path.c_str());
+        if (err) {
+            LOGE("failed to restorecon %{public}s, err:%{public}d", node.path.c_str(), err);
+            close(fd);
+            return -1;
+        }
+    }
+#else
+    (void)created;
+#endif
+    return fd;
+}
+} // StorageDaemon
+} // OHOS
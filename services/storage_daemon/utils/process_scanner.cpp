@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/process_scanner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iterator>
+#include <limits.h>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+
+#include "storage_service_errno.h"
+#include "storage_service_log.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+namespace {
+// a thread is only worth starting for this many pids
+constexpr size_t PIDS_PER_THREAD = 64;
+constexpr size_t MAX_SCAN_THREADS = 4;
+constexpr size_t MAPS_BUF_SIZE = 2 * PATH_MAX;
+constexpr size_t STAT_BUF_SIZE = 512;
+
+int64_t SteadyNowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool IsPidName(const char *name)
+{
+    if (*name == '\0') {
+        return false;
+    }
+    for (; *name != '\0'; name++) {
+        if (*name < '0' || *name > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+PathPrefixMatcher::PathPrefixMatcher(const std::vector<std::string> &prefixes, bool wholeComponent)
+    : wholeComponent_(wholeComponent)
+{
+    std::vector<std::string> keys;
+    for (const auto &prefix : prefixes) {
+        if (prefix.empty()) {
+            continue;
+        }
+        std::string key = prefix;
+        if (wholeComponent_) {
+            while (!key.empty() && key.back() == '/') {
+                key.pop_back();
+            }
+            key.push_back('/');
+        }
+        keys.push_back(std::move(key));
+    }
+    std::sort(keys.begin(), keys.end());
+    for (auto &key : keys) {
+        // everything between a prefix and a key it covers shares that prefix, so only the last kept one is checked
+        if (!prefixes_.empty() && key.compare(0, prefixes_.back().size(), prefixes_.back()) == 0) {
+            continue;
+        }
+        prefixes_.push_back(std::move(key));
+    }
+}
+
+bool PathPrefixMatcher::Match(std::string_view path) const
+{
+    if (path.empty() || prefixes_.empty()) {
+        return false;
+    }
+    std::string key;
+    if (wholeComponent_) {
+        key.reserve(path.size() + 1);
+        key.append(path.data(), path.size());
+        key.push_back('/');
+        path = key;
+    }
+    // the only prefix that can match is the greatest one not above the path
+    auto it = std::upper_bound(prefixes_.begin(), prefixes_.end(), path,
+        [](std::string_view value, const std::string &prefix) { return value < prefix; });
+    if (it == prefixes_.begin()) {
+        return false;
+    }
+    --it;
+    return path.compare(0, it->size(), *it) == 0;
+}
+
+ProcessScanner::ProcessScanner(const PathPrefixMatcher &matcher, bool checkFds)
+    : matcher_(matcher), checkFds_(checkFds)
+{
+}
+
+int32_t ProcessScanner::Scan(std::vector<ProcessInfo> &processInfos)
+{
+    if (matcher_.Empty()) {
+        return E_OK;
+    }
+    int64_t listStart = SteadyNowMs();
+    std::vector<pid_t> pids;
+    if (!ListPids(pids)) {
+        return E_ERR;
+    }
+    int64_t inspectStart = SteadyNowMs();
+    size_t threadCnt = std::min(MAX_SCAN_THREADS, pids.size() / PIDS_PER_THREAD + 1);
+    std::atomic<size_t> next(0);
+    std::vector<std::vector<ProcessInfo>> found(threadCnt);
+    auto worker = [this, &pids, &next, &found](size_t index) {
+        for (size_t i = next++; i < pids.size(); i = next++) {
+            ProcessInfo info;
+            if (InspectPid(pids[i], info)) {
+                found[index].push_back(std::move(info));
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCnt; i++) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (auto &infos : found) {
+        std::move(infos.begin(), infos.end(), std::back_inserter(processInfos));
+    }
+    std::sort(processInfos.begin(), processInfos.end(),
+        [](const ProcessInfo &a, const ProcessInfo &b) { return a.pid < b.pid; });
+    int64_t end = SteadyNowMs();
+    LOGI("scan %{public}zu pids with %{public}zu threads, list %{public}lld ms, inspect %{public}lld ms, "
+        "found %{public}zu", pids.size(), threadCnt, static_cast<long long>(inspectStart - listStart),
+        static_cast<long long>(end - inspectStart), processInfos.size());
+    return E_OK;
+}
+
+bool ProcessScanner::ListPids(std::vector<pid_t> &pids)
+{
+    auto procDir = std::unique_ptr<DIR, int (*)(DIR*)>(opendir("/proc"), closedir);
+    if (!procDir) {
+        LOGE("failed to open dir proc, err %{public}d", errno);
+        return false;
+    }
+    pid_t self = getpid();
+    struct dirent *entry;
+    while ((entry = readdir(procDir.get())) != nullptr) {
+        if (entry->d_type != DT_DIR || !IsPidName(entry->d_name)) {
+            continue;
+        }
+        pid_t pid = static_cast<pid_t>(atoi(entry->d_name));
+        if (pid > 0 && pid != self) {
+            pids.push_back(pid);
+        }
+    }
+    return true;
+}
+
+bool ProcessScanner::InspectPid(pid_t pid, ProcessInfo &info)
+{
+    std::string pidPath = "/proc/" + std::to_string(pid);
+    int pidFd = open(pidPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (pidFd < 0) {
+        // exited since the listing
+        return false;
+    }
+    bool found = CheckMaps(pidFd, pid) || CheckSymlink(pidFd, "cwd", pid) || CheckSymlink(pidFd, "root", pid) ||
+        CheckSymlink(pidFd, "exe", pid) || (checkFds_ && CheckFds(pidFd, pid));
+    if (found) {
+        info.pid = pid;
+        if (!ReadName(pidFd, info)) {
+            info.name = "(" + std::to_string(pid) + ")";
+        }
+    }
+    close(pidFd);
+    return found;
+}
+
+bool ProcessScanner::ReadName(int pidFd, ProcessInfo &info)
+{
+    int fd = openat(pidFd, "stat", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char buf[STAT_BUF_SIZE];
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) {
+        return false;
+    }
+    buf[len] = '\0';
+    // the name may contain spaces and brackets itself, it ends at the last ')'
+    const char *start = strchr(buf, '(');
+    const char *end = strrchr(buf, ')');
+    if (start == nullptr || end == nullptr || end < start) {
+        return false;
+    }
+    info.name.assign(start, end + 1);
+    return true;
+}
+
+bool ProcessScanner::CheckMaps(int pidFd, pid_t pid)
+{
+    int fd = openat(pidFd, "maps", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    std::vector<char> buf(MAPS_BUF_SIZE);
+    size_t used = 0;
+    bool found = false;
+    ssize_t len;
+    while (!found && (len = read(fd, buf.data() + used, buf.size() - used)) > 0) {
+        used += static_cast<size_t>(len);
+        char *line = buf.data();
+        char *bufEnd = buf.data() + used;
+        char *lineEnd;
+        while (!found && (lineEnd = static_cast<char *>(memchr(line, '\n', bufEnd - line))) != nullptr) {
+            char *path = static_cast<char *>(memchr(line, '/', lineEnd - line));
+            if (path != nullptr && matcher_.Match(std::string_view(path, lineEnd - path))) {
+                LOGI("pid %{public}d maps %{public}s", pid, std::string(path, lineEnd - path).c_str());
+                found = true;
+            }
+            line = lineEnd + 1;
+        }
+        used = static_cast<size_t>(bufEnd - line);
+        if (used == buf.size()) {
+            // no line end in a full buffer, the line can not be a path we are looking for
+            used = 0;
+        } else if (used > 0) {
+            memmove(buf.data(), line, used);
+        }
+    }
+    close(fd);
+    return found;
+}
+
+bool ProcessScanner::CheckSymlink(int dirFd, const char *name, pid_t pid)
+{
+    char link[PATH_MAX];
+    ssize_t len = readlinkat(dirFd, name, link, sizeof(link));
+    if (len <= 0 || static_cast<size_t>(len) >= sizeof(link)) {
+        return false;
+    }
+    if (!matcher_.Match(std::string_view(link, len))) {
+        return false;
+    }
+    LOGI("pid %{public}d %{public}s links to %{public}s", pid, name, std::string(link, len).c_str());
+    return true;
+}
+
+bool ProcessScanner::CheckFds(int pidFd, pid_t pid)
+{
+    int fdDirFd = openat(pidFd, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fdDirFd < 0) {
+        return false;
+    }
+    auto fdDir = std::unique_ptr<DIR, int (*)(DIR*)>(fdopendir(fdDirFd), closedir);
+    if (!fdDir) {
+        close(fdDirFd);
+        return false;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(fdDir.get())) != nullptr) {
+        if (entry->d_type != DT_LNK) {
+            continue;
+        }
+        if (CheckSymlink(fdDirFd, entry->d_name, pid)) {
+            return true;
+        }
+    }
+    return false;
+}
+} // StorageDaemon
+} // OHOS
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "storage_service_errno.h"
+#include "utils/dir_provisioner.h"
+#include "utils/file_utils.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+using namespace testing::ext;
+
+namespace {
+const uint32_t ALL_PERMS = (S_ISUID | S_ISGID | S_ISVTX | S_IRWXU | S_IRWXG | S_IRWXO);
+const std::string PATH_ROOT = "/data/storage_daemon_dir_provisioner_test_dir";
+
+mode_t GetMode(const std::string &path)
+{
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) {
+        return 0;
+    }
+    return st.st_mode & ALL_PERMS;
+}
+}
+
+class DirProvisionerTest : public testing::Test {
+public:
+    static void SetUpTestCase(void) {};
+    static void TearDownTestCase(void) {};
+    void SetUp()
+    {
+        RmDirRecurse(PATH_ROOT);
+        mkdir(PATH_ROOT.c_str(), 0711);
+    }
+    void TearDown()
+    {
+        RmDirRecurse(PATH_ROOT);
+    }
+};
+
+/**
+ * @tc.name: DirProvisionerTest_Run_001
+ * @tc.desc: Verify that a dir tree is created in any add order and existing dirs get their mode fixed.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(DirProvisionerTest, DirProvisionerTest_Run_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "DirProvisionerTest_Run_001 start";
+    ASSERT_EQ(mkdir((PATH_ROOT + "/exist").c_str(), 0700), 0);
+    DirProvisioner provisioner("test");
+    provisioner.Add(PATH_ROOT + "/a/b/c", 0711, getuid(), getgid());
+    provisioner.Add(PATH_ROOT + "/a/", 02771, getuid(), getgid());
+    provisioner.Add(PATH_ROOT + "/a/b", 0750, getuid(), getgid());
+    provisioner.Add(PATH_ROOT + "/a/d", 0711, getuid(), getgid());
+    provisioner.Add(PATH_ROOT + "/exist", 0771, getuid(), getgid());
+    for (int i = 0; i < 32; i++) {
+        provisioner.Add(PATH_ROOT + "/a/d/" + std::to_string(i), 0711, getuid(), getgid());
+    }
+    EXPECT_EQ(provisioner.Run(), E_OK);
+    EXPECT_EQ(GetMode(PATH_ROOT + "/a"), 02771);
+    EXPECT_EQ(GetMode(PATH_ROOT + "/a/b"), 0750);
+    EXPECT_EQ(GetMode(PATH_ROOT + "/a/b/c"), 0711);
+    EXPECT_EQ(GetMode(PATH_ROOT + "/a/d/31"), 0711);
+    EXPECT_EQ(GetMode(PATH_ROOT + "/exist"), 0771);
+    GTEST_LOG_(INFO) << "DirProvisionerTest_Run_001 end";
+}
+
+/**
+ * @tc.name: DirProvisionerTest_Run_002
+ * @tc.desc: Verify that the policy is set on empty dirs and a failed policy skips the dirs below.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(DirProvisionerTest, DirProvisionerTest_Run_002, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "DirProvisionerTest_Run_002 start";
+    DirProvisioner provisioner("test");
+    provisioner.Add(PATH_ROOT + "/el1", 0711, getuid(), getgid(), DirProvisioner::DIR_FLAG_SET_POLICY);
+    provisioner.Add(PATH_ROOT + "/el1/base", 0711, getuid(), getgid());
+    provisioner.Add(PATH_ROOT + "/el2", 0711, getuid(), getgid(), DirProvisioner::DIR_FLAG_SET_POLICY);
+    provisioner.Add(PATH_ROOT + "/el2/base", 0711, getuid(), getgid());
+    std::mutex mutex;
+    std::set<std::string> policyDirs;
+    provisioner.SetPolicyFunc([&mutex, &policyDirs](const std::string &path) -> int32_t {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!std::filesystem::is_empty(path)) {
+            return E_ERR;
+        }
+        policyDirs.insert(path);
+        return path == PATH_ROOT + "/el2" ? E_SET_POLICY : E_OK;
+    });
+    EXPECT_EQ(provisioner.Run(), E_SET_POLICY);
+    EXPECT_EQ(policyDirs.size(), 2);
+    EXPECT_EQ(access((PATH_ROOT + "/el1/base").c_str(), F_OK), 0);
+    EXPECT_NE(access((PATH_ROOT + "/el2/base").c_str(), F_OK), 0);
+    GTEST_LOG_(INFO) << "DirProvisionerTest_Run_002 end";
+}
+
+/**
+ * @tc.name: DirProvisionerTest_Run_003
+ * @tc.desc: Verify that a file in the way fails its dir, and an optional dir only fails the dirs below it.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(DirProvisionerTest, DirProvisionerTest_Run_003, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "DirProvisionerTest_Run_003 start";
+    int fd = open((PATH_ROOT + "/file").c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0600);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    DirProvisioner provisioner("test");
+    provisioner.Add(PATH_ROOT + "/file", 0711, getuid(), getgid());
+    provisioner.Add(PATH_ROOT + "/other", 0711, getuid(), getgid());
+    EXPECT_EQ(provisioner.Run(), E_PREPARE_DIR);
+    EXPECT_EQ(GetMode(PATH_ROOT + "/other"), 0711);
+
+    DirProvisioner optional("test");
+    optional.Add(PATH_ROOT + "/file", 0711, getuid(), getgid(), DirProvisioner::DIR_FLAG_OPTIONAL);
+    optional.Add(PATH_ROOT + "/other", 0711, getuid(), getgid());
+    EXPECT_EQ(optional.Run(), E_OK);
+    optional.Add(PATH_ROOT + "/file/sub", 0711, getuid(), getgid());
+    EXPECT_EQ(optional.Run(), E_PREPARE_DIR);
+    GTEST_LOG_(INFO) << "DirProvisionerTest_Run_003 end";
+}
+/**
+ * @tc.name: DirProvisionerTest_Run_004
+ * @tc.desc: Verify that the dirs below a failed optional root are prepared and its policy error is returned.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(DirProvisionerTest, DirProvisionerTest_Run_004, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "DirProvisionerTest_Run_004 start";
+    // the root is a symlink, it can not be opened without following it
+    ASSERT_EQ(mkdir((PATH_ROOT + "/target").c_str(), 0711), 0);
+    ASSERT_EQ(symlink((PATH_ROOT + "/target").c_str(), (PATH_ROOT + "/el1").c_str()), 0);
+    uint32_t flags = DirProvisioner::DIR_FLAG_SET_POLICY | DirProvisioner::DIR_FLAG_OPTIONAL;
+
+    DirProvisioner provisioner("test");
+    provisioner.Add(PATH_ROOT + "/el1", 0711, getuid(), getgid(), flags);
+    provisioner.Add(PATH_ROOT + "/el1/base", 0751, getuid(), getgid());
+    provisioner.Add(PATH_ROOT + "/el1/base/sub", 0750, getuid(), getgid());
+    int32_t policyCnt = 0;
+    provisioner.SetPolicyFunc([&policyCnt](const std::string &path) -> int32_t {
+        policyCnt++;
+        return E_OK;
+    });
+    EXPECT_EQ(provisioner.Run(), E_OK);
+    EXPECT_EQ(policyCnt, 1);
+    EXPECT_EQ(GetMode(PATH_ROOT + "/target/base"), 0751);
+    EXPECT_EQ(GetMode(PATH_ROOT + "/target/base/sub"), 0750);
+
+    provisioner.SetPolicyFunc([](const std::string &path) -> int32_t {
+        return E_SET_POLICY;
+    });
+    EXPECT_EQ(provisioner.Run(), E_SET_POLICY);
+    GTEST_LOG_(INFO) << "DirProvisionerTest_Run_004 end";
+}
+} // STORAGE_DAEMON
+} // OHOS
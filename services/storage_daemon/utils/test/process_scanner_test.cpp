@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <csignal>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "storage_service_errno.h"
+#include "utils/process_scanner.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+using namespace testing::ext;
+
+namespace {
+    const std::string PATH_SCAN = "/data/storage_daemon_process_scanner_test_dir";
+}
+
+class ProcessScannerTest : public testing::Test {
+public:
+    static void SetUpTestCase(void) {};
+    static void TearDownTestCase(void) {};
+    void SetUp() {};
+    void TearDown() {};
+};
+
+/**
+ * @tc.name: ProcessScannerTest_Match_001
+ * @tc.desc: Verify that raw prefixes match any path starting with them.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(ProcessScannerTest, ProcessScannerTest_Match_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "ProcessScannerTest_Match_001 start";
+    PathPrefixMatcher matcher({ "/mnt/hmdfs/100", "/mnt/hmdfs/100/account", "/data/service/el2", "" }, false);
+    EXPECT_TRUE(matcher.Match("/mnt/hmdfs/100/account/device_view"));
+    EXPECT_TRUE(matcher.Match("/mnt/hmdfs/1001"));
+    EXPECT_TRUE(matcher.Match("/data/service/el2/100/hmdfs"));
+    EXPECT_FALSE(matcher.Match("/mnt/hmdfs/10"));
+    EXPECT_FALSE(matcher.Match("/data/service/el1"));
+    EXPECT_FALSE(matcher.Match(""));
+
+    PathPrefixMatcher empty({}, false);
+    EXPECT_TRUE(empty.Empty());
+    EXPECT_FALSE(empty.Match("/mnt"));
+    GTEST_LOG_(INFO) << "ProcessScannerTest_Match_001 end";
+}
+
+/**
+ * @tc.name: ProcessScannerTest_Match_002
+ * @tc.desc: Verify that whole component prefixes only match themselves and the paths below them.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(ProcessScannerTest, ProcessScannerTest_Match_002, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "ProcessScannerTest_Match_002 start";
+    PathPrefixMatcher matcher({ "/mnt/data/external/vol-1/", "/mnt/data/external/vol-1-2" }, true);
+    EXPECT_TRUE(matcher.Match("/mnt/data/external/vol-1"));
+    EXPECT_TRUE(matcher.Match("/mnt/data/external/vol-1/DCIM/a.jpg"));
+    EXPECT_TRUE(matcher.Match("/mnt/data/external/vol-1-2/b.txt"));
+    EXPECT_FALSE(matcher.Match("/mnt/data/external/vol-10"));
+    EXPECT_FALSE(matcher.Match("/mnt/data/external"));
+    GTEST_LOG_(INFO) << "ProcessScannerTest_Match_002 end";
+}
+
+/**
+ * @tc.name: ProcessScannerTest_Scan_001
+ * @tc.desc: Verify that a process working in a scanned dir is found and the scanner itself is not.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(ProcessScannerTest, ProcessScannerTest_Scan_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "ProcessScannerTest_Scan_001 start";
+    mkdir(PATH_SCAN.c_str(), S_IRWXU);
+    int pipeFds[2];
+    ASSERT_EQ(pipe(pipeFds), 0);
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        char ready = chdir(PATH_SCAN.c_str()) == 0 ? 1 : 0;
+        (void)write(pipeFds[1], &ready, 1);
+        pause();
+        _exit(0);
+    }
+    char ready = 0;
+    EXPECT_EQ(read(pipeFds[0], &ready, 1), 1);
+    EXPECT_EQ(ready, 1);
+    int fd = open(PATH_SCAN.c_str(), O_RDONLY | O_DIRECTORY);
+
+    PathPrefixMatcher matcher({ PATH_SCAN }, true);
+    ProcessScanner scanner(matcher, true);
+    std::vector<ProcessInfo> processInfos;
+    int32_t ret = scanner.Scan(processInfos);
+
+    // clean up before checking, a failed assertion must not leave the child behind
+    close(fd);
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+    rmdir(PATH_SCAN.c_str());
+
+    EXPECT_EQ(ret, E_OK);
+    ASSERT_EQ(processInfos.size(), 1);
+    EXPECT_EQ(processInfos[0].pid, child);
+    EXPECT_FALSE(processInfos[0].name.empty());
+    GTEST_LOG_(INFO) << "ProcessScannerTest_Scan_001 end";
+}
+} // STORAGE_DAEMON
+} // OHOS
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <map>
+#include <mutex>
+
+#include "gtest/gtest.h"
+#include "storage_service_errno.h"
+#include "utils/umount_planner.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+using namespace testing::ext;
+
+namespace {
+const std::string TEST_MOUNTINFO =
+    "20 1 0:20 / / rw,relatime shared:1 - rootfs rootfs rw\n"
+    "30 20 0:30 / /mnt/hmdfs/100/account rw shared:5 - hmdfs /data/service/el2/100/hmdfs/account rw\n"
+    "31 30 0:31 / /mnt/hmdfs/100/account/cloud rw shared:6 - hmdfs /data/service/el2/100/hmdfs/cloud rw\n"
+    "32 20 0:32 / /mnt/hmdfs/100/non_account rw shared:7 master:2 - hmdfs /data/service/el2/100/hmdfs/non_account rw\n"
+    "33 31 0:33 / /mnt/hmdfs/100/account/cloud/a\\040b rw - tmpfs tmpfs rw\n"
+    "34 33 0:34 / /mnt/hmdfs/100/account/cloud/a\\040b/c rw - hmdfs /data/service/el2/100/hmdfs/c rw\n"
+    "40 20 0:40 / /mnt/hmdfs/101/account rw - hmdfs /data/service/el2/101/hmdfs/account rw\n";
+
+bool IsUser100Hmdfs(const MountInfoEntry &entry)
+{
+    return entry.fsType == "hmdfs" && entry.source.compare(0, 26, "/data/service/el2/100/hmdf") == 0;
+}
+}
+
+class UmountPlannerTest : public testing::Test {
+public:
+    static void SetUpTestCase(void) {};
+    static void TearDownTestCase(void) {};
+    void SetUp() {};
+    void TearDown() {};
+};
+
+/**
+ * @tc.name: UmountPlannerTest_Parse_001
+ * @tc.desc: Verify that mountinfo lines are parsed with optional fields and escaped paths.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(UmountPlannerTest, UmountPlannerTest_Parse_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "UmountPlannerTest_Parse_001 start";
+    UmountPlanner planner("test");
+    planner.Parse(TEST_MOUNTINFO + "bad line\n");
+    const auto &mounts = planner.Mounts();
+    ASSERT_EQ(mounts.size(), 7);
+    EXPECT_EQ(mounts[3].id, 32);
+    EXPECT_EQ(mounts[3].parentId, 20);
+    EXPECT_EQ(mounts[3].fsType, "hmdfs");
+    EXPECT_EQ(mounts[3].source, "/data/service/el2/100/hmdfs/non_account");
+    EXPECT_EQ(mounts[4].mountPoint, "/mnt/hmdfs/100/account/cloud/a b");
+    EXPECT_EQ(mounts[4].fsType, "tmpfs");
+    GTEST_LOG_(INFO) << "UmountPlannerTest_Parse_001 end";
+}
+
+/**
+ * @tc.name: UmountPlannerTest_RunPhase_001
+ * @tc.desc: Verify that selected mounts are unmounted below their selected ancestors first.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(UmountPlannerTest, UmountPlannerTest_RunPhase_001, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "UmountPlannerTest_RunPhase_001 start";
+    UmountPlanner planner("test");
+    planner.Parse(TEST_MOUNTINFO);
+    std::mutex mutex;
+    std::vector<std::string> order;
+    planner.SetUmountFunc([&mutex, &order](const std::string &path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(path);
+        return 0;
+    });
+    std::list<std::string> failList;
+    EXPECT_EQ(planner.RunPhase("hmdfs", IsUser100Hmdfs, failList), E_OK);
+    EXPECT_TRUE(failList.empty());
+    ASSERT_EQ(order.size(), 4);
+    auto pos = [&order](const std::string &path) {
+        return std::find(order.begin(), order.end(), path) - order.begin();
+    };
+    EXPECT_LT(pos("/mnt/hmdfs/100/account/cloud/a b/c"), pos("/mnt/hmdfs/100/account/cloud"));
+    EXPECT_LT(pos("/mnt/hmdfs/100/account/cloud"), pos("/mnt/hmdfs/100/account"));
+    EXPECT_EQ(pos("/mnt/hmdfs/101/account"), static_cast<long>(order.size()));
+    planner.ReportTimeline();
+    GTEST_LOG_(INFO) << "UmountPlannerTest_RunPhase_001 end";
+}
+
+/**
+ * @tc.name: UmountPlannerTest_RunPhase_002
+ * @tc.desc: Verify that busy mounts are retried and mounts still busy are reported.
+ * @tc.type: FUNC
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(UmountPlannerTest, UmountPlannerTest_RunPhase_002, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "UmountPlannerTest_RunPhase_002 start";
+    UmountPlanner planner("test");
+    planner.Parse(TEST_MOUNTINFO);
+    std::mutex mutex;
+    std::map<std::string, int> calls;
+    planner.SetUmountFunc([&mutex, &calls](const std::string &path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        int call = ++calls[path];
+        if (path == "/mnt/hmdfs/100/non_account" || (path == "/mnt/hmdfs/100/account" && call == 1)) {
+            errno = EBUSY;
+            return -1;
+        }
+        return 0;
+    });
+    std::list<std::string> failList;
+    EXPECT_EQ(planner.RunPhase("hmdfs", IsUser100Hmdfs, failList), EBUSY);
+    ASSERT_EQ(failList.size(), 1);
+    EXPECT_EQ(failList.front(), "/mnt/hmdfs/100/non_account");
+    EXPECT_EQ(calls["/mnt/hmdfs/100/account"], 2);
+    EXPECT_EQ(calls["/mnt/hmdfs/100/non_account"], 4);
+    GTEST_LOG_(INFO) << "UmountPlannerTest_RunPhase_002 end";
+}
+} // STORAGE_DAEMON
+} // OHOS
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/umount_planner.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mount.h>
+#include <thread>
+#include <unistd.h>
+
+#include "storage_service_errno.h"
+#include "storage_service_log.h"
+#include "utils/file_utils.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+namespace {
+constexpr size_t MAX_UMOUNT_THREADS = 4;
+// busy mounts are retried after 10, 20 and 40 ms
+constexpr int32_t UMOUNT_BUSY_RETRY = 3;
+constexpr useconds_t UMOUNT_BUSY_BACKOFF_US = 10 * 1000;
+constexpr size_t READ_BUF_SIZE = 4096;
+constexpr size_t MOUNTINFO_ID = 0;
+constexpr size_t MOUNTINFO_PARENT_ID = 1;
+constexpr size_t MOUNTINFO_MOUNT_POINT = 4;
+// optional fields of variable count follow, they end with a single "-"
+constexpr size_t MOUNTINFO_OPTIONAL = 6;
+constexpr int OCTAL_ESCAPE_LEN = 4;
+constexpr int OCTAL_BASE = 8;
+
+int64_t SteadyNowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// the kernel escapes space, tab, newline and backslash as \ooo
+std::string Unescape(const std::string &field)
+{
+    std::string out;
+    out.reserve(field.size());
+    for (size_t i = 0; i < field.size(); i++) {
+        if (field[i] == '\\' && i + OCTAL_ESCAPE_LEN <= field.size() &&
+            std::all_of(field.begin() + i + 1, field.begin() + i + OCTAL_ESCAPE_LEN,
+                [](char c) { return c >= '0' && c <= '7'; })) {
+            int value = 0;
+            for (int j = 1; j < OCTAL_ESCAPE_LEN; j++) {
+                value = value * OCTAL_BASE + (field[i + j] - '0');
+            }
+            out.push_back(static_cast<char>(value));
+            i += OCTAL_ESCAPE_LEN - 1;
+            continue;
+        }
+        out.push_back(field[i]);
+    }
+    return out;
+}
+
+void SplitFields(const std::string &line, std::vector<std::string> &fields)
+{
+    fields.clear();
+    size_t pos = 0;
+    while (pos < line.size()) {
+        size_t end = line.find(' ', pos);
+        if (end == std::string::npos) {
+            end = line.size();
+        }
+        if (end > pos) {
+            fields.emplace_back(line, pos, end - pos);
+        }
+        pos = end + 1;
+    }
+}
+} // namespace
+
+UmountPlanner::UmountPlanner(const std::string &tag)
+    : tag_(tag), createMs_(SteadyNowMs()), umount_([](const std::string &path) { return UMount(path); })
+{
+}
+
+int32_t UmountPlanner::Load(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("unable to open %{public}s, errno is %{public}d", path.c_str(), errno);
+        return -errno;
+    }
+    std::string content;
+    char buf[READ_BUF_SIZE];
+    ssize_t len;
+    while ((len = TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf)))) > 0) {
+        content.append(buf, static_cast<size_t>(len));
+    }
+    close(fd);
+    Parse(content);
+    return E_OK;
+}
+
+void UmountPlanner::Parse(const std::string &content)
+{
+    mounts_.clear();
+    index_.clear();
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    while (pos < content.size()) {
+        size_t end = content.find('\n', pos);
+        if (end == std::string::npos) {
+            end = content.size();
+        }
+        SplitFields(content.substr(pos, end - pos), fields);
+        pos = end + 1;
+        auto sep = fields.size() > MOUNTINFO_OPTIONAL ?
+            std::find(fields.begin() + MOUNTINFO_OPTIONAL, fields.end(), "-") : fields.end();
+        if (sep == fields.end() || fields.end() - sep < 3) {
+            continue;
+        }
+        MountInfoEntry entry;
+        entry.id = static_cast<int32_t>(std::strtol(fields[MOUNTINFO_ID].c_str(), nullptr, 10));
+        entry.parentId = static_cast<int32_t>(std::strtol(fields[MOUNTINFO_PARENT_ID].c_str(), nullptr, 10));
+        entry.mountPoint = Unescape(fields[MOUNTINFO_MOUNT_POINT]);
+        entry.fsType = *(sep + 1);
+        entry.source = Unescape(*(sep + 2));
+        index_[entry.id] = mounts_.size();
+        mounts_.push_back(std::move(entry));
+    }
+}
+
+int32_t UmountPlanner::RunPhase(const std::string &name, const Filter &filter, std::list<std::string> &failList)
+{
+    PhaseRecord record = { name, 0, 0, SteadyNowMs(), 0 };
+    std::vector<size_t> selected;
+    std::unordered_map<int32_t, size_t> selectedIndex;
+    for (size_t i = 0; i < mounts_.size(); i++) {
+        if (filter(mounts_[i])) {
+            selectedIndex[mounts_[i].id] = selected.size();
+            selected.push_back(i);
+        }
+    }
+    record.total = selected.size();
+
+    // a selected mount waits for the selected mounts whose nearest selected ancestor it is
+    std::vector<int64_t> waiter(selected.size(), -1);
+    std::vector<size_t> pending(selected.size(), 0);
+    for (size_t k = 0; k < selected.size(); k++) {
+        const MountInfoEntry *entry = &mounts_[selected[k]];
+        for (size_t depth = 0; depth < mounts_.size() && entry->parentId != entry->id; depth++) {
+            auto sel = selectedIndex.find(entry->parentId);
+            if (sel != selectedIndex.end()) {
+                waiter[k] = static_cast<int64_t>(sel->second);
+                pending[sel->second]++;
+                break;
+            }
+            auto it = index_.find(entry->parentId);
+            if (it == index_.end()) {
+                break;
+            }
+            entry = &mounts_[it->second];
+        }
+    }
+    std::deque<size_t> ready;
+    for (size_t k = 0; k < selected.size(); k++) {
+        if (pending[k] == 0) {
+            ready.push_back(k);
+        }
+    }
+    // the most recent mounts go first, like the mount table read backwards
+    std::sort(ready.begin(), ready.end(), [this, &selected](size_t a, size_t b) {
+        return mounts_[selected[a]].id > mounts_[selected[b]].id;
+    });
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    size_t done = 0;
+    int32_t result = E_OK;
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            cond.wait(lock, [&] { return !ready.empty() || done == selected.size(); });
+            if (ready.empty()) {
+                return;
+            }
+            size_t k = ready.front();
+            ready.pop_front();
+            const std::string &path = mounts_[selected[k]].mountPoint;
+            lock.unlock();
+            int32_t ret = UmountWithRetry(path);
+            lock.lock();
+            if (ret != E_OK) {
+                result = ret;
+                record.failed++;
+                failList.push_back(path);
+            }
+            done++;
+            if (waiter[k] >= 0 && --pending[waiter[k]] == 0) {
+                ready.push_back(static_cast<size_t>(waiter[k]));
+            }
+            cond.notify_all();
+        }
+    };
+    size_t threadCnt = std::min(MAX_UMOUNT_THREADS, selected.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCnt; i++) {
+        threads.emplace_back(worker);
+    }
+    if (threadCnt > 0) {
+        worker();
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    record.endMs = SteadyNowMs();
+    LOGI("%{public}s unmount %{public}s, total %{public}zu, failed %{public}zu, result %{public}d", tag_.c_str(),
+        name.c_str(), record.total, record.failed, result);
+    timeline_.push_back(record);
+    return result;
+}
+
+int32_t UmountPlanner::UmountWithRetry(const std::string &path)
+{
+    for (int32_t i = 0;; i++) {
+        if (umount_(path) == 0) {
+            return E_OK;
+        }
+        int32_t err = errno;
+        if (err != EBUSY || i >= UMOUNT_BUSY_RETRY) {
+            LOGE("failed to unmount path %{public}s, errno %{public}d.", path.c_str(), err);
+            return err;
+        }
+        usleep(UMOUNT_BUSY_BACKOFF_US << i);
+    }
+}
+
+void UmountPlanner::Detach(const std::list<std::string> &paths)
+{
+    PhaseRecord record = { "detach", paths.size(), 0, SteadyNowMs(), 0 };
+    for (const auto &path : paths) {
+        if (UMount2(path, MNT_DETACH) != E_OK) {
+            LOGE("failed to unmount with detach, path %{public}s, errno %{public}d.", path.c_str(), errno);
+            record.failed++;
+        }
+    }
+    record.endMs = SteadyNowMs();
+    timeline_.push_back(record);
+}
+
+void UmountPlanner::ReportTimeline() const
+{
+    int64_t now = SteadyNowMs();
+    LOGI("%{public}s unmount timeline, %{public}zu mounts parsed, total %{public}lld ms", tag_.c_str(),
+        mounts_.size(), static_cast<long long>(now - createMs_));
+    for (const auto &record : timeline_) {
+        LOGI("  %{public}s: %{public}zu mounts, %{public}zu failed, at +%{public}lld ms, took %{public}lld ms",
+            record.name.c_str(), record.total, record.failed, static_cast<long long>(record.startMs - createMs_),
+            static_cast<long long>(record.endMs - record.startMs));
+    }
+}
+} // StorageDaemon
+} // OHOS
@@ -31,6 +31,8 @@
 #include "common_event_support.h"
 #include "iservice_registry.h"
 #include "os_account_manager.h"
+#include "storage/storage_monitor_service.h"
+#include "storage/storage_stats_cache.h"
 #include "storage_daemon_communication/storage_daemon_communication.h"
 #include "storage_service_log.h"
 #include "system_ability_definition.h"
@@ -41,6 +43,7 @@ using namespace OHOS::AccountSA;
 namespace OHOS {
 namespace StorageManager {
 static constexpr int CONNECT_TIME = 10;
+static const std::string PACKAGE_EVENT_USER_ID = "userId";
 static std::mutex userRecordLock;
 std::shared_ptr<DataShare::DataShareHelper> AccountSubscriber::mediaShare_ = nullptr;
 
@@ -56,6 +59,11 @@ void AccountSubscriber::Subscriber(void)
         matchingSkills.AddEvent(EventFwk::CommonEventSupport::COMMON_EVENT_USER_UNLOCKED);
         matchingSkills.AddEvent(EventFwk::CommonEventSupport::COMMON_EVENT_USER_SWITCHED);
         matchingSkills.AddEvent(EventFwk::CommonEventSupport::COMMON_EVENT_SCREEN_LOCKED);
+        matchingSkills.AddEvent(EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_ADDED);
+        matchingSkills.AddEvent(EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_CHANGED);
+        matchingSkills.AddEvent(EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_REMOVED);
+        matchingSkills.AddEvent(EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_DATA_CLEARED);
+        matchingSkills.AddEvent(EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_CACHE_CLEARED);
         EventFwk::CommonEventSubscribeInfo subscribeInfo(matchingSkills);
         accountSubscriber_ = std::make_shared<AccountSubscriber>(subscribeInfo);
         EventFwk::CommonEventManager::SubscribeCommonEvent(accountSubscriber_);
@@ -100,10 +108,39 @@ void AccountSubscriber::ResetUserEventRecord(int32_t userId)
     }
 }
 
+static bool IsPackageEvent(const std::string &action)
+{
+    return action == EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_ADDED ||
+        action == EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_CHANGED ||
+        action == EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_REMOVED ||
+        action == EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_DATA_CLEARED ||
+        action == EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_CACHE_CLEARED;
+}
+
+void AccountSubscriber::HandlePackageEvent(const AAFwk::Want &want)
+{
+    std::string action = want.GetAction();
+    if (action == EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_ADDED ||
+        action == EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_CHANGED) {
+        DelayedSingleton<StorageMonitorService>::GetInstance()->OnWriteHeavyEvent();
+    }
+    auto statsCache = DelayedSingleton<StorageStatsCache>::GetInstance();
+    int32_t userId = want.GetIntParam(PACKAGE_EVENT_USER_ID, -1);
+    if (userId < 0) {
+        statsCache->InvalidateAll(STATS_APP_MASK);
+        return;
+    }
+    statsCache->Invalidate(userId, STATS_APP_MASK);
+}
+
 void AccountSubscriber::OnReceiveEvent(const EventFwk::CommonEventData &eventData)
 {
     const AAFwk::Want& want = eventData.GetWant();
     std::string action = want.GetAction();
+    if (IsPackageEvent(action)) {
+        HandlePackageEvent(want);
+        return;
+    }
     int32_t userId = eventData.GetCode();
     std::unique_lock<std::mutex> lock(mutex_);
     /* get user status */
@@ -113,6 +150,7 @@ void AccountSubscriber::OnReceiveEvent(const EventFwk::CommonEventData &eventDat
         status = HandleUserUnlockEvent(status);
     } else if (action == EventFwk::CommonEventSupport::COMMON_EVENT_USER_SWITCHED) {
         status = HandleUserSwitchedEvent(status);
+        DelayedSingleton<StorageStatsCache>::GetInstance()->Invalidate(userId, STATS_ALL_MASK);
     } else if (action == EventFwk::CommonEventSupport::COMMON_EVENT_SCREEN_LOCKED) {
         HandleScreenLockedEvent(userId);
         return;
@@ -56,6 +56,7 @@ private:
     uint32_t HandleUserUnlockEvent(uint32_t userStatus);
     uint32_t HandleUserSwitchedEvent(uint32_t userStatus);
     void HandleScreenLockedEvent(int32_t &userId);
+    void HandlePackageEvent(const AAFwk::Want &want);
     bool OnReceiveEventLockUserScreen(int32_t userId);
     void GetSystemAbility();
 };
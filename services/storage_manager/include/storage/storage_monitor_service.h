@@ -26,24 +26,54 @@
 namespace OHOS {
 namespace StorageManager {
 const int SMART_EVENT_INTERVAL = 24; // 24h
+enum ReclaimLevel {
+    RECLAIM_NONE = 0,
+    RECLAIM_SOFT,
+    RECLAIM_HARD,
+    RECLAIM_CRITICAL,
+};
 class StorageMonitorService : public NoCopyable  {
     DECLARE_DELAYED_SINGLETON(StorageMonitorService);
 
 public:
     void StartStorageMonitorTask();
+    /**
+     * @brief Pull the next free space check forward after an event that may consume a lot of space at once,
+     * such as a package install or a large file creation.
+     */
+    void OnWriteHeavyEvent();
 
 private:
     void StartEventHandler();
     void Execute();
+    void ScheduleNextCheck(int64_t delayMs, bool onlyIfEarlier);
+    int64_t GetNextCheckInterval();
+    bool GetCachedTotalSize(int64_t &totalSize);
+    void UpdateConsumeRate(int64_t freeSize);
     void CheckAndCleanBundleCache();
+    ReclaimLevel GetReclaimLevel(int64_t freeSize, int64_t lowThreshold);
+    int64_t GetReclaimSize(ReclaimLevel level, int64_t freeSize, int64_t lowThreshold);
+    void ReclaimBundleCache(ReclaimLevel level, int64_t freeSize, int64_t lowThreshold);
+    void UpdateReclaimBackoff(int64_t reclaimedSize);
     int64_t GetLowerThreshold(int64_t totalSize);
     void CheckAndEventNotify(int64_t freeSize, int64_t totalSize);
     void SendSmartNotificationEvent(const std::string &faultId);
 
-    std::mutex eventMutex_;
     std::thread eventThread_;
+    // guards eventHandler_ and nextCheckTime_
+    std::mutex scheduleMutex_;
     std::condition_variable eventCon_;
     std::shared_ptr<AppExecFwk::EventHandler> eventHandler_ = nullptr;
+    std::chrono::steady_clock::time_point nextCheckTime_;
+    // the following are only touched on the event handler thread
+    int64_t totalSize_ = 0;
+    int64_t lastFreeSize_ = -1;
+    std::chrono::steady_clock::time_point lastSampleTime_;
+    double consumeRate_ = 0; // bytes per second, smoothed
+    uint32_t reclaimFailCount_ = 0;
+    std::chrono::steady_clock::time_point reclaimBackoffEnd_;
+    int64_t lastReclaimedSize_ = 0;
+    int64_t totalReclaimedSize_ = 0;
     std::chrono::steady_clock::time_point lastNotificationTime_ =
             std::chrono::time_point_cast<std::chrono::steady_clock::duration>(
                     std::chrono::steady_clock::now()) - std::chrono::hours(SMART_EVENT_INTERVAL);
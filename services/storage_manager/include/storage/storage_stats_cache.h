@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_STORAGE_MANAGER_STORAGE_STATS_CACHE_H
+#define OHOS_STORAGE_MANAGER_STORAGE_STATS_CACHE_H
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <nocopyable.h>
+#include <singleton.h>
+#include <unordered_map>
+#include "storage_stats.h"
+
+namespace OHOS {
+namespace StorageManager {
+enum StatsComponent : uint32_t {
+    STATS_TOTAL = 0,
+    STATS_APP,
+    STATS_MEDIA,
+    STATS_FILE,
+    STATS_COMPONENT_NUM
+};
+
+constexpr uint32_t STATS_TOTAL_MASK = 1U << STATS_TOTAL;
+constexpr uint32_t STATS_APP_MASK = 1U << STATS_APP;
+constexpr uint32_t STATS_MEDIA_MASK = 1U << STATS_MEDIA;
+constexpr uint32_t STATS_FILE_MASK = 1U << STATS_FILE;
+constexpr uint32_t STATS_ALL_MASK = (1U << STATS_COMPONENT_NUM) - 1;
+
+/**
+ * In-memory cache of the user storage stats, each component has its own freshness.
+ *
+ * A component is served from memory until its time to live expires or an event invalidates it. A component of a
+ * user computed before it was invalidated is dropped by Update so a slow refresh never overwrites newer state, the
+ * other components and users are kept.
+ */
+class StorageStatsCache : public NoCopyable {
+    DECLARE_DELAYED_SINGLETON(StorageStatsCache);
+
+public:
+    /**
+     * @brief Fill the fresh components of a user into storageStats.
+     * @param epoch Out, the current invalidation epoch to pass back to Update.
+     * @return The mask of the components that have to be refreshed.
+     */
+    uint32_t Lookup(int32_t userId, StorageStats &storageStats, uint64_t &epoch);
+    uint64_t GetEpoch();
+    void Update(int32_t userId, uint32_t mask, const StorageStats &storageStats, uint64_t epoch);
+    void Invalidate(int32_t userId, uint32_t mask);
+    void InvalidateAll(uint32_t mask);
+    static void CopyComponent(uint32_t component, const StorageStats &from, StorageStats &to);
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct UserStatsEntry {
+        StorageStats stats;
+        uint32_t validMask = 0;
+        Clock::time_point updateTime[STATS_COMPONENT_NUM];
+    };
+
+    bool IsInvalidatedSince(int32_t userId, uint32_t component, uint64_t epoch) const;
+
+    std::mutex mutex_;
+    uint64_t epoch_ = 0;
+    // the epoch of the last invalidation per component, of all users and of each user
+    std::array<uint64_t, STATS_COMPONENT_NUM> allInvalidEpoch_ {};
+    std::unordered_map<int32_t, std::array<uint64_t, STATS_COMPONENT_NUM>> invalidEpoch_;
+    std::unordered_map<int32_t, UserStatsEntry> entries_;
+};
+} // StorageManager
+} // OHOS
+
+#endif // OHOS_STORAGE_MANAGER_STORAGE_STATS_CACHE_H
@@ -16,6 +16,10 @@
 #ifndef OHOS_STORAGE_MANAGER_STORAGE_STATUS_SERVICE_H
 #define OHOS_STORAGE_MANAGER_STORAGE_STATUS_SERVICE_H
 
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <nocopyable.h>
 #include <singleton.h>
@@ -23,6 +27,7 @@
 #include "bundle_stats.h"
 #include "storage_stats.h"
 #include "iremote_object.h"
+#include "thread_pool.h"
 
 namespace OHOS {
 namespace StorageManager {
@@ -44,6 +49,20 @@ private:
     int GetCurrentUserId();
     std::string GetCallingPkgName();
     int32_t GetAppSize(int32_t userId, int64_t &size);
+    int32_t GetActiveUsersFileStats(int32_t userId, StorageStats &storageStats);
+    int32_t GetStatsComponent(int32_t userId, uint32_t component, StorageStats &storageStats);
+    struct StatsComponentTask {
+        std::shared_ptr<StorageStats> stats;
+        std::shared_future<int32_t> result;
+    };
+    StatsComponentTask GetStatsComponentTask(int32_t userId, uint32_t component);
+    int32_t RefreshUserStorageStats(int32_t userId, uint32_t staleMask, StorageStats &storageStats,
+        uint32_t &refreshedMask);
+    std::mutex statsRefreshMutex_;
+    // the components in flight per user, a component that hangs occupies one pool thread and is not started twice
+    std::mutex statsTaskMutex_;
+    std::map<std::pair<int32_t, uint32_t>, StatsComponentTask> statsTasks_;
+    OHOS::ThreadPool statsPool_;
     const std::vector<std::string> dataDir = {"app", "local", "distributed", "database", "cache"};
     const int DEFAULT_USER_ID = 100;
     const int DEFAULT_APP_INDEX = 0;
@@ -18,6 +18,7 @@
 #include <singleton.h>
 #ifdef STORAGE_STATISTICS_MANAGER
 #include <storage/storage_monitor_service.h>
+#include <storage/storage_stats_cache.h>
 #include <storage/storage_status_service.h>
 #include <storage/storage_total_status_service.h>
 #include <storage/volume_storage_status_service.h>
@@ -106,6 +107,9 @@ int32_t StorageManager::StopUser(int32_t userId)
     if (err != E_USERID_RANGE) {
         ResetUserEventRecord(userId);
     }
+#ifdef STORAGE_STATISTICS_MANAGER
+    DelayedSingleton<StorageStatsCache>::GetInstance()->Invalidate(userId, STATS_ALL_MASK);
+#endif
     return err;
 }
 
@@ -239,6 +243,9 @@ int32_t StorageManager::NotifyVolumeMounted(std::string volumeId, int32_t fsType
     LOGI("StorageManger::NotifyVolumeMounted start");
     DelayedSingleton<VolumeManagerService>::GetInstance()->OnVolumeMounted(volumeId, fsType, fsUuid, path, description);
 #endif
+#ifdef STORAGE_STATISTICS_MANAGER
+    DelayedSingleton<StorageStatsCache>::GetInstance()->InvalidateAll(STATS_TOTAL_MASK | STATS_MEDIA_MASK);
+#endif
 
     return E_OK;
 }
@@ -249,6 +256,9 @@ int32_t StorageManager::NotifyVolumeStateChanged(std::string volumeId, VolumeSta
     LOGI("StorageManger::NotifyVolumeStateChanged start");
     DelayedSingleton<VolumeManagerService>::GetInstance()->OnVolumeStateChanged(volumeId, state);
 #endif
+#ifdef STORAGE_STATISTICS_MANAGER
+    DelayedSingleton<StorageStatsCache>::GetInstance()->InvalidateAll(STATS_TOTAL_MASK | STATS_MEDIA_MASK);
+#endif
 
     return E_OK;
 }
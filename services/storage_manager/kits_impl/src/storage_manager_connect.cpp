@@ -355,6 +355,7 @@ int32_t Convert2JsErrNum(int32_t errNum)
         { E_DEATH_RECIPIENT_IS_NULLPTR, E_IPCSS},
         { E_BUNDLEMGR_ERROR, E_IPCSS},
         { E_MEDIALIBRARY_ERROR, E_IPCSS},
+        { E_TIMEOUT, E_IPCSS},
     };
 
     if (errCodeTable.find(errNum) != errCodeTable.end()) {
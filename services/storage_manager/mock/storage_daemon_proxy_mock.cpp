@@ -202,6 +202,13 @@ int32_t StorageDaemonProxy::GetOccupiedSpace(int32_t idType, int32_t id, int64_t
     return E_OK;
 }
 
+int32_t StorageDaemonProxy::GetOccupiedSpaceBatch(int32_t idType, std::vector<int32_t> &ids,
+    std::vector<int64_t> &sizes)
+{
+    sizes.assign(ids.size(), 0);
+    return E_OK;
+}
+
 int32_t StorageDaemonProxy::GetBundleStatsForIncrease(uint32_t userId, const std::vector<std::string> &bundleNames,
     const std::vector<int64_t> &incrementalBackTimes, std::vector<int64_t> &pkgFileSizes,
     std::vector<int64_t> &incPkgFileSizes)
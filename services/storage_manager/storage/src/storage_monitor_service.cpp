@@ -15,6 +15,7 @@
 
 #include "storage/storage_monitor_service.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <mntent.h>
@@ -36,9 +37,22 @@ namespace OHOS {
 namespace StorageManager {
 constexpr int32_t CONST_NUM_TWO = 2;
 constexpr int32_t CONST_NUM_THREE = 3;
+constexpr int32_t CONST_NUM_FOUR = 4;
 constexpr int32_t CONST_NUM_ONE_HUNDRED = 100;
 constexpr int32_t WAIT_THREAD_TIMEOUT_MS = 5;
 constexpr int32_t DEFAULT_CHECK_INTERVAL = 60 * 1000; // 60s
+constexpr int64_t MIN_CHECK_INTERVAL = 5 * 1000; // 5s
+constexpr int64_t MAX_CHECK_INTERVAL = 5 * 60 * 1000; // 5min
+constexpr int64_t MS_PER_SECOND = 1000;
+// weight of the newest sample in the smoothed consumption rate
+constexpr double CONSUME_RATE_WEIGHT = 0.5;
+const std::string MONITOR_TASK_NAME = "storage_monitor_check";
+// while a reclamation makes progress, keep reclaiming in small steps at this pace
+constexpr int64_t RECLAIM_CHECK_INTERVAL = 10 * 1000; // 10s
+constexpr int64_t RECLAIM_MIN_STEP = 16 * 1024 * 1024; // 16M
+constexpr int64_t RECLAIM_MIN_FREED = 1024 * 1024; // 1M
+constexpr int64_t RECLAIM_MAX_BACKOFF = 30 * 60 * 1000; // 30min
+constexpr uint32_t RECLAIM_MAX_BACKOFF_SHIFT = 5;
 constexpr int32_t STORAGE_THRESHOLD_PERCENTAGE = 5; // 5%
 constexpr int64_t STORAGE_THRESHOLD_MAX_BYTES = 500 * 1024 * 1024; // 500M
 constexpr int64_t STORAGE_THRESHOLD_1G = 1000 * 1024 * 1024; // 1G
@@ -55,21 +69,26 @@ StorageMonitorService::StorageMonitorService() {}
 StorageMonitorService::~StorageMonitorService()
 {
     LOGI("StorageMonitorService Destructor.");
-    std::unique_lock<std::mutex> lock(eventMutex_);
-    if ((eventHandler_ != nullptr) && (eventHandler_->GetEventRunner() != nullptr)) {
-        eventHandler_->RemoveAllEvents();
-        eventHandler_->GetEventRunner()->Stop();
+    std::shared_ptr<AppExecFwk::EventHandler> eventHandler;
+    {
+        // a check still running on the event thread schedules nothing once the handler is gone
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
+        eventHandler = eventHandler_;
+        eventHandler_ = nullptr;
+    }
+    if ((eventHandler != nullptr) && (eventHandler->GetEventRunner() != nullptr)) {
+        eventHandler->RemoveAllEvents();
+        eventHandler->GetEventRunner()->Stop();
     }
     if (eventThread_.joinable()) {
         eventThread_.join();
     }
-    eventHandler_ = nullptr;
 }
 
 void StorageMonitorService::StartStorageMonitorTask()
 {
     LOGI("StorageMonitorService, start deicve storage monitor task.");
-    std::unique_lock<std::mutex> lock(eventMutex_);
+    std::unique_lock<std::mutex> lock(scheduleMutex_);
     if (eventHandler_ == nullptr) {
         eventThread_ = std::thread(&StorageMonitorService::StartEventHandler, this);
         eventCon_.wait_for(lock, std::chrono::seconds(WAIT_THREAD_TIMEOUT_MS), [this] {
@@ -77,8 +96,30 @@ void StorageMonitorService::StartStorageMonitorTask()
         });
     }
 
+    lock.unlock();
+    ScheduleNextCheck(DEFAULT_CHECK_INTERVAL, false);
+}
+
+void StorageMonitorService::OnWriteHeavyEvent()
+{
+    ScheduleNextCheck(MIN_CHECK_INTERVAL, true);
+}
+
+void StorageMonitorService::ScheduleNextCheck(int64_t delayMs, bool onlyIfEarlier)
+{
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
+    if (eventHandler_ == nullptr) {
+        LOGE("event handler is nullptr.");
+        return;
+    }
+    auto checkTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+    if (onlyIfEarlier && checkTime >= nextCheckTime_) {
+        return;
+    }
+    eventHandler_->RemoveTask(MONITOR_TASK_NAME);
     auto executeFunc = [this] { Execute(); };
-    eventHandler_->PostTask(executeFunc, DEFAULT_CHECK_INTERVAL);
+    eventHandler_->PostTask(executeFunc, MONITOR_TASK_NAME, delayMs);
+    nextCheckTime_ = checkTime;
 }
 
 void StorageMonitorService::StartEventHandler()
@@ -90,7 +131,7 @@ void StorageMonitorService::StartEventHandler()
         return;
     }
     {
-        std::lock_guard<std::mutex> lock(eventMutex_);
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
         eventHandler_ = std::make_shared<AppExecFwk::EventHandler>(runner);
     }
     eventCon_.notify_one();
@@ -99,30 +140,85 @@ void StorageMonitorService::StartEventHandler()
 
 void StorageMonitorService::Execute()
 {
-    if (eventHandler_ == nullptr) {
-        LOGE("event handler is nullptr.");
-        return;
+    {
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
+        if (eventHandler_ == nullptr) {
+            LOGE("event handler is nullptr.");
+            return;
+        }
     }
     CheckAndCleanBundleCache();
-    auto executeFunc = [this] { Execute(); };
-    eventHandler_->PostTask(executeFunc, DEFAULT_CHECK_INTERVAL);
+    ScheduleNextCheck(GetNextCheckInterval(), false);
 }
 
-void StorageMonitorService::CheckAndCleanBundleCache()
+bool StorageMonitorService::GetCachedTotalSize(int64_t &totalSize)
 {
-    int64_t totalSize;
+    if (totalSize_ > 0) {
+        totalSize = totalSize_;
+        return true;
+    }
     int32_t err = DelayedSingleton<StorageTotalStatusService>::GetInstance()->GetTotalSize(totalSize);
     if ((err != E_OK) || (totalSize <= 0)) {
         LOGE("Get device total size failed.");
+        return false;
+    }
+    totalSize_ = totalSize;
+    return true;
+}
+
+void StorageMonitorService::UpdateConsumeRate(int64_t freeSize)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (lastFreeSize_ >= 0) {
+        int64_t elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastSampleTime_).count();
+        if (elapsedMs > 0) {
+            // space given back (deletes, cache cleaning) counts as no consumption
+            double rate = static_cast<double>(std::max<int64_t>(lastFreeSize_ - freeSize, 0)) * MS_PER_SECOND /
+                elapsedMs;
+            consumeRate_ = CONSUME_RATE_WEIGHT * rate + (1 - CONSUME_RATE_WEIGHT) * consumeRate_;
+        }
+    }
+    lastFreeSize_ = freeSize;
+    lastSampleTime_ = now;
+}
+
+int64_t StorageMonitorService::GetNextCheckInterval()
+{
+    int64_t totalSize = 0;
+    if (lastFreeSize_ < 0 || !GetCachedTotalSize(totalSize)) {
+        return DEFAULT_CHECK_INTERVAL;
+    }
+    int64_t cleanThreshold = (GetLowerThreshold(totalSize) * CONST_NUM_THREE) / CONST_NUM_TWO;
+    int64_t distance = lastFreeSize_ - cleanThreshold;
+    if (distance <= 0) {
+        // below the soft watermark, continue reclaiming while the passes free something
+        return (reclaimFailCount_ == 0 && lastReclaimedSize_ > 0) ? RECLAIM_CHECK_INTERVAL : DEFAULT_CHECK_INTERVAL;
+    }
+    if (consumeRate_ * MAX_CHECK_INTERVAL / MS_PER_SECOND < distance) {
+        return MAX_CHECK_INTERVAL;
+    }
+    // check again when half of the remaining distance is expected to be consumed
+    auto interval = static_cast<int64_t>(distance / consumeRate_ * MS_PER_SECOND / CONST_NUM_TWO);
+    interval = std::clamp(interval, MIN_CHECK_INTERVAL, MAX_CHECK_INTERVAL);
+    LOGI("freeSize=%{public}lld, consume rate=%{public}lld B/s, next check in %{public}lld ms",
+        static_cast<long long>(lastFreeSize_), static_cast<long long>(consumeRate_), static_cast<long long>(interval));
+    return interval;
+}
+
+void StorageMonitorService::CheckAndCleanBundleCache()
+{
+    int64_t totalSize;
+    if (!GetCachedTotalSize(totalSize)) {
         return;
     }
 
     int64_t freeSize;
-    err = DelayedSingleton<StorageTotalStatusService>::GetInstance()->GetFreeSize(freeSize);
+    int32_t err = DelayedSingleton<StorageTotalStatusService>::GetInstance()->GetFreeSize(freeSize);
     if ((err != E_OK) || (freeSize <= 0)) {
         LOGE("Get device free size failed.");
         return;
     }
+    UpdateConsumeRate(freeSize);
     if (freeSize < (totalSize * STORAGE_LEFT_SIZE_THRESHOLD) / CONST_NUM_ONE_HUNDRED) {
         CheckAndEventNotify(freeSize, totalSize);
     }
@@ -134,21 +230,97 @@ void StorageMonitorService::CheckAndCleanBundleCache()
 
     LOGI("Device storage freeSize=%{public}lld, threshold=%{public}lld", static_cast<long long>(freeSize),
         static_cast<long long>(lowThreshold));
-    if (freeSize >= (lowThreshold * CONST_NUM_THREE) / CONST_NUM_TWO) {
+    ReclaimLevel level = GetReclaimLevel(freeSize, lowThreshold);
+    if (level == RECLAIM_NONE) {
         LOGI("The cache clean threshold had not been reached, skip this clean task.");
+        lastReclaimedSize_ = 0;
+        reclaimFailCount_ = 0;
+        return;
+    }
+    if (std::chrono::steady_clock::now() < reclaimBackoffEnd_) {
+        LOGI("Recent clean passes freed nothing, back off, fail count %{public}u.", reclaimFailCount_);
         return;
     }
+    ReclaimBundleCache(level, freeSize, lowThreshold);
+}
+
+ReclaimLevel StorageMonitorService::GetReclaimLevel(int64_t freeSize, int64_t lowThreshold)
+{
+    if (freeSize < lowThreshold / CONST_NUM_TWO) {
+        return RECLAIM_CRITICAL;
+    }
+    if (freeSize < lowThreshold) {
+        return RECLAIM_HARD;
+    }
+    if (freeSize < (lowThreshold * CONST_NUM_THREE) / CONST_NUM_TWO) {
+        return RECLAIM_SOFT;
+    }
+    return RECLAIM_NONE;
+}
+
+int64_t StorageMonitorService::GetReclaimSize(ReclaimLevel level, int64_t freeSize, int64_t lowThreshold)
+{
+    // refill up to the soft watermark, soft and hard passes are capped at half of the largest deficit of
+    // their level so they refill in steps, a critical pass refills the whole deficit at once
+    int64_t deficit = (lowThreshold * CONST_NUM_THREE) / CONST_NUM_TWO - freeSize;
+    int64_t maxStep = 0;
+    switch (level) {
+        case RECLAIM_SOFT:
+            maxStep = lowThreshold / CONST_NUM_FOUR;
+            break;
+        case RECLAIM_HARD:
+            maxStep = lowThreshold / CONST_NUM_TWO;
+            break;
+        case RECLAIM_CRITICAL:
+            maxStep = deficit;
+            break;
+        default:
+            return 0;
+    }
+    return std::clamp(deficit, RECLAIM_MIN_STEP, std::max(maxStep, RECLAIM_MIN_STEP));
+}
 
+void StorageMonitorService::ReclaimBundleCache(ReclaimLevel level, int64_t freeSize, int64_t lowThreshold)
+{
     auto bundleMgr = DelayedSingleton<BundleMgrConnector>::GetInstance()->GetBundleMgrProxy();
     if (bundleMgr == nullptr) {
         LOGE("Connect bundle manager sa proxy failed.");
         return;
     }
-    LOGI("Device storage free size not enough, start clean bundle cache files automatic.");
-    auto ret = bundleMgr->CleanBundleCacheFilesAutomatic(lowThreshold * CONST_NUM_TWO);
+    int64_t reclaimSize = GetReclaimSize(level, freeSize, lowThreshold);
+    LOGI("Device storage free size not enough, level %{public}d, clean %{public}lld bytes of bundle cache.",
+        level, static_cast<long long>(reclaimSize));
+    auto startTime = std::chrono::steady_clock::now();
+    auto ret = bundleMgr->CleanBundleCacheFilesAutomatic(reclaimSize);
     if (ret != ERR_OK) {
         LOGE("Invoke bundleMgr interface to clean bundle cache files automatic failed.");
     }
+    auto costMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+        startTime).count();
+
+    int64_t newFreeSize = 0;
+    int32_t err = DelayedSingleton<StorageTotalStatusService>::GetInstance()->GetFreeSize(newFreeSize);
+    int64_t reclaimedSize = (err == E_OK) ? std::max<int64_t>(newFreeSize - freeSize, 0) : 0;
+    totalReclaimedSize_ += reclaimedSize;
+    LOGI("Clean pass freed %{public}lld bytes in %{public}lld ms, %{public}lld bytes freed in total.",
+        static_cast<long long>(reclaimedSize), static_cast<long long>(costMs),
+        static_cast<long long>(totalReclaimedSize_));
+    UpdateReclaimBackoff(reclaimedSize);
+}
+
+void StorageMonitorService::UpdateReclaimBackoff(int64_t reclaimedSize)
+{
+    lastReclaimedSize_ = reclaimedSize;
+    if (reclaimedSize >= RECLAIM_MIN_FREED) {
+        reclaimFailCount_ = 0;
+        reclaimBackoffEnd_ = std::chrono::steady_clock::time_point();
+        return;
+    }
+    // the caches are exhausted, each useless pass doubles the pause before the next one
+    reclaimFailCount_++;
+    uint32_t shift = std::min(reclaimFailCount_ - 1, RECLAIM_MAX_BACKOFF_SHIFT);
+    int64_t backoffMs = std::min(static_cast<int64_t>(DEFAULT_CHECK_INTERVAL) << shift, RECLAIM_MAX_BACKOFF);
+    reclaimBackoffEnd_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(backoffMs);
 }
 
 int64_t StorageMonitorService::GetLowerThreshold(int64_t totalSize)
@@ -206,4 +378,4 @@ void StorageMonitorService::SendSmartNotificationEvent(const std::string &faultI
     EventFwk::CommonEventManager::PublishCommonEvent(eventData, publishInfo, nullptr);
 }
 } // StorageManager
-} // OHOS
+} // OHOS
\ No newline at end of file
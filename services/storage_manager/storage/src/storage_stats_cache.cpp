@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/storage_stats_cache.h"
+
+#include "storage_service_log.h"
+
+namespace OHOS {
+namespace StorageManager {
+namespace {
+// the total size only moves with the data partition, app/media/file sizes grow with every write
+constexpr std::chrono::seconds STATS_TTL[STATS_COMPONENT_NUM] = {
+    std::chrono::seconds(300),
+    std::chrono::seconds(60),
+    std::chrono::seconds(15),
+    std::chrono::seconds(15),
+};
+} // namespace
+
+StorageStatsCache::StorageStatsCache() {}
+StorageStatsCache::~StorageStatsCache() {}
+
+void StorageStatsCache::CopyComponent(uint32_t component, const StorageStats &from, StorageStats &to)
+{
+    switch (component) {
+        case STATS_TOTAL:
+            to.total_ = from.total_;
+            break;
+        case STATS_APP:
+            to.app_ = from.app_;
+            break;
+        case STATS_MEDIA:
+            to.image_ = from.image_;
+            to.audio_ = from.audio_;
+            to.video_ = from.video_;
+            break;
+        case STATS_FILE:
+            to.file_ = from.file_;
+            break;
+        default:
+            break;
+    }
+}
+
+uint32_t StorageStatsCache::Lookup(int32_t userId, StorageStats &storageStats, uint64_t &epoch)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    epoch = epoch_;
+    auto it = entries_.find(userId);
+    if (it == entries_.end()) {
+        return STATS_ALL_MASK;
+    }
+    uint32_t staleMask = 0;
+    auto now = Clock::now();
+    const UserStatsEntry &entry = it->second;
+    for (uint32_t i = 0; i < STATS_COMPONENT_NUM; i++) {
+        uint32_t bit = 1U << i;
+        if ((entry.validMask & bit) == 0 || now - entry.updateTime[i] >= STATS_TTL[i]) {
+            staleMask |= bit;
+            continue;
+        }
+        CopyComponent(i, entry.stats, storageStats);
+    }
+    return staleMask;
+}
+
+uint64_t StorageStatsCache::GetEpoch()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return epoch_;
+}
+
+bool StorageStatsCache::IsInvalidatedSince(int32_t userId, uint32_t component, uint64_t epoch) const
+{
+    if (allInvalidEpoch_[component] > epoch) {
+        return true;
+    }
+    auto it = invalidEpoch_.find(userId);
+    return it != invalidEpoch_.end() && it->second[component] > epoch;
+}
+
+void StorageStatsCache::Update(int32_t userId, uint32_t mask, const StorageStats &storageStats, uint64_t epoch)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = Clock::now();
+    uint32_t droppedMask = 0;
+    for (uint32_t i = 0; i < STATS_COMPONENT_NUM; i++) {
+        uint32_t bit = 1U << i;
+        if ((mask & bit) == 0) {
+            continue;
+        }
+        if (IsInvalidatedSince(userId, i, epoch)) {
+            droppedMask |= bit;
+            continue;
+        }
+        UserStatsEntry &entry = entries_[userId];
+        CopyComponent(i, storageStats, entry.stats);
+        entry.updateTime[i] = now;
+        entry.validMask |= bit;
+    }
+    if (droppedMask != 0) {
+        LOGI("stats of user %{public}d invalidated during refresh, drop mask 0x%{public}x", userId, droppedMask);
+    }
+}
+
+void StorageStatsCache::Invalidate(int32_t userId, uint32_t mask)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    epoch_++;
+    auto &invalidEpoch = invalidEpoch_[userId];
+    for (uint32_t i = 0; i < STATS_COMPONENT_NUM; i++) {
+        if ((mask & (1U << i)) != 0) {
+            invalidEpoch[i] = epoch_;
+        }
+    }
+    auto it = entries_.find(userId);
+    if (it == entries_.end()) {
+        return;
+    }
+    it->second.validMask &= ~mask;
+    if (it->second.validMask == 0) {
+        entries_.erase(it);
+    }
+    LOGI("invalidate stats of user %{public}d, mask 0x%{public}x", userId, mask);
+}
+
+void StorageStatsCache::InvalidateAll(uint32_t mask)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    epoch_++;
+    for (uint32_t i = 0; i < STATS_COMPONENT_NUM; i++) {
+        if ((mask & (1U << i)) != 0) {
+            allInvalidEpoch_[i] = epoch_;
+        }
+    }
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        it->second.validMask &= ~mask;
+        if (it->second.validMask == 0) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    LOGI("invalidate stats of all users, mask 0x%{public}x", mask);
+}
+} // StorageManager
+} // OHOS
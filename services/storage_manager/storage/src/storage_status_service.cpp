@@ -14,8 +14,14 @@
  */
 
 #include "storage/storage_status_service.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+
 #include "accesstoken_kit.h"
 #include "ipc_skeleton.h"
+#include "os_account_manager.h"
 #include "hap_token_info.h"
 #include "hitrace_meter.h"
 #include "storage_daemon_communication/storage_daemon_communication.h"
@@ -23,6 +29,7 @@
 #include "storage_service_errno.h"
 #include "storage_service_log.h"
 #include "storage/bundle_manager_connector.h"
+#include "storage/storage_stats_cache.h"
 #include "storage/storage_total_status_service.h"
 #include "application_info.h"
 #include "iservice_registry.h"
@@ -52,10 +59,27 @@ const int MEDIA_TYPE_AUDIO = 3;
 const int MEDIA_TYPE_VIDEO = 2;
 const int32_t GET_DATA_SHARE_HELPER_TIMES = 5;
 #endif
+const char *STATS_COMPONENT_NAME[STATS_COMPONENT_NUM] = {
+    "GetTotalSize", "GetAppSize", "GetMediaStorageStats", "GetFileStorageStats"
+};
+// media creates the DataShare helper with up to five retries, give it the longest budget
+constexpr std::chrono::milliseconds STATS_COMPONENT_TIMEOUT[STATS_COMPONENT_NUM] = {
+    std::chrono::milliseconds(1000),
+    std::chrono::milliseconds(3000),
+    std::chrono::milliseconds(5000),
+    std::chrono::milliseconds(3000),
+};
 } // namespace
 
-StorageStatusService::StorageStatusService() {}
-StorageStatusService::~StorageStatusService() {}
+StorageStatusService::StorageStatusService() : statsPool_("StatsComponent")
+{
+    statsPool_.Start(STATS_COMPONENT_NUM);
+}
+
+StorageStatusService::~StorageStatusService()
+{
+    statsPool_.Stop();
+}
 
 #ifdef STORAGE_SERVICE_GRAPHIC
 void GetMediaTypeAndSize(const std::shared_ptr<DataShare::DataShareResultSet> &resultSet, StorageStats &storageStats)
@@ -151,6 +175,40 @@ int32_t GetFileStorageStats(int32_t userId, StorageStats &storageStats)
     return err;
 }
 
+int32_t StorageStatusService::GetActiveUsersFileStats(int32_t userId, StorageStats &storageStats)
+{
+    std::vector<int32_t> userIds;
+    int32_t ret = AccountSA::OsAccountManager::QueryActiveOsAccountIds(userIds);
+    if (ret != ERR_OK || std::find(userIds.begin(), userIds.end(), userId) == userIds.end()) {
+        return GetFileStorageStats(userId, storageStats);
+    }
+    // one batched quota query refreshes the file size of every active user, the other users are served from cache
+    auto statsCache = DelayedSingleton<StorageStatsCache>::GetInstance();
+    uint64_t epoch = statsCache->GetEpoch();
+    std::vector<int32_t> prjIds;
+    for (int32_t id : userIds) {
+        prjIds.emplace_back(id * USER_ID_BASE + UID_FILE_MANAGER);
+    }
+    std::vector<int64_t> sizes;
+    std::shared_ptr<StorageDaemonCommunication> sdCommunication;
+    sdCommunication = DelayedSingleton<StorageDaemonCommunication>::GetInstance();
+    int32_t err = sdCommunication->GetOccupiedSpaceBatch(StorageDaemon::USRID, prjIds, sizes);
+    if (err != E_OK || sizes.size() != prjIds.size()) {
+        LOGE("GetOccupiedSpaceBatch failed, err %{public}d, size %{public}zu", err, sizes.size());
+        return GetFileStorageStats(userId, storageStats);
+    }
+    for (size_t i = 0; i < userIds.size(); i++) {
+        if (userIds[i] == userId) {
+            storageStats.file_ = sizes[i];
+            continue;
+        }
+        StorageStats userStats;
+        userStats.file_ = sizes[i];
+        statsCache->Update(userIds[i], STATS_FILE_MASK, userStats, epoch);
+    }
+    return E_OK;
+}
+
 int StorageStatusService::GetCurrentUserId()
 {
     int uid = -1;
@@ -181,6 +239,18 @@ int32_t StorageStatusService::GetUserStorageStats(StorageStats &storageStats)
     return GetUserStorageStats(userId, storageStats);
 }
 
+static void RecordUserStorageStatsResult(int32_t userId, const std::string &funcName, int32_t err)
+{
+    RadarParameter parameterRes = {.orgPkg = DEFAULT_ORGPKGNAME,
+                                   .userId = userId,
+                                   .funcName = funcName,
+                                   .bizScene = BizScene::SPACE_STATISTICS,
+                                   .bizStage = BizStage::BIZ_STAGE_GET_USER_STORAGE_STATS,
+                                   .keyElxLevel = "EL1",
+                                   .errorCode = err};
+    StorageService::StorageRadar::GetInstance().RecordFuctionResult(parameterRes);
+}
+
 int32_t StorageStatusService::GetUserStorageStats(int32_t userId, StorageStats &storageStats)
 {
     bool isCeEncrypt = false;
@@ -192,67 +262,119 @@ int32_t StorageStatusService::GetUserStorageStats(int32_t userId, StorageStats &
         return ret;
     }
     HITRACE_METER_NAME(HITRACE_TAG_FILEMANAGEMENT, __PRETTY_FUNCTION__);
-    // totalSize
-    int64_t totalSize = 0;
-    int32_t err = DelayedSingleton<StorageTotalStatusService>::GetInstance()->GetTotalSize(totalSize);
-    if (err != E_OK) {
-        LOGE("StorageStatusService::GetUserStorageStats getTotalSize failed");
-        RadarParameter parameterRes = {.orgPkg = DEFAULT_ORGPKGNAME,
-                                       .userId = userId,
-                                       .funcName = "GetTotalSize",
-                                       .bizScene = BizScene::SPACE_STATISTICS,
-                                       .bizStage = BizStage::BIZ_STAGE_GET_USER_STORAGE_STATS,
-                                       .keyElxLevel = "EL1",
-                                       .errorCode = err};
-        StorageService::StorageRadar::GetInstance().RecordFuctionResult(parameterRes);
-        return err;
-    }
-    // appSize
     LOGI("StorageStatusService::GetUserStorageStats userId is %{public}d", userId);
-    int64_t appSize = 0;
-    err = GetAppSize(userId, appSize);
-    if (err != E_OK) {
-        LOGE("StorageStatusService::GetUserStorageStats getAppSize failed");
-        RadarParameter parameterRes = {.orgPkg = DEFAULT_ORGPKGNAME,
-                                       .userId = userId,
-                                       .funcName = "GetAppSize",
-                                       .bizScene = BizScene::SPACE_STATISTICS,
-                                       .bizStage = BizStage::BIZ_STAGE_GET_USER_STORAGE_STATS,
-                                       .keyElxLevel = "EL1",
-                                       .errorCode = err};
-        StorageService::StorageRadar::GetInstance().RecordFuctionResult(parameterRes);
-        return err;
+    auto statsCache = DelayedSingleton<StorageStatsCache>::GetInstance();
+    uint64_t epoch = 0;
+    uint32_t staleMask = statsCache->Lookup(userId, storageStats, epoch);
+    if (staleMask == 0) {
+        return E_OK;
+    }
+    // concurrent callers wait for the running refresh and then take its result from the cache
+    std::lock_guard<std::mutex> lock(statsRefreshMutex_);
+    staleMask = statsCache->Lookup(userId, storageStats, epoch);
+    if (staleMask == 0) {
+        return E_OK;
+    }
+    uint32_t refreshedMask = 0;
+    int32_t err = RefreshUserStorageStats(userId, staleMask, storageStats, refreshedMask);
+    statsCache->Update(userId, refreshedMask, storageStats, epoch);
+    LOGI("GetUserStorageStats stale mask 0x%{public}x, refreshed mask 0x%{public}x", staleMask, refreshedMask);
+    return err;
+}
+
+int32_t StorageStatusService::GetStatsComponent(int32_t userId, uint32_t component, StorageStats &storageStats)
+{
+    int32_t err = E_OK;
+    switch (component) {
+        case STATS_TOTAL: {
+            HITRACE_METER_NAME(HITRACE_TAG_FILEMANAGEMENT, "GetUserStorageStats.Total");
+            err = DelayedSingleton<StorageTotalStatusService>::GetInstance()->GetTotalSize(storageStats.total_);
+            break;
+        }
+        case STATS_APP: {
+            HITRACE_METER_NAME(HITRACE_TAG_FILEMANAGEMENT, "GetUserStorageStats.App");
+            err = GetAppSize(userId, storageStats.app_);
+            break;
+        }
+        case STATS_MEDIA: {
+            HITRACE_METER_NAME(HITRACE_TAG_FILEMANAGEMENT, "GetUserStorageStats.Media");
+            err = GetMediaStorageStats(storageStats);
+            break;
+        }
+        case STATS_FILE: {
+            HITRACE_METER_NAME(HITRACE_TAG_FILEMANAGEMENT, "GetUserStorageStats.File");
+            err = GetActiveUsersFileStats(userId, storageStats);
+            break;
+        }
+        default:
+            err = E_PARAMS_INVAL;
+            break;
     }
+    return err;
+}
 
-    storageStats.total_ = totalSize;
-    storageStats.app_ = appSize;
+StorageStatusService::StatsComponentTask StorageStatusService::GetStatsComponentTask(int32_t userId,
+    uint32_t component)
+{
+    std::lock_guard<std::mutex> lock(statsTaskMutex_);
+    // a component that is still running from an earlier refresh, e.g. after a timeout, is waited for again
+    auto key = std::make_pair(userId, component);
+    auto iter = statsTasks_.find(key);
+    if (iter != statsTasks_.end()) {
+        return iter->second;
+    }
+    auto stats = std::make_shared<StorageStats>();
+    auto promise = std::make_shared<std::promise<int32_t>>();
+    StatsComponentTask task = { stats, promise->get_future().share() };
+    statsTasks_[key] = task;
+    statsPool_.AddTask([this, userId, component, stats, promise]() {
+        auto startTime = std::chrono::steady_clock::now();
+        int32_t ret = GetStatsComponent(userId, component, *stats);
+        auto costMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+            startTime).count();
+        if (ret != E_OK) {
+            LOGE("GetUserStorageStats %{public}s failed, err %{public}d, cost %{public}lld ms",
+                STATS_COMPONENT_NAME[component], ret, static_cast<long long>(costMs));
+        } else {
+            LOGI("GetUserStorageStats %{public}s done, cost %{public}lld ms", STATS_COMPONENT_NAME[component],
+                static_cast<long long>(costMs));
+        }
+        {
+            std::lock_guard<std::mutex> lock(statsTaskMutex_);
+            statsTasks_.erase(std::make_pair(userId, component));
+        }
+        promise->set_value(ret);
+    });
+    return task;
+}
 
-    // mediaSize
-    err = GetMediaStorageStats(storageStats);
-    if (err != E_OK) {
-        LOGE("StorageStatusService::GetUserStorageStats getMedia failed");
-        RadarParameter parameterRes = {.orgPkg = DEFAULT_ORGPKGNAME,
-                                       .userId = userId,
-                                       .funcName = "GetMediaStorageStats",
-                                       .bizScene = BizScene::SPACE_STATISTICS,
-                                       .bizStage = BizStage::BIZ_STAGE_GET_USER_STORAGE_STATS,
-                                       .keyElxLevel = "EL1",
-                                       .errorCode = err};
-        StorageService::StorageRadar::GetInstance().RecordFuctionResult(parameterRes);
-        return err;
+int32_t StorageStatusService::RefreshUserStorageStats(int32_t userId, uint32_t staleMask, StorageStats &storageStats,
+    uint32_t &refreshedMask)
+{
+    // the backends are independent, a slow one must not delay the others nor block the caller forever
+    std::vector<std::pair<uint32_t, StatsComponentTask>> tasks;
+    auto startTime = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < STATS_COMPONENT_NUM; i++) {
+        if ((staleMask & (1U << i)) != 0) {
+            tasks.emplace_back(i, GetStatsComponentTask(userId, i));
+        }
     }
-    // fileSize
-    err = GetFileStorageStats(userId, storageStats);
-    if (err != E_OK) {
-        LOGE("StorageStatusService::GetUserStorageStats GetFileStorageStats failed");
-        RadarParameter parameterRes = {.orgPkg = DEFAULT_ORGPKGNAME,
-                                       .userId = userId,
-                                       .funcName = "GetFileStorageStats",
-                                       .bizScene = BizScene::SPACE_STATISTICS,
-                                       .bizStage = BizStage::BIZ_STAGE_GET_USER_STORAGE_STATS,
-                                       .keyElxLevel = "EL1",
-                                       .errorCode = err};
-        StorageService::StorageRadar::GetInstance().RecordFuctionResult(parameterRes);
+
+    int32_t err = E_OK;
+    for (auto &[component, task] : tasks) {
+        int32_t ret = E_TIMEOUT;
+        if (task.result.wait_until(startTime + STATS_COMPONENT_TIMEOUT[component]) == std::future_status::ready) {
+            ret = task.result.get();
+        } else {
+            LOGE("GetUserStorageStats %{public}s timeout", STATS_COMPONENT_NAME[component]);
+        }
+        if (ret != E_OK) {
+            RecordUserStorageStatsResult(userId, STATS_COMPONENT_NAME[component], ret);
+            err = (err == E_OK) ? ret : err;
+            continue;
+        }
+        StorageStatsCache::CopyComponent(component, *task.stats, storageStats);
+        refreshedMask |= 1U << component;
     }
     return err;
 }
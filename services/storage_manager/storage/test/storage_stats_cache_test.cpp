@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "storage/storage_stats_cache.h"
+
+namespace {
+using namespace std;
+using namespace OHOS;
+using namespace StorageManager;
+constexpr int32_t TEST_USER_ID = 100;
+constexpr int32_t TEST_OTHER_USER_ID = 101;
+constexpr int64_t TEST_TOTAL = 1000;
+constexpr int64_t TEST_APP = 200;
+constexpr int64_t TEST_IMAGE = 30;
+constexpr int64_t TEST_FILE = 40;
+
+class StorageStatsCacheTest : public testing::Test {
+public:
+    static void SetUpTestCase(void) {};
+    static void TearDownTestCase() {};
+    void SetUp()
+    {
+        DelayedSingleton<StorageStatsCache>::GetInstance()->InvalidateAll(STATS_ALL_MASK);
+    };
+    void TearDown() {};
+};
+
+void FillTestStats(StorageStats &stats)
+{
+    stats.total_ = TEST_TOTAL;
+    stats.app_ = TEST_APP;
+    stats.image_ = TEST_IMAGE;
+    stats.file_ = TEST_FILE;
+}
+
+/**
+ * @tc.number: SUB_STORAGE_Storage_stats_cache_Lookup_0000
+ * @tc.name: Storage_stats_cache_Lookup_0000
+ * @tc.desc: Test that a refreshed user is served from the cache.
+ * @tc.size: MEDIUM
+ * @tc.type: FUNC
+ * @tc.level Level 1
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(StorageStatsCacheTest, Storage_stats_cache_Lookup_0000, testing::ext::TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "StorageStatsCacheTest-begin Storage_stats_cache_Lookup_0000";
+    auto statsCache = DelayedSingleton<StorageStatsCache>::GetInstance();
+    StorageStats stats;
+    uint64_t epoch = 0;
+    EXPECT_EQ(statsCache->Lookup(TEST_USER_ID, stats, epoch), STATS_ALL_MASK);
+
+    StorageStats fresh;
+    FillTestStats(fresh);
+    statsCache->Update(TEST_USER_ID, STATS_ALL_MASK, fresh, epoch);
+
+    StorageStats cached;
+    EXPECT_EQ(statsCache->Lookup(TEST_USER_ID, cached, epoch), 0);
+    EXPECT_EQ(cached.total_, TEST_TOTAL);
+    EXPECT_EQ(cached.app_, TEST_APP);
+    EXPECT_EQ(cached.image_, TEST_IMAGE);
+    EXPECT_EQ(cached.file_, TEST_FILE);
+    EXPECT_EQ(statsCache->Lookup(TEST_OTHER_USER_ID, cached, epoch), STATS_ALL_MASK);
+    GTEST_LOG_(INFO) << "StorageStatsCacheTest-end Storage_stats_cache_Lookup_0000";
+}
+
+/**
+ * @tc.number: SUB_STORAGE_Storage_stats_cache_Invalidate_0000
+ * @tc.name: Storage_stats_cache_Invalidate_0000
+ * @tc.desc: Test that invalidation only marks the given components stale.
+ * @tc.size: MEDIUM
+ * @tc.type: FUNC
+ * @tc.level Level 1
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(StorageStatsCacheTest, Storage_stats_cache_Invalidate_0000, testing::ext::TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "StorageStatsCacheTest-begin Storage_stats_cache_Invalidate_0000";
+    auto statsCache = DelayedSingleton<StorageStatsCache>::GetInstance();
+    StorageStats stats;
+    uint64_t epoch = 0;
+    statsCache->Lookup(TEST_USER_ID, stats, epoch);
+    FillTestStats(stats);
+    statsCache->Update(TEST_USER_ID, STATS_ALL_MASK, stats, epoch);
+
+    statsCache->Invalidate(TEST_USER_ID, STATS_APP_MASK);
+    StorageStats cached;
+    EXPECT_EQ(statsCache->Lookup(TEST_USER_ID, cached, epoch), STATS_APP_MASK);
+    EXPECT_EQ(cached.total_, TEST_TOTAL);
+    EXPECT_EQ(cached.app_, 0);
+
+    statsCache->InvalidateAll(STATS_TOTAL_MASK | STATS_MEDIA_MASK);
+    EXPECT_EQ(statsCache->Lookup(TEST_USER_ID, cached, epoch), STATS_APP_MASK | STATS_TOTAL_MASK | STATS_MEDIA_MASK);
+    GTEST_LOG_(INFO) << "StorageStatsCacheTest-end Storage_stats_cache_Invalidate_0000";
+}
+
+/**
+ * @tc.number: SUB_STORAGE_Storage_stats_cache_Update_0000
+ * @tc.name: Storage_stats_cache_Update_0000
+ * @tc.desc: Test that only the components of the user invalidated during a refresh are dropped.
+ * @tc.size: MEDIUM
+ * @tc.type: FUNC
+ * @tc.level Level 1
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(StorageStatsCacheTest, Storage_stats_cache_Update_0000, testing::ext::TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "StorageStatsCacheTest-begin Storage_stats_cache_Update_0000";
+    auto statsCache = DelayedSingleton<StorageStatsCache>::GetInstance();
+    StorageStats stats;
+    uint64_t epoch = 0;
+    statsCache->Lookup(TEST_USER_ID, stats, epoch);
+    statsCache->Invalidate(TEST_OTHER_USER_ID, STATS_APP_MASK);
+    statsCache->Invalidate(TEST_USER_ID, STATS_MEDIA_MASK);
+    FillTestStats(stats);
+    statsCache->Update(TEST_USER_ID, STATS_ALL_MASK, stats, epoch);
+    EXPECT_EQ(statsCache->Lookup(TEST_USER_ID, stats, epoch), STATS_MEDIA_MASK);
+
+    statsCache->InvalidateAll(STATS_FILE_MASK);
+    statsCache->Update(TEST_USER_ID, STATS_MEDIA_MASK | STATS_FILE_MASK, stats, epoch);
+    EXPECT_EQ(statsCache->Lookup(TEST_USER_ID, stats, epoch), STATS_FILE_MASK);
+    statsCache->Update(TEST_USER_ID, STATS_FILE_MASK, stats, epoch);
+    EXPECT_EQ(statsCache->Lookup(TEST_USER_ID, stats, epoch), 0);
+    GTEST_LOG_(INFO) << "StorageStatsCacheTest-end Storage_stats_cache_Update_0000";
+}
+
+/**
+ * @tc.number: SUB_STORAGE_Storage_stats_cache_Update_0001
+ * @tc.name: Storage_stats_cache_Update_0001
+ * @tc.desc: Test that the file size of another user seeded from a batched query is served until it is invalidated.
+ * @tc.size: MEDIUM
+ * @tc.type: FUNC
+ * @tc.level Level 1
+ * @tc.require: AR000H09L6
+ */
+HWTEST_F(StorageStatsCacheTest, Storage_stats_cache_Update_0001, testing::ext::TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "StorageStatsCacheTest-begin Storage_stats_cache_Update_0001";
+    auto statsCache = DelayedSingleton<StorageStatsCache>::GetInstance();
+    uint64_t epoch = statsCache->GetEpoch();
+    StorageStats userStats;
+    userStats.file_ = TEST_FILE;
+    statsCache->Update(TEST_OTHER_USER_ID, STATS_FILE_MASK, userStats, epoch);
+
+    StorageStats cached;
+    EXPECT_EQ(statsCache->Lookup(TEST_OTHER_USER_ID, cached, epoch), STATS_ALL_MASK & ~STATS_FILE_MASK);
+    EXPECT_EQ(cached.file_, TEST_FILE);
+
+    uint64_t oldEpoch = statsCache->GetEpoch();
+    statsCache->Invalidate(TEST_OTHER_USER_ID, STATS_FILE_MASK);
+    statsCache->Update(TEST_OTHER_USER_ID, STATS_FILE_MASK, userStats, oldEpoch);
+    EXPECT_EQ(statsCache->Lookup(TEST_OTHER_USER_ID, cached, epoch), STATS_ALL_MASK);
+    GTEST_LOG_(INFO) << "StorageStatsCacheTest-end Storage_stats_cache_Update_0001";
+}
+} // namespace
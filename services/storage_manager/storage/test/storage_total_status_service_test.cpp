@@ -337,4 +337,94 @@ HWTEST_F(StorageTotalStatusServiceTest, Storage_status_GetLowerThreshold_0000, t
     EXPECT_EQ(result, E_OK);
     GTEST_LOG_(INFO) << "StorageTotalStatusServiceTest-end Storage_status_service_GetLowerThreshold_0000";
 }
+
+/**
+ * @tc.number: SUB_STORAGE_Storage_status_service_GetNextCheckInterval_0000
+ * @tc.name: Storage_status_service_GetNextCheckInterval_0000
+ * @tc.desc: Test that the next free space check follows the consumption rate.
+ * @tc.size: MEDIUM
+ * @tc.type: FUNC
+ * @tc.level Level 1
+ */
+HWTEST_F(StorageTotalStatusServiceTest, Storage_status_GetNextCheckInterval_0000, testing::ext::TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "StorageTotalStatusServiceTest-begin Storage_status_service_GetNextCheckInterval_0000";
+    std::shared_ptr<StorageMonitorService> service = DelayedSingleton<StorageMonitorService>::GetInstance();
+    ASSERT_TRUE(service != nullptr);
+    constexpr int64_t totalSize = 100LL * 1024 * 1024 * 1024;
+    constexpr int64_t freeSize = 10LL * 1024 * 1024 * 1024;
+    constexpr int64_t minInterval = 5 * 1000;
+    constexpr int64_t maxInterval = 5 * 60 * 1000;
+    service->totalSize_ = totalSize;
+    service->lastFreeSize_ = freeSize;
+    service->consumeRate_ = 0;
+    EXPECT_EQ(service->GetNextCheckInterval(), maxInterval);
+
+    service->consumeRate_ = static_cast<double>(freeSize);
+    EXPECT_EQ(service->GetNextCheckInterval(), minInterval);
+
+    service->consumeRate_ = static_cast<double>(freeSize) / 100;
+    int64_t interval = service->GetNextCheckInterval();
+    EXPECT_GT(interval, minInterval);
+    EXPECT_LT(interval, maxInterval);
+
+    service->lastFreeSize_ = 0;
+    EXPECT_EQ(service->GetNextCheckInterval(), 60 * 1000);
+    GTEST_LOG_(INFO) << "StorageTotalStatusServiceTest-end Storage_status_service_GetNextCheckInterval_0000";
+}
+
+/**
+ * @tc.number: SUB_STORAGE_Storage_status_service_GetReclaimSize_0000
+ * @tc.name: Storage_status_service_GetReclaimSize_0000
+ * @tc.desc: Test that the reclaim level and size follow the free space deficit.
+ * @tc.size: MEDIUM
+ * @tc.type: FUNC
+ * @tc.level Level 1
+ */
+HWTEST_F(StorageTotalStatusServiceTest, Storage_status_GetReclaimSize_0000, testing::ext::TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "StorageTotalStatusServiceTest-begin Storage_status_service_GetReclaimSize_0000";
+    std::shared_ptr<StorageMonitorService> service = DelayedSingleton<StorageMonitorService>::GetInstance();
+    ASSERT_TRUE(service != nullptr);
+    constexpr int64_t lowThreshold = 500LL * 1024 * 1024;
+    EXPECT_EQ(service->GetReclaimLevel(lowThreshold * 2, lowThreshold), RECLAIM_NONE);
+    EXPECT_EQ(service->GetReclaimLevel(lowThreshold + 1, lowThreshold), RECLAIM_SOFT);
+    EXPECT_EQ(service->GetReclaimLevel(lowThreshold - 1, lowThreshold), RECLAIM_HARD);
+    EXPECT_EQ(service->GetReclaimLevel(lowThreshold / 4, lowThreshold), RECLAIM_CRITICAL);
+
+    int64_t softSize = service->GetReclaimSize(RECLAIM_SOFT, lowThreshold * 3 / 2 - 1, lowThreshold);
+    EXPECT_EQ(softSize, 16LL * 1024 * 1024);
+    softSize = service->GetReclaimSize(RECLAIM_SOFT, lowThreshold, lowThreshold);
+    EXPECT_EQ(softSize, lowThreshold / 4);
+    int64_t hardSize = service->GetReclaimSize(RECLAIM_HARD, lowThreshold - 1, lowThreshold);
+    EXPECT_EQ(hardSize, lowThreshold / 2);
+    int64_t criticalSize = service->GetReclaimSize(RECLAIM_CRITICAL, 0, lowThreshold);
+    EXPECT_EQ(criticalSize, lowThreshold * 3 / 2);
+    EXPECT_EQ(service->GetReclaimSize(RECLAIM_NONE, 0, lowThreshold), 0);
+    GTEST_LOG_(INFO) << "StorageTotalStatusServiceTest-end Storage_status_service_GetReclaimSize_0000";
+}
+
+/**
+ * @tc.number: SUB_STORAGE_Storage_status_service_UpdateReclaimBackoff_0000
+ * @tc.name: Storage_status_service_UpdateReclaimBackoff_0000
+ * @tc.desc: Test that passes freeing nothing back off and a useful pass resets the backoff.
+ * @tc.size: MEDIUM
+ * @tc.type: FUNC
+ * @tc.level Level 1
+ */
+HWTEST_F(StorageTotalStatusServiceTest, Storage_status_UpdateReclaimBackoff_0000, testing::ext::TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "StorageTotalStatusServiceTest-begin Storage_status_service_UpdateReclaimBackoff_0000";
+    std::shared_ptr<StorageMonitorService> service = DelayedSingleton<StorageMonitorService>::GetInstance();
+    ASSERT_TRUE(service != nullptr);
+    service->UpdateReclaimBackoff(0);
+    service->UpdateReclaimBackoff(0);
+    EXPECT_EQ(service->reclaimFailCount_, 2);
+    EXPECT_GT(service->reclaimBackoffEnd_, std::chrono::steady_clock::now());
+
+    service->UpdateReclaimBackoff(100LL * 1024 * 1024);
+    EXPECT_EQ(service->reclaimFailCount_, 0);
+    EXPECT_LT(service->reclaimBackoffEnd_, std::chrono::steady_clock::now());
+    GTEST_LOG_(INFO) << "StorageTotalStatusServiceTest-end Storage_status_service_UpdateReclaimBackoff_0000";
+}
 } // namespace
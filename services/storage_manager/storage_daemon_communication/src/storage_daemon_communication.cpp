@@ -520,6 +520,21 @@ int32_t StorageDaemonCommunication::GetOccupiedSpace(int32_t idType, int32_t id,
     return storageDaemon_->GetOccupiedSpace(idType, id, size);
 }
 
+int32_t StorageDaemonCommunication::GetOccupiedSpaceBatch(int32_t idType, std::vector<int32_t> &ids,
+    std::vector<int64_t> &sizes)
+{
+    int32_t err = Connect();
+    if (err != E_OK) {
+        LOGE("Connect failed");
+        return err;
+    }
+    if (storageDaemon_ == nullptr) {
+        LOGE("StorageDaemonCommunication::Connect service nullptr");
+        return E_SERVICE_IS_NULLPTR;
+    }
+    return storageDaemon_->GetOccupiedSpaceBatch(idType, ids, sizes);
+}
+
 int32_t StorageDaemonCommunication::MountCryptoPathAgain(int32_t userId)
 {
     int32_t err = Connect();
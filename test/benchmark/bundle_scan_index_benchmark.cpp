@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "quota/bundle_scan_index.h"
+#include "utils/file_utils.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+namespace {
+const std::string BENCHMARK_ROOT = "/data/local/tmp/bundle_scan_index_benchmark/";
+const std::string BENCHMARK_INDEX = "/data/local/tmp/bundle_scan_index_benchmark_index";
+constexpr int32_t DIR_NUM = 1000;
+constexpr int32_t FILE_NUM = 50;
+constexpr mode_t MODE_0711 = 0711;
+constexpr mode_t MODE_0644 = 0644;
+// the index does not take listings changed within two seconds of the scan
+constexpr unsigned int RACY_WAIT_SEC = 3;
+
+const std::vector<std::string> &GetDirs()
+{
+    static std::vector<std::string> dirs = []() {
+        std::vector<std::string> list;
+        RmDirRecurse(BENCHMARK_ROOT);
+        for (int32_t i = 0; i < DIR_NUM; i++) {
+            std::string dir = BENCHMARK_ROOT + "dir" + std::to_string(i) + "/";
+            MkDirRecurse(dir, MODE_0711);
+            for (int32_t j = 0; j < FILE_NUM; j++) {
+                int fd = open((dir + "file" + std::to_string(j)).c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, MODE_0644);
+                if (fd >= 0) {
+                    (void)close(fd);
+                }
+            }
+            list.push_back(dir);
+        }
+        sleep(RACY_WAIT_SEC);
+        return list;
+    }();
+    return dirs;
+}
+
+// one scan of every directory, the listing comes from readdir unless the index has it
+size_t ScanDirs(BundleScanIndex *scanIndex)
+{
+    size_t entryNum = 0;
+    std::vector<ScanIndexEntry> entries;
+    for (const std::string &dir : GetDirs()) {
+        DIR *dirPtr = opendir(dir.c_str());
+        if (dirPtr == nullptr) {
+            continue;
+        }
+        struct stat dirStat = {0};
+        bool isStatOk = scanIndex != nullptr && fstat(dirfd(dirPtr), &dirStat) == 0;
+        const std::vector<ScanIndexEntry> *cachedEntries =
+            isStatOk ? scanIndex->FindEntries(dir, dirStat) : nullptr;
+        if (cachedEntries != nullptr) {
+            entryNum += cachedEntries->size();
+            (void)closedir(dirPtr);
+            continue;
+        }
+        entries.clear();
+        struct dirent *entry = nullptr;
+        while ((entry = readdir(dirPtr)) != nullptr) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            entries.push_back({entry->d_name, entry->d_type});
+        }
+        if (isStatOk) {
+            scanIndex->UpdateEntries(dir, dirStat, entries);
+        }
+        entryNum += entries.size();
+        (void)closedir(dirPtr);
+    }
+    return entryNum;
+}
+} // namespace
+
+static void BM_ScanWithoutIndex(benchmark::State &state)
+{
+    GetDirs();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ScanDirs(nullptr));
+    }
+    state.SetItemsProcessed(state.iterations() * DIR_NUM);
+}
+
+// first scan of a bundle: every listing misses and the whole index is written
+static void BM_ScanColdIndex(benchmark::State &state)
+{
+    GetDirs();
+    for (auto _ : state) {
+        (void)remove(BENCHMARK_INDEX.c_str());
+        BundleScanIndex scanIndex(BENCHMARK_INDEX);
+        scanIndex.Load();
+        benchmark::DoNotOptimize(ScanDirs(&scanIndex));
+        scanIndex.Save();
+    }
+    state.SetItemsProcessed(state.iterations() * DIR_NUM);
+}
+
+// unchanged bundle: every listing hits and the index is not rewritten
+static void BM_ScanWarmIndex(benchmark::State &state)
+{
+    GetDirs();
+    {
+        BundleScanIndex scanIndex(BENCHMARK_INDEX);
+        ScanDirs(&scanIndex);
+        scanIndex.Save();
+    }
+    for (auto _ : state) {
+        BundleScanIndex scanIndex(BENCHMARK_INDEX);
+        scanIndex.Load();
+        benchmark::DoNotOptimize(ScanDirs(&scanIndex));
+        scanIndex.Save();
+    }
+    state.SetItemsProcessed(state.iterations() * DIR_NUM);
+    (void)remove(BENCHMARK_INDEX.c_str());
+}
+
+BENCHMARK(BM_ScanWithoutIndex)->Unit(benchmark::kMillisecond)->Iterations(20);
+BENCHMARK(BM_ScanColdIndex)->Unit(benchmark::kMillisecond)->Iterations(20);
+BENCHMARK(BM_ScanWarmIndex)->Unit(benchmark::kMillisecond)->Iterations(20);
+} // STORAGE_DAEMON
+} // OHOS
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "storage_service_errno.h"
+#include "utils/dir_provisioner.h"
+#include "utils/file_utils.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+namespace {
+const std::string BENCHMARK_ROOT = "/data/local/tmp/dir_provisioner_benchmark";
+const std::vector<std::string> LEVELS = { "el1", "el2", "el3", "el4", "el5" };
+const std::vector<std::string> AREAS = { "app", "service", "chipset" };
+constexpr int32_t USER_ID = 100;
+constexpr int32_t SERVICE_DIR_NUM = 40;
+constexpr mode_t MODE_0711 = 0711;
+
+struct BenchmarkDir {
+    std::string path;
+    mode_t mode;
+};
+
+// roughly the dirs prepared when a user is created: the root and sub dirs of every level, hmdfs and services
+const std::vector<BenchmarkDir> &GetUserDirs()
+{
+    static std::vector<BenchmarkDir> dirs = []() {
+        std::vector<BenchmarkDir> list;
+        std::string user = std::to_string(USER_ID);
+        for (const auto &level : LEVELS) {
+            for (const auto &area : AREAS) {
+                list.push_back({BENCHMARK_ROOT + "/" + area + "/" + level + "/" + user, MODE_0711});
+            }
+            list.push_back({BENCHMARK_ROOT + "/app/" + level + "/" + user + "/base", MODE_0711});
+            list.push_back({BENCHMARK_ROOT + "/app/" + level + "/" + user + "/database", MODE_0711});
+        }
+        std::string hmdfs = BENCHMARK_ROOT + "/service/el2/" + user + "/hmdfs";
+        for (const auto &sub : { "", "/account", "/account/files", "/account/data", "/account/services",
+            "/non_account", "/non_account/files", "/non_account/data", "/cloud", "/cloud/data", "/cache",
+            "/cache/account_cache", "/cache/non_account_cache", "/cache/cloud_cache", "/cloudfile_manager" }) {
+            list.push_back({hmdfs + sub, MODE_0711});
+        }
+        for (int32_t i = 0; i < SERVICE_DIR_NUM; i++) {
+            list.push_back({BENCHMARK_ROOT + "/service/el2/" + user + "/service" + std::to_string(i), MODE_0711});
+        }
+        return list;
+    }();
+    return dirs;
+}
+
+void PrepareBenchmarkRoot()
+{
+    RmDirRecurse(BENCHMARK_ROOT);
+    for (const auto &area : AREAS) {
+        for (const auto &level : LEVELS) {
+            MkDirRecurse(BENCHMARK_ROOT + "/" + area + "/" + level, MODE_0711);
+        }
+    }
+}
+} // namespace
+
+static void BM_PrepareDirOneByOne(benchmark::State &state)
+{
+    const auto &dirs = GetUserDirs();
+    for (auto _ : state) {
+        state.PauseTiming();
+        PrepareBenchmarkRoot();
+        state.ResumeTiming();
+        for (const auto &dir : dirs) {
+            if (!PrepareDir(dir.path, dir.mode, getuid(), getgid())) {
+                state.SkipWithError("prepare dir failed");
+                break;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * dirs.size());
+    RmDirRecurse(BENCHMARK_ROOT);
+}
+
+static void BM_DirProvisioner(benchmark::State &state)
+{
+    const auto &dirs = GetUserDirs();
+    for (auto _ : state) {
+        state.PauseTiming();
+        PrepareBenchmarkRoot();
+        state.ResumeTiming();
+        DirProvisioner provisioner("benchmark");
+        for (const auto &dir : dirs) {
+            provisioner.Add(dir.path, dir.mode, getuid(), getgid());
+        }
+        if (provisioner.Run() != E_OK) {
+            state.SkipWithError("dir provisioner failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * dirs.size());
+    RmDirRecurse(BENCHMARK_ROOT);
+}
+
+BENCHMARK(BM_PrepareDirOneByOne)->Unit(benchmark::kMicrosecond)->Iterations(100);
+BENCHMARK(BM_DirProvisioner)->Unit(benchmark::kMicrosecond)->Iterations(100);
+} // STORAGE_DAEMON
+} // OHOS
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mtpfs_type_dir.h"
+
+namespace {
+constexpr uint32_t BASE_OBJECT_ID = 1000;
+constexpr uint32_t PARENT_ID = 1;
+constexpr uint32_t STORAGE_ID = 0x10001;
+constexpr time_t BASE_MTIME = 1700000000;
+
+std::string PhotoName(int64_t i)
+{
+    return "IMG_20240101_" + std::to_string(100000 + i) + ".jpg";
+}
+
+// the directory model used before the index: a set searched with std::find and returned by value
+class LegacyDir {
+public:
+    void AddFile(const MtpFsTypeFile &file)
+    {
+        files_.insert(file);
+    }
+    std::set<MtpFsTypeFile> Files() const
+    {
+        return files_;
+    }
+    const MtpFsTypeFile *File(const std::string &name) const
+    {
+        auto it = std::find(files_.begin(), files_.end(), name);
+        return it == files_.end() ? nullptr : &*it;
+    }
+
+private:
+    std::set<MtpFsTypeFile> files_;
+};
+
+template<typename Dir>
+void FillDir(Dir &dir, int64_t count)
+{
+    for (int64_t i = 0; i < count; i++) {
+        dir.AddFile(MtpFsTypeFile(BASE_OBJECT_ID + i, PARENT_ID, STORAGE_ID, PhotoName(i), i, BASE_MTIME + i));
+    }
+}
+} // namespace
+
+// ls -l: one readdir of the folder followed by a getattr lookup of every entry
+static void BM_LegacyListDir(benchmark::State &state)
+{
+    LegacyDir dir;
+    FillDir(dir, state.range(0));
+    for (auto _ : state) {
+        const std::set<MtpFsTypeFile> files = dir.Files();
+        for (const MtpFsTypeFile &f : files) {
+            benchmark::DoNotOptimize(dir.File(f.Name()));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_IndexedListDir(benchmark::State &state)
+{
+    MtpFsTypeDir dir(PARENT_ID, 0, STORAGE_ID, "DCIM");
+    FillDir(dir, state.range(0));
+    std::vector<std::string> names;
+    for (auto _ : state) {
+        // the getattr lookups come after readdir, not from inside its callback that holds the dir lock
+        names.clear();
+        dir.ForEachFile([&names](const MtpFsTypeFile &f) {
+            names.push_back(f.Name());
+        });
+        for (const std::string &name : names) {
+            benchmark::DoNotOptimize(dir.File(name));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_LegacyListDir)->Arg(1000)->Arg(10000)->Arg(50000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_IndexedListDir)->Arg(1000)->Arg(10000)->Arg(50000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "quota/stat_file_writer.h"
+
+namespace OHOS {
+namespace StorageDaemon {
+namespace {
+const std::string BENCHMARK_STAT_FILE = "/data/local/tmp/stat_file_writer_benchmark";
+const std::string SEPARATOR = ";";
+constexpr int64_t ENTRY_NUM = 1000000;
+constexpr int64_t BASE_MTIME = 1700000000;
+constexpr int32_t FILE_MODE = 33188;
+
+struct BenchmarkEntry {
+    std::string path;
+    int64_t size;
+    int64_t mtime;
+};
+
+const std::vector<BenchmarkEntry> &GetEntries()
+{
+    static std::vector<BenchmarkEntry> entries = []() {
+        std::vector<BenchmarkEntry> list;
+        list.reserve(ENTRY_NUM);
+        for (int64_t i = 0; i < ENTRY_NUM; i++) {
+            list.push_back({"/storage/Users/currentUser/Documents/dir" + std::to_string(i % 1000) + "/file" +
+                std::to_string(i), i * 7, BASE_MTIME + i});
+        }
+        return list;
+    }();
+    return entries;
+}
+
+// the writer used before StatFileWriter: string concatenation per line and a flush per line
+void LegacyWriteFileList(std::ofstream &statFile, const BenchmarkEntry &entry)
+{
+    std::string fileLine = entry.path + SEPARATOR;
+    fileLine += std::to_string(FILE_MODE) + SEPARATOR;
+    fileLine += std::to_string(0) + SEPARATOR;
+    fileLine += std::to_string(entry.size) + SEPARATOR;
+    fileLine += std::to_string(entry.mtime) + SEPARATOR;
+    fileLine += SEPARATOR;
+    fileLine += std::to_string(1);
+    fileLine += SEPARATOR;
+    fileLine += std::to_string(0);
+    statFile << fileLine << std::endl;
+}
+} // namespace
+
+static void BM_LegacyStatFileWriter(benchmark::State &state)
+{
+    const auto &entries = GetEntries();
+    for (auto _ : state) {
+        std::ofstream statFile(BENCHMARK_STAT_FILE, std::ios::out | std::ios::trunc);
+        for (const auto &entry : entries) {
+            LegacyWriteFileList(statFile, entry);
+        }
+        statFile.close();
+    }
+    state.SetItemsProcessed(state.iterations() * ENTRY_NUM);
+    (void)remove(BENCHMARK_STAT_FILE.c_str());
+}
+
+static void BM_StatFileWriter(benchmark::State &state)
+{
+    const auto &entries = GetEntries();
+    for (auto _ : state) {
+        StatFileWriter writer(BENCHMARK_STAT_FILE);
+        if (!writer.Open()) {
+            state.SkipWithError("open stat file failed");
+            break;
+        }
+        for (const auto &entry : entries) {
+            writer.WriteFileLine({.path = entry.path, .mode = FILE_MODE, .isDir = false, .size = entry.size,
+                                  .mtime = entry.mtime, .isIncre = true, .encodeFlag = false});
+        }
+        writer.Commit();
+    }
+    state.SetItemsProcessed(state.iterations() * ENTRY_NUM);
+    (void)remove(BENCHMARK_STAT_FILE.c_str());
+}
+
+BENCHMARK(BM_LegacyStatFileWriter)->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK(BM_StatFileWriter)->Unit(benchmark::kMillisecond)->Iterations(3);
+} // STORAGE_DAEMON
+} // OHOS